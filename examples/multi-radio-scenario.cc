@@ -314,6 +314,8 @@ int main (int argc, char *argv[])
   uint32_t busyStartTime=50;
   uint32_t busyDuration=10;
   uint32_t busyPeriod=50;
+  double adjacentCoupling1=0;
+  double adjacentCoupling2=0;
   uint32_t HelloInterval=20;
   uint64_t  TMax=1;
   uint32_t HelloExpireTime=20;
@@ -328,6 +330,7 @@ int main (int argc, char *argv[])
   uint32_t BroadcastSendDelay=1000;
   uint32_t  TInterfaceSendDelay=0;
   uint32_t SwitchingDelay=300;
+  int64_t streamIndex=-1;
   CommandLine cmd;
   double radioRange=250;
   const char* routingFile="rt-test";
@@ -347,6 +350,8 @@ int main (int argc, char *argv[])
   cmd.AddValue ("busyStartTime", "The starting time of interference(seconds)", busyStartTime);
   cmd.AddValue ("busyDuration", "The amount of interference(MilliSeconds)", busyDuration);
   cmd.AddValue ("busyPeriod", "The duration of busy channels (Seconds)", busyPeriod);
+  cmd.AddValue ("adjacentCoupling1", "fraction of the busy time of a channel seen on channel +-1", adjacentCoupling1);
+  cmd.AddValue ("adjacentCoupling2", "fraction of the busy time of a channel seen on channel +-2", adjacentCoupling2);
   cmd.AddValue ("range", "propagation range of nodes (m)", radioRange);
   // cmd.AddValue ("routing", "the input file for routing information",routingFile);
   cmd.AddValue ("HelloInterval", "Hello interval for CA(MilliSeconds)",HelloInterval);
@@ -363,6 +368,7 @@ int main (int argc, char *argv[])
   cmd.AddValue ("TInterfaceSendDelay", "delay T for Sica (MilliSeconds)",TInterfaceSendDelay);
   cmd.AddValue ("SwitchingDelay","The  switching delay of interfaces (MicroSeconds) ",SwitchingDelay);
    cmd.AddValue ("TMax", "TMax for Sica CA(MilliSeconds)",TMax);
+  cmd.AddValue ("streamIndex", "first random stream index for Sica and the channel emulators, negative keeps the default streams",streamIndex);
   
   cmd.Parse (argc, argv);
   // disable fragmentation for frames below 2200 bytes
@@ -407,6 +413,7 @@ int main (int argc, char *argv[])
     }
   ChannelEmuHelper emuHelper;
   emuHelper.Set("BusyDuration", TimeValue(MilliSeconds(0)));
+  emuHelper.SetAdjacentChannelCoupling(adjacentCoupling1,adjacentCoupling2);
   ChannelEmuContainer emuContainer= emuHelper.Install(channels);
   // UniformVariable emuRNG;
   Ptr<UniformRandomVariable> emuRNG = CreateObject<UniformRandomVariable> ();; // ns-3.25
@@ -515,6 +522,11 @@ ReadTrafficFile(&src,&dst,trafficFile);
  CA.Set("TMax",TimeValue(MilliSeconds(TMax)));
  /// Install SICA on nodes
  CAContainer=CA.Install(c ,emuContainer); 
+ if (streamIndex >= 0)
+   {
+     streamIndex+=emuContainer.AssignStreams(streamIndex);
+     CA.AssignStreams(CAContainer,streamIndex);
+   }
  for (uint32_t i=0; i<Max_Node ; i++)
    {
      chprobNode.push_back(i);
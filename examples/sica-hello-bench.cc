@@ -0,0 +1,69 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ */
+
+//
+// Microbenchmark of the serialization of the Sica hello messages. It builds one hello
+// with the given number of neighbors and serializes and deserializes it in the full and
+// in the compact format, then prints the size of the hello and the time per round trip.
+//
+// ./waf --run "sica-hello-bench --neighbors=32 --iterations=100000"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/sica-packet.h"
+#include <iostream>
+
+using namespace ns3;
+
+/// Serialize and deserialize the hello iterations times, return the elapsed time in milliseconds
+static int64_t
+RunBench (SicaHelloHeader hello, uint32_t iterations)
+{
+  SystemWallClockMs clock;
+  SicaHelloHeader received;
+  clock.Start ();
+  for (uint32_t k = 0; k < iterations; ++k)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      p->AddHeader (hello);
+      p->RemoveHeader (received);
+    }
+  return clock.End ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t neighbors = 32;
+  uint32_t iterations = 100000;
+
+  CommandLine cmd;
+  cmd.AddValue ("neighbors", "number of neighbors carried by the hello (at most 255)", neighbors);
+  cmd.AddValue ("iterations", "number of serialization round trips", iterations);
+  cmd.Parse (argc, argv);
+
+  SicaHelloHeader hello (1000, 7, Seconds (120), 2, 3, 512, 3, Mac48Address ("00:00:00:00:00:07"), MilliSeconds (0), MilliSeconds (250));
+  hello.SetExtBwConfidence (0.8);
+  hello.SetLoad (12);
+  hello.SetHelloInterval (Seconds (1));
+  for (uint32_t n = 0; n < std::min (neighbors, 255u); ++n)
+    hello.AddNiRChannel (10 + 3 * n, 1 + n % 12);
+
+  const char *names[2] = {"full", "compact"};
+  uint8_t formats[2] = {SicaHelloHeader::FULL_FORMAT, SicaHelloHeader::COMPACT_FORMAT};
+  for (uint32_t f = 0; f < 2; ++f)
+    {
+      hello.SetFormat (formats[f]);
+      int64_t elapsed = RunBench (hello, iterations);
+      std::cout << names[f] << ": " << hello.GetSerializedSize () << " bytes, "
+                << (iterations > 0 ? elapsed * 1e6 / iterations : 0) << " ns per round trip" << std::endl;
+    }
+  return 0;
+}
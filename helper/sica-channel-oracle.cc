@@ -0,0 +1,429 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-channel-oracle.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include <set>
+#include <algorithm>
+#ifdef SICA_ORACLE_THREADS
+#include "ns3/system-thread.h"
+#endif
+
+NS_LOG_COMPONENT_DEFINE ("SicaChannelOracle");
+
+namespace ns3 {
+
+/// Probability that a node is moved to a random channel at the start of a randomized search
+static const double ORACLE_PERTURBATION = 0.2;
+/// Probability of a random move during the local search, it helps to leave local minima
+static const double ORACLE_NOISE = 0.05;
+/// Smallest change of the objective considered as an improvement
+static const double ORACLE_EPSILON = 1e-12;
+
+SicaChannelOracle::SicaChannelOracle():
+  m_minCh(1),
+  m_chNo(8),
+  m_bw(11),
+  m_alpha(0.5),
+  m_restarts(8),
+  m_iterations(10000),
+  m_threads(4),
+  m_stream(-1),
+  m_prepared(false),
+  m_bestObjective(0)
+{
+}
+
+void
+SicaChannelOracle::SetSearchParameters(uint32_t restarts, uint32_t iterations, uint32_t threads)
+{
+  m_restarts=std::max(restarts,1u);
+  m_iterations=iterations;
+  m_threads=std::max(threads,1u);
+}
+
+void
+SicaChannelOracle::SetLossParameters(uint32_t minCh, uint32_t maxCh, double bw, double alpha)
+{
+  NS_ASSERT_MSG(maxCh >= minCh,"Empty channel range");
+  m_minCh=minCh;
+  m_chNo=maxCh-minCh+1;
+  m_bw=bw;
+  m_alpha=alpha;
+  m_prepared=false;
+}
+
+void
+SicaChannelOracle::Clear()
+{
+  m_node.clear();
+  m_index.clear();
+  m_best.clear();
+  m_bestObjective=0;
+  m_prepared=false;
+}
+
+void
+SicaChannelOracle::TakeSnapshot(SicaContainer sicas)
+{
+  Clear();
+  if (sicas.GetN() == 0)
+    return;
+  IntegerValue minCh, maxCh, bw;
+  DoubleValue alpha, oneHop, twoHop, path;
+  Ptr<Sica> first=sicas.Get(0);
+  first->GetAttribute("MinChannelNumber",minCh);
+  first->GetAttribute("MaxChannelNumber",maxCh);
+  first->GetAttribute("MaxChannelBW",bw);
+  first->GetAttribute("Alpha",alpha);
+  first->GetAttribute("OneHopConflictWeight",oneHop);
+  first->GetAttribute("TwoHopConflictWeight",twoHop);
+  first->GetAttribute("PathConflictWeight",path);
+  SetLossParameters(minCh.Get(),maxCh.Get(),bw.Get(),alpha.Get());
+  for (SicaContainer::Iterator i = sicas.Begin (); i != sicas.End (); ++i)
+    {
+      std::vector<double> bx;
+      for (uint32_t c=m_minCh; c<m_minCh+m_chNo; c++)
+        bx.push_back((*i)->GetSicaChannel()->GetChannelExtBandwidth(c));
+      // a switch already decided by the game is part of its assignment
+      AddNode((*i)->GetId(),(*i)->GetRNewChannel(),bx,(*i)->GetDataBacklog());
+    }
+  for (SicaContainer::Iterator i = sicas.Begin (); i != sicas.End (); ++i)
+    {
+      SicaNeighbors *nb=(*i)->GetSicaNeighbors();
+      std::set<uint32_t> pathNodes=(*i)->GetForwardingNeighbors();
+      for (uint32_t j = 1; j <= nb->GetNiNo(); j++)
+        {
+          uint32_t niId=static_cast<uint32_t>(nb->GetNeighborIdByIndex(j));
+          uint32_t hops=nb->GetNiHops(niId);
+          double w;
+          if (hops == 1)
+            w=oneHop.Get();
+          else if (hops == 2)
+            w=twoHop.Get();
+          else
+            continue;
+          if (pathNodes.find(niId) != pathNodes.end())
+            w*=path.Get();
+          AddConflict((*i)->GetId(),niId,w);
+        }
+    }
+  NS_LOG_DEBUG("Snapshot of "<< m_node.size() << " nodes over "<< m_chNo << " channels");
+}
+
+void
+SicaChannelOracle::AddNode(uint32_t id, uint32_t current, const std::vector<double> &bx, double traffic)
+{
+  NS_ASSERT_MSG(FindNode(id) < 0,"Node "<< id << " is already in the snapshot");
+  Node n;
+  n.m_id=id;
+  n.m_current=current;
+  n.m_bx=bx;
+  n.m_bx.resize(m_chNo,0);
+  n.m_traffic=traffic;
+  n.m_scale=1;
+  n.m_conflictWeight=0;
+  m_index.insert(std::make_pair(id,static_cast<uint32_t>(m_node.size())));
+  m_node.push_back(n);
+  m_prepared=false;
+}
+
+void
+SicaChannelOracle::AddConflict(uint32_t id, uint32_t niId, double weight)
+{
+  int n=FindNode(id);
+  int m=FindNode(niId);
+  if (n < 0 || m < 0 || n == m || weight <= 0)
+    return; // neighbors outside the snapshot are ignored
+  m_node[n].m_out.push_back(std::make_pair(static_cast<uint32_t>(m),weight));
+  m_node[m].m_in.push_back(std::make_pair(static_cast<uint32_t>(n),weight));
+  m_prepared=false;
+}
+
+int
+SicaChannelOracle::FindNode(uint32_t id) const
+{
+  std::map<uint32_t, uint32_t>::const_iterator i=m_index.find(id);
+  if (i == m_index.end())
+    return -1;
+  return (static_cast<int>(i->second));
+}
+
+void
+SicaChannelOracle::Prepare()
+{
+  double total=0;
+  for (std::vector<Node>::iterator i = m_node.begin (); i != m_node.end (); ++i)
+    total+=i->m_traffic;
+  for (std::vector<Node>::iterator i = m_node.begin (); i != m_node.end (); ++i)
+    {
+      // a node with the average backlog counts twice an idle node
+      i->m_scale= total > 0 ? 1+i->m_traffic*m_node.size()/total : 1;
+      i->m_conflictWeight=0;
+      for (uint32_t j=0; j<i->m_out.size(); j++)
+        i->m_conflictWeight+=i->m_out[j].second;
+    }
+  m_prepared=true;
+}
+
+double
+SicaChannelOracle::NodeLoss(uint32_t n, uint32_t c, const std::vector<int> &a) const
+{
+  const Node &node=m_node[n];
+  double loss= m_bw > 0 ? m_alpha*node.m_bx[c]/m_bw : 0;
+  if (node.m_conflictWeight > 0)
+    {
+      double shared=0;
+      for (uint32_t j=0; j<node.m_out.size(); j++)
+        if (a[node.m_out[j].first] == static_cast<int>(c))
+          shared+=node.m_out[j].second;
+      loss+=(1-m_alpha)*shared/node.m_conflictWeight;
+    }
+  return (node.m_scale*loss);
+}
+
+double
+SicaChannelOracle::MoveDelta(uint32_t n, uint32_t c, const std::vector<int> &a) const
+{
+  int from=a[n];
+  int to=static_cast<int>(c);
+  if (from == to)
+    return 0;
+  double delta=NodeLoss(n,c,a);
+  if (from >= 0)
+    delta-=NodeLoss(n,from,a);
+  // the node also changes the loss of the nodes which conflict with it
+  for (uint32_t j=0; j<m_node[n].m_in.size(); j++)
+    {
+      uint32_t k=m_node[n].m_in[j].first;
+      if (a[k] < 0 || m_node[k].m_conflictWeight <= 0)
+        continue;
+      double f=m_node[k].m_scale*(1-m_alpha)*m_node[n].m_in[j].second/m_node[k].m_conflictWeight;
+      if (a[k] == to)
+        delta+=f;
+      else if (a[k] == from)
+        delta-=f;
+    }
+  return delta;
+}
+
+double
+SicaChannelOracle::Objective(const std::vector<int> &a) const
+{
+  double obj=0;
+  for (uint32_t n=0; n<m_node.size(); n++)
+    if (a[n] >= 0)
+      obj+=NodeLoss(n,a[n],a);
+  return obj;
+}
+
+std::vector<uint32_t>
+SicaChannelOracle::Dsatur() const
+{
+  uint32_t size=m_node.size();
+  std::vector<int> a(size,-1);
+  for (uint32_t step=0; step<size; step++)
+    {
+      // the uncolored node with the most distinct channels around it, then the biggest degree
+      int sel=-1;
+      uint32_t selSat=0;
+      uint32_t selDeg=0;
+      for (uint32_t n=0; n<size; n++)
+        {
+          if (a[n] >= 0)
+            continue;
+          std::set<int> sat;
+          for (uint32_t j=0; j<m_node[n].m_out.size(); j++)
+            if (a[m_node[n].m_out[j].first] >= 0)
+              sat.insert(a[m_node[n].m_out[j].first]);
+          for (uint32_t j=0; j<m_node[n].m_in.size(); j++)
+            if (a[m_node[n].m_in[j].first] >= 0)
+              sat.insert(a[m_node[n].m_in[j].first]);
+          uint32_t deg=m_node[n].m_out.size()+m_node[n].m_in.size();
+          if (sel < 0 || sat.size() > selSat || (sat.size() == selSat && deg > selDeg))
+            {
+              sel=n;
+              selSat=sat.size();
+              selDeg=deg;
+            }
+        }
+      uint32_t best=0;
+      double bestDelta=0;
+      for (uint32_t c=0; c<m_chNo; c++)
+        {
+          double delta=MoveDelta(sel,c,a);
+          if (c == 0 || delta < bestDelta-ORACLE_EPSILON)
+            {
+              best=c;
+              bestDelta=delta;
+            }
+        }
+      a[sel]=best;
+    }
+  return (std::vector<uint32_t>(a.begin(),a.end()));
+}
+
+void
+SicaChannelOracle::RunSearchTask(SearchTask *task)
+{
+  task->m_oracle->Search(*task);
+}
+
+void
+SicaChannelOracle::Search(SearchTask &task) const
+{
+  uint32_t size=m_node.size();
+  std::vector<uint32_t> start=Dsatur();
+  std::vector<int> a(start.begin(),start.end());
+  if (task.m_perturb)
+    {
+      for (uint32_t n=0; n<size; n++)
+        if (task.m_random->GetValue() < ORACLE_PERTURBATION)
+          a[n]=task.m_random->GetInteger(0,m_chNo-1);
+    }
+  double obj=Objective(a);
+  std::vector<int> best=a;
+  double bestObj=obj;
+  for (uint32_t it=0; it<m_iterations && size>0; it++)
+    {
+      uint32_t n=task.m_random->GetInteger(0,size-1);
+      uint32_t c;
+      double delta;
+      if (task.m_random->GetValue() < ORACLE_NOISE)
+        {
+          c=task.m_random->GetInteger(0,m_chNo-1);
+          delta=MoveDelta(n,c,a);
+        }
+      else
+        {
+          // min-conflicts move, the best channel for the node
+          c=a[n];
+          delta=0;
+          for (uint32_t k=0; k<m_chNo; k++)
+            {
+              double d=MoveDelta(n,k,a);
+              if (d < delta-ORACLE_EPSILON)
+                {
+                  c=k;
+                  delta=d;
+                }
+            }
+        }
+      if (static_cast<int>(c) == a[n])
+        continue;
+      a[n]=c;
+      obj+=delta;
+      if (obj < bestObj-ORACLE_EPSILON)
+        {
+          best=a;
+          bestObj=obj;
+        }
+    }
+  task.m_assignment.assign(best.begin(),best.end());
+  // recompute to avoid the accumulation of rounding errors
+  task.m_objective=Objective(best);
+}
+
+double
+SicaChannelOracle::Solve()
+{
+  Prepare();
+  m_best.clear();
+  m_bestObjective=0;
+  if (m_node.empty())
+    return 0;
+  std::vector<Ptr<UniformRandomVariable> > random;
+  std::vector<SearchTask> tasks(m_restarts);
+  for (uint32_t r=0; r<m_restarts; r++)
+    {
+      random.push_back(CreateObject<UniformRandomVariable> ());
+      if (m_stream >= 0)
+        random[r]->SetStream(m_stream+r);
+      tasks[r].m_oracle=this;
+      tasks[r].m_random=PeekPointer(random[r]);
+      tasks[r].m_perturb=(r > 0);
+      tasks[r].m_objective=0;
+    }
+#ifdef SICA_ORACLE_THREADS
+  for (uint32_t r=0; r<m_restarts; r+=m_threads)
+    {
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t t=r; t<std::min(r+m_threads,m_restarts); t++)
+        {
+          threads.push_back(Create<SystemThread> (MakeBoundCallback(&SicaChannelOracle::RunSearchTask,&tasks[t])));
+          threads.back()->Start();
+        }
+      for (uint32_t t=0; t<threads.size(); t++)
+        threads[t]->Join();
+    }
+#else
+  for (uint32_t r=0; r<m_restarts; r++)
+    RunSearchTask(&tasks[r]);
+#endif
+  uint32_t bestTask=0;
+  for (uint32_t r=1; r<m_restarts; r++)
+    if (tasks[r].m_objective < tasks[bestTask].m_objective-ORACLE_EPSILON)
+      bestTask=r;
+  m_best=tasks[bestTask].m_assignment;
+  m_bestObjective=tasks[bestTask].m_objective;
+  NS_LOG_DEBUG("Oracle objective "<< m_bestObjective << " found by search "<< bestTask << ", game objective "<< GetGameObjective());
+  return m_bestObjective;
+}
+
+double
+SicaChannelOracle::GetGameObjective()
+{
+  if (!m_prepared)
+    Prepare();
+  std::vector<int> a(m_node.size(),-1);
+  for (uint32_t n=0; n<m_node.size(); n++)
+    if (m_node[n].m_current >= m_minCh && m_node[n].m_current < m_minCh+m_chNo)
+      a[n]=m_node[n].m_current-m_minCh;
+  return Objective(a);
+}
+
+double
+SicaChannelOracle::GetGap()
+{
+  double game=GetGameObjective();
+  if (game <= 0)
+    return 0;
+  return ((game-m_bestObjective)/game);
+}
+
+uint32_t
+SicaChannelOracle::GetChannel(uint32_t id) const
+{
+  int n=FindNode(id);
+  if (n < 0 || m_best.empty())
+    return 0;
+  return (m_best[n]+m_minCh);
+}
+
+uint32_t
+SicaChannelOracle::Apply(SicaContainer sicas, bool warmStart)
+{
+  uint32_t switched=0;
+  for (SicaContainer::Iterator i = sicas.Begin (); i != sicas.End (); ++i)
+    {
+      uint32_t ch=GetChannel((*i)->GetId());
+      if (ch == 0)
+        continue;
+      if (ch != (*i)->GetRChannel())
+        switched++;
+      (*i)->ForceRChannel(ch,warmStart);
+    }
+  NS_LOG_DEBUG("Oracle assignment applied, "<< switched << " nodes switch");
+  return switched;
+}
+
+}/*namespace ns3 */
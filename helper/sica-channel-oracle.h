@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICACHANNELORACLE_H
+#define SICACHANNELORACLE_H
+
+#include <vector>
+#include <map>
+#include "ns3/sica-helper.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sicahelper
+ * \defgroup channeloracle SicaChannelOracle
+ */
+
+/**
+ * \brief Centralized channel assignment used as a benchmark of the distributed game.
+ *
+ * The oracle takes a snapshot of a set of Sica agents (neighbor tables, external bandwidth of the
+ * channels, routes and data backlog) and searches the R channel assignment which minimizes the
+ * aggregate loss of the nodes. The loss of a node on a channel has the form of the game loss:
+ * alpha*bx/b plus (1-alpha) times the weighted share of its 1-hop and 2-hop neighbors tuned to the
+ * same channel, the neighbors on its forwarding paths counting more, and it is scaled by the share
+ * of the traffic of the node. The search starts from a DSATUR coloring and improves it with a
+ * min-conflicts local search, several randomized restarts run in parallel threads when the
+ * simulator is built with threading support. The best assignment can be applied to the running
+ * simulation and compared with the assignment of the game.
+ */
+class SicaChannelOracle
+{
+public:
+  /// c-tor
+  SicaChannelOracle();
+  /**
+   *\brief Set the parameters of the search
+   *\param restarts number of randomized local searches, the first one starts from the DSATUR coloring
+   *\param iterations number of moves of each local search
+   *\param threads maximum number of local searches run in parallel
+   */
+  void SetSearchParameters(uint32_t restarts, uint32_t iterations, uint32_t threads);
+  /**
+   *\brief Set the stream of the random variables of the restarts
+   *\param stream first stream index, one stream is used by each restart
+   */
+  void SetStream(int64_t stream){m_stream=stream;}
+  /**
+   *\brief Copy the state of the Sica agents, the weights of the loss are read from the attributes of the first agent
+   *\param sicas the agents of the mesh
+   */
+  void TakeSnapshot(SicaContainer sicas);
+  /**
+   *\brief Add one node to the snapshot, mainly for tests
+   *\param id the Id of the node
+   *\param current the current R channel of the node
+   *\param bx the external bandwidth of the channels seen by the node, bx[c-minCh] is the bandwidth of channel c
+   *\param traffic the data backlog of the node
+   */
+  void AddNode(uint32_t id, uint32_t current, const std::vector<double> &bx, double traffic);
+  /**
+   *\brief Add a conflict of one node with a neighbor to the snapshot
+   *\param id the Id of the node
+   *\param niId the Id of the neighbor
+   *\param weight the weight of the conflict
+   */
+  void AddConflict(uint32_t id, uint32_t niId, double weight);
+  /**
+   *\brief Set the loss parameters used with AddNode
+   *\param minCh the first channel
+   *\param maxCh the last channel
+   *\param bw the bandwidth of a channel
+   *\param alpha weight of the external bandwidth in the loss
+   */
+  void SetLossParameters(uint32_t minCh, uint32_t maxCh, double bw, double alpha);
+  /**
+   *\brief Search the best assignment of the snapshot
+   *\return the aggregate loss of the best assignment
+   */
+  double Solve();
+  /// Return the aggregate loss of the assignment of the game in the snapshot
+  double GetGameObjective();
+  /// Return the aggregate loss of the best assignment found by SicaChannelOracle::Solve
+  double GetOracleObjective() const {return m_bestObjective;}
+  /// Return the relative gap between the game and the oracle, (game-oracle)/game, 0 if the game has no loss
+  double GetGap();
+  /**
+   *\brief Return the channel of a node in the best assignment, 0 if the node is unknown or SicaChannelOracle::Solve was not called
+   *\param id the Id of the node
+   */
+  uint32_t GetChannel(uint32_t id) const;
+  /**
+   *\brief Force the best assignment on the agents through Sica::ForceRChannel
+   *\param sicas the agents of the mesh
+   *\param warmStart if true the game of each agent starts from the forced channel
+   *\return the number of agents which switch
+   */
+  uint32_t Apply(SicaContainer sicas, bool warmStart);
+  /// Forget the snapshot and the result
+  void Clear();
+private:
+  /// A node of the snapshot
+  struct Node
+  {
+    uint32_t m_id;///< Id of the node
+    uint32_t m_current;///< Channel of the node in the game
+    std::vector<double> m_bx;///< External bandwidth of the channels seen by the node
+    double m_traffic;///< Data backlog of the node
+    double m_scale;///< Share of the node in the aggregate loss
+    double m_conflictWeight;///< Sum of the weights of the conflicts of the node
+    std::vector<std::pair<uint32_t, double> > m_out;///< Conflicts of the node (index of the neighbor, weight)
+    std::vector<std::pair<uint32_t, double> > m_in;///< Nodes which have a conflict with this node (index, weight)
+  };
+  /// One local search
+  struct SearchTask
+  {
+    const SicaChannelOracle *m_oracle;///< The oracle which owns the snapshot
+    UniformRandomVariable *m_random;///< The random variable of the search
+    bool m_perturb;///< Randomize the starting point
+    std::vector<uint32_t> m_assignment;///< The best assignment of the search, channel indexes
+    double m_objective;///< The aggregate loss of the best assignment
+  };
+  /// Run a local search, the entry point of the threads
+  static void RunSearchTask(SearchTask *task);
+  /// Run a local search on the snapshot, it only reads the snapshot
+  void Search(SearchTask &task) const;
+  /// Compute the scale and conflict weight of the nodes
+  void Prepare();
+  /// Return the index of a node of the snapshot, -1 if unknown
+  int FindNode(uint32_t id) const;
+  /// Return the DSATUR coloring of the snapshot
+  std::vector<uint32_t> Dsatur() const;
+  /// Return the loss of node n on channel index c for the assignment a, channel index -1 means unassigned
+  double NodeLoss(uint32_t n, uint32_t c, const std::vector<int> &a) const;
+  /// Return the change of the aggregate loss when node n moves to channel index c
+  double MoveDelta(uint32_t n, uint32_t c, const std::vector<int> &a) const;
+  /// Return the aggregate loss of an assignment
+  double Objective(const std::vector<int> &a) const;
+  uint32_t m_minCh;///< first channel
+  uint32_t m_chNo;///< number of channels
+  double m_bw;///< bandwidth of a channel
+  double m_alpha;///< weight of the external bandwidth in the loss
+  uint32_t m_restarts;///< number of local searches
+  uint32_t m_iterations;///< number of moves of a local search
+  uint32_t m_threads;///< number of parallel searches
+  int64_t m_stream;///< first random stream of the searches
+  bool m_prepared;///< the scale and conflict weights are computed
+  std::vector<Node> m_node;///< the snapshot
+  std::map<uint32_t, uint32_t> m_index;///< index of the nodes by Id
+  std::vector<uint32_t> m_best;///< best assignment, channel indexes
+  double m_bestObjective;///< aggregate loss of the best assignment
+};/*SicaChannelOracle*/
+
+}/*namespace ns3 */
+
+#endif /* SICACHANNELORACLE_H */
@@ -83,6 +83,29 @@ SicaHelper::Install (NodeContainer c,ChannelEmuContainer channelsEmu ) const
  return sicas;
 }
 
+int64_t
+SicaHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<Sica> sica = (*i)->GetObject<Sica> ();
+      NS_ASSERT_MSG (sica, "Sica is not installed on node " << (*i)->GetId ());
+      currentStream += sica->AssignStreams (currentStream);
+    }
+  return (currentStream - stream);
+}
+
+int64_t
+SicaHelper::AssignStreams (SicaContainer sicas, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (SicaContainer::Iterator i = sicas.Begin (); i != sicas.End (); ++i)
+    {
+      currentStream += (*i)->AssignStreams (currentStream);
+    }
+  return (currentStream - stream);
+}
 
 }/*namespace ns3 */
 
@@ -95,6 +95,22 @@ public:
    */
 
   SicaContainer  Install (NodeContainer c,ChannelEmuContainer channelsEmu ) const;
+  /**
+   * \brief Assign a fixed random variable stream number to the random variables used by the Sica objects of the given nodes, the draws of each node are then reproducible across runs
+   *
+   * \param c NodeContainer of the nodes on which Sica is installed
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (NodeContainer c, int64_t stream);
+  /**
+   * \brief Assign a fixed random variable stream number to the random variables used by the Sica objects of the container
+   *
+   * \param sicas the Sica objects
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (SicaContainer sicas, int64_t stream);
 private:
   ObjectFactory m_agentFactory;
 };/*Sica Helper */
@@ -6,6 +6,7 @@
 
 #include "ns3/channel-emulation.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("SicaEmuChannel");
 
@@ -74,6 +75,13 @@ ChannelEmu::~ChannelEmu()
 {
 }
 
+int64_t 
+ChannelEmu::AssignStreams (int64_t stream)
+{
+  m_nextTime->SetStream (stream);
+  return 1;
+}
+
 
 void 
 ChannelEmu::ChangeStatus()
@@ -96,6 +104,48 @@ ChannelEmu::ChangeStatus()
 
 
 
+AdjacentChannelMatrix::AdjacentChannelMatrix()
+{
+}
+
+void 
+AdjacentChannelMatrix::SetCoupling(uint32_t distance, double coupling)
+{
+  if (distance==0)
+    return;
+  if (m_coupling.size()<= distance)
+    m_coupling.resize(distance+1,0);
+  m_coupling[0]=1;
+  m_coupling[distance]=std::min(std::max(coupling,0.0),1.0);
+}
+
+double 
+AdjacentChannelMatrix::GetCoupling(uint32_t c1, uint32_t c2) const
+{
+  uint32_t distance= (c1 > c2) ? c1-c2 : c2-c1;
+  if (distance==0)
+    return 1;
+  if (distance < m_coupling.size())
+    return m_coupling[distance];
+  return 0;
+}
+
+uint32_t 
+AdjacentChannelMatrix::GetMaxDistance() const
+{
+  for (uint32_t d=m_coupling.size(); d>1; d--)
+    if (m_coupling[d-1]>0)
+      return d-1;
+  return 0;
+}
+
+bool 
+AdjacentChannelMatrix::IsOrthogonal() const
+{
+  return (GetMaxDistance()==0);
+}
+
+
 ChannelEmuContainer:: ChannelEmuContainer()
 {
 }
@@ -140,6 +190,25 @@ ChannelEmuContainer::Add (Ptr<ChannelEmu> c)
   m_channelEmuAgents.push_back(c);
 }
 
+int64_t 
+ChannelEmuContainer::AssignStreams (int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (std::vector<Ptr<ChannelEmu> >::const_iterator i=m_channelEmuAgents.begin(); i != m_channelEmuAgents.end(); ++i )
+    currentStream += (*i)->AssignStreams (currentStream);
+  return (currentStream - stream);
+}
+
+double 
+ChannelEmuContainer::GetBusyFraction (uint32_t chId) const
+{
+  double busy=0;
+  for (std::vector<Ptr<ChannelEmu> >::const_iterator i=m_channelEmuAgents.begin(); i != m_channelEmuAgents.end(); ++i )
+    if ((*i)->IsBusy())
+      busy+=m_adjacentMatrix.GetCoupling(chId,(*i)->GetChannelNumber());
+  return std::min(busy,1.0);
+}
+
 
 ChannelEmuHelper::ChannelEmuHelper()
 {
@@ -160,10 +229,18 @@ ChannelEmuHelper::Set (std::string name, const AttributeValue &value)
    m_agentFactory.Set(name,value);
  }
 
+void 
+ChannelEmuHelper::SetAdjacentChannelCoupling (double c1, double c2)
+{
+  m_adjacentMatrix.SetCoupling(1,c1);
+  m_adjacentMatrix.SetCoupling(2,c2);
+}
+
 ChannelEmuContainer  
 ChannelEmuHelper::Install (std::vector<uint32_t> channels) const
 {
   ChannelEmuContainer emuContainer;
+  emuContainer.SetAdjacentChannelMatrix(m_adjacentMatrix);
   for (std::vector<uint32_t >::const_iterator i=channels.begin(); i != channels.end(); ++i )
     {
     emuContainer.Add (Create(*i));
@@ -64,6 +64,12 @@ class ChannelEmu : public Object
    *  \brief Makes it possible for user to change emulation parameters through calling SetAttribute
    */
  static TypeId GetTypeId (void);
+  /**
+   * \brief Assign a fixed random variable stream number to the random variables used by this object
+   *\param stream first stream index to use
+   *\return the number of stream indices assigned by this object
+   */
+  int64_t AssignStreams (int64_t stream);
   /**
   *  \brief set the channel number  for which this emulator works
   */
@@ -110,6 +116,41 @@ private:
   Timer m_stausTimer; ///< Timer to change the status of the channel
 };
 
+/**
+ * \brief Adjacent channel interference matrix used by the channel emulation layer.
+ *
+ * Channels Min_CH..Max_CH are mapped straight to WifiPhy channel numbers, so on a
+ * partially overlapping plan (2.4 GHz) the busy time of channel c leaks into its
+ * neighbours. The coupling only depends on the distance |c-c'| between two channels,
+ * entry 0 is always 1 (a channel fully sees its own busy time). An empty matrix
+ * means fully orthogonal channels.
+ */
+class AdjacentChannelMatrix
+{
+public:
+  ///c-tor, orthogonal channels
+  AdjacentChannelMatrix();
+  /**
+   *\brief Set the coupling between two channels which are distance channels apart
+   *\param distance the distance between two channel ids (1 for c+-1, 2 for c+-2 ...)
+   *\param coupling the fraction of busy time which leaks between the channels [0,1]
+   */
+  void SetCoupling(uint32_t distance, double coupling);
+  /**
+   *\brief Return the coupling between two channels
+   *\param c1 the id of the first channel
+   *\param c2 the id of the second channel
+   */
+  double GetCoupling(uint32_t c1, uint32_t c2) const;
+  /// Return the largest distance with a non zero coupling
+  uint32_t GetMaxDistance() const;
+  /// Return true if there is no leakage between channels
+  bool IsOrthogonal() const;
+private:
+  /// coupling indexed by the distance between two channels
+  std::vector<double> m_coupling;
+};
+
   /// Container which holds channel emulators
 
 class ChannelEmuContainer
@@ -142,9 +183,29 @@ Ptr<ChannelEmu> GetId (uint32_t chId) const;
    *\param c The pointer to the channel emulator object 
    */
 void Add (Ptr<ChannelEmu> c);
+  /**
+   *\brief Set the adjacent channel interference matrix shared by the emulators in the container
+   *\param m the adjacent channel matrix
+   */
+void SetAdjacentChannelMatrix (AdjacentChannelMatrix m){m_adjacentMatrix=m;}
+  /// Return the adjacent channel interference matrix
+const AdjacentChannelMatrix & GetAdjacentChannelMatrix (void) const {return m_adjacentMatrix;}
+  /**
+   *\brief Return the busy fraction seen on a channel, the own emulator state plus the leakage of busy adjacent channels, bounded to 1
+   *\param chId the channel id
+   */
+double GetBusyFraction (uint32_t chId) const;
+  /**
+   *\brief Assign fixed random variable stream numbers to the emulators in the container
+   *\param stream first stream index to use
+   *\return the number of stream indices assigned
+   */
+int64_t AssignStreams (int64_t stream);
 private:
   /// vector of channel eumator objects
 std::vector<Ptr<ChannelEmu> > m_channelEmuAgents;
+  /// leakage between adjacent channels
+AdjacentChannelMatrix m_adjacentMatrix;
 
 };
 
@@ -176,6 +237,14 @@ public:
 
   void Set (std::string name, const AttributeValue &value);
 
+  /**
+   * \param c1 the fraction of busy time of channel c seen on c+-1
+   * \param c2 the fraction of busy time of channel c seen on c+-2
+   *
+   * Configure the adjacent channel leakage of the installed emulators, both zero means orthogonal channels
+   */
+  void SetAdjacentChannelCoupling (double c1, double c2);
+
    /**
    * For each channel in the input container,implements 
    * ns3::ChannelEmu  
@@ -187,6 +256,7 @@ public:
 private:
 
   ObjectFactory m_agentFactory;
+  AdjacentChannelMatrix m_adjacentMatrix;
 };/* ChannelEmu Helper */
 
 
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-bx-estimator.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("SicaBxEstimator");
+
+namespace ns3 {
+
+const uint32_t SicaBxEstimator::FRACTION_BITS;
+
+/// Maximum effective number of samples, it keeps the confidence responsive to the age of the information
+static const double MAX_BX_SAMPLES = 8;
+
+SicaBxEstimator::SicaBxEstimator():
+  m_mode(EWMA_MODE),
+  m_ewmaWeight(64),
+  m_windowSize(4),
+  m_neighborWeight(0.3),
+  m_estimate(0),
+  m_windowHead(0),
+  m_windowSum(0),
+  m_samples(0),
+  m_lifetime(Seconds(0)),
+  m_lastLocal(Seconds(0)),
+  m_lastUpdate(Seconds(0)),
+  m_expireTime(Seconds(0))
+{
+}
+
+void
+SicaBxEstimator::SetParameters(Mode mode, double ewmaWeight, uint32_t windowSize, double neighborWeight)
+{
+  m_mode=mode;
+  m_ewmaWeight=std::min(std::max(static_cast<uint32_t>(ewmaWeight*(1 << FRACTION_BITS)+0.5),1u),1u << FRACTION_BITS);
+  m_windowSize=std::max(windowSize,1u);
+  m_neighborWeight=std::min(std::max(neighborWeight,0.0),1.0);
+  Reset();
+}
+
+uint32_t
+SicaBxEstimator::ToFixed(double bx)
+{
+  if (bx <= 0)
+    return 0;
+  return (static_cast<uint32_t>(bx*(1 << FRACTION_BITS)+0.5));
+}
+
+void
+SicaBxEstimator::PushSample(uint32_t sample)
+{
+  if (m_mode == WINDOW_MODE)
+    {
+      if (m_window.size() < m_windowSize)
+        m_window.push_back(sample);
+      else
+        {
+          m_windowSum-=m_window[m_windowHead];
+          m_window[m_windowHead]=sample;
+          m_windowHead=(m_windowHead+1)%m_windowSize;
+        }
+      m_windowSum+=sample;
+      m_estimate=static_cast<uint32_t>((m_windowSum+m_window.size()/2)/m_window.size());
+    }
+  else if (m_samples <= 0)
+    m_estimate=sample;
+  else
+    {
+      int64_t delta=static_cast<int64_t>(sample)-static_cast<int64_t>(m_estimate);
+      m_estimate=static_cast<uint32_t>(static_cast<int64_t>(m_estimate)+delta*m_ewmaWeight/(1 << FRACTION_BITS));
+    }
+}
+
+void
+SicaBxEstimator::Refresh(Time expire)
+{
+  m_lifetime=expire;
+  m_lastUpdate=Simulator::Now();
+  m_expireTime=std::max(expire+Simulator::Now(),m_expireTime);
+}
+
+void
+SicaBxEstimator::AddLocalSample(double bx, Time expire)
+{
+  CheckExpire();
+  PushSample(ToFixed(bx));
+  m_samples=std::min(m_samples+1,MAX_BX_SAMPLES);
+  m_lastLocal=Simulator::Now();
+  Refresh(expire);
+  NS_LOG_DEBUG("Local bx sample "<< bx << " estimate is "<< FromFixed(m_estimate));
+}
+
+void
+SicaBxEstimator::MergeNeighborReport(double bx, double confidence, Time expire)
+{
+  if (confidence <= 0)
+    return; // the neighbor has no information about the channel
+  CheckExpire();
+  // the less we trust our own estimate the more we follow the neighbor
+  double w=std::min(confidence,1.0)*(m_neighborWeight+(1-m_neighborWeight)*(1-GetConfidence()));
+  uint32_t report=ToFixed(bx);
+  if (m_samples <= 0)
+    m_estimate=report;
+  else
+    {
+      // in window mode the window only holds local samples, the report shifts the estimate until the next local sample
+      int64_t delta=static_cast<int64_t>(report)-static_cast<int64_t>(m_estimate);
+      m_estimate=static_cast<uint32_t>(static_cast<int64_t>(m_estimate)+static_cast<int64_t>(delta*w));
+    }
+  m_samples=std::min(m_samples+w,MAX_BX_SAMPLES);
+  Refresh(expire);
+  NS_LOG_DEBUG("Neighbor bx report "<< bx << " merged with weight "<< w << " estimate is "<< FromFixed(m_estimate));
+}
+
+double
+SicaBxEstimator::GetEstimate()
+{
+  CheckExpire();
+  return FromFixed(m_estimate);
+}
+
+uint32_t
+SicaBxEstimator::GetFixedEstimate()
+{
+  CheckExpire();
+  return m_estimate;
+}
+
+double
+SicaBxEstimator::GetConfidence()
+{
+  CheckExpire();
+  if (m_samples <= 0 || !m_lifetime.IsStrictlyPositive())
+    return 0;
+  double support=m_samples/(m_samples+1);
+  double age=(Simulator::Now()-m_lastUpdate).GetSeconds()/m_lifetime.GetSeconds();
+  return (support*std::min(std::max(1-age,0.0),1.0));
+}
+
+void
+SicaBxEstimator::CheckExpire()
+{
+  if (m_samples > 0 && IsExpired())
+    {
+      NS_LOG_DEBUG("Bx estimate has expired");
+      Reset();
+    }
+}
+
+void
+SicaBxEstimator::Reset()
+{
+  m_estimate=0;
+  m_window.clear();
+  m_windowHead=0;
+  m_windowSum=0;
+  m_samples=0;
+}
+
+}/*namespace ns3 */
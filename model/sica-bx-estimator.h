@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICABXESTIMATOR_H
+#define SICABXESTIMATOR_H
+
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sica
+ * \defgroup bxestimator SicaBxEstimator
+ */
+
+/**
+ * \brief Estimator of the bandwidth consumed by external interference (bx) over one channel.
+ *
+ * The estimate is kept in fixed point (SicaBxEstimator::FRACTION_BITS fractional bits, in Mbps) and is
+ * smoothed either with an exponentially weighted moving average or with a sliding window over the last
+ * local samples. Local measurements (channel sensing) and neighbor reports (hello messages) are merged:
+ * a report is weighted by the confidence of the reporter and counts more when our own estimate is
+ * stale or poorly supported. The estimate and its confidence expire after a period without update.
+ */
+class SicaBxEstimator
+{
+public:
+  ///\enum Mode the smoothing of the local samples
+  enum Mode {
+    EWMA_MODE   = 0,///< exponentially weighted moving average
+    WINDOW_MODE = 1,///< average over a sliding window of samples
+  };
+  /// number of fractional bits of the fixed point estimate
+  static const uint32_t FRACTION_BITS = 8;
+  /// c-tor
+  SicaBxEstimator();
+  /**
+   *\brief Set the smoothing parameters of the estimator
+   *\param mode EWMA or sliding window
+   *\param ewmaWeight weight of a new sample in EWMA mode (0,1]
+   *\param windowSize number of samples in the sliding window
+   *\param neighborWeight minimum weight of a neighbor report when our own estimate is fully confident [0,1]
+   */
+  void SetParameters(Mode mode, double ewmaWeight, uint32_t windowSize, double neighborWeight);
+  /**
+   *\brief Add one local measurement of the external bandwidth
+   *\param bx the measured external bandwidth in Mbps
+   *\param expire the lifetime of the information
+   */
+  void AddLocalSample(double bx, Time expire);
+  /**
+   *\brief Merge the external bandwidth reported by a neighbor
+   *\param bx the reported external bandwidth in Mbps
+   *\param confidence the confidence of the reporter in its estimate [0,1]
+   *\param expire the lifetime of the information
+   */
+  void MergeNeighborReport(double bx, double confidence, Time expire);
+  /// Return the current estimate in Mbps, 0 if it has expired
+  double GetEstimate();
+  /// Return the current estimate in fixed point, 0 if it has expired
+  uint32_t GetFixedEstimate();
+  /// Return the confidence of the estimate [0,1], it depends on the number of samples and decays with the age of the information
+  double GetConfidence();
+  /// Return the time of the last local sample
+  Time GetLastLocalSample() const {return m_lastLocal;}
+  /// Return the time of the last update (local or neighbor)
+  Time GetLastUpdate() const {return m_lastUpdate;}
+  /// Return the remaining lifetime of the estimate
+  Time GetExpireTime() const {return (m_expireTime-Simulator::Now());}
+  /// Return true if the estimate has expired or was never updated
+  bool IsExpired() const {return (m_expireTime <= Simulator::Now());}
+  /// Forget all the information
+  void Reset();
+  /// Convert a value in Mbps to fixed point
+  static uint32_t ToFixed(double bx);
+  /// Convert a fixed point value to Mbps
+  static double FromFixed(uint32_t bx){return (static_cast<double>(bx)/(1 << FRACTION_BITS));}
+private:
+  /// Reset the information if it has expired
+  void CheckExpire();
+  /// Push a fixed point sample to the smoothing filter
+  void PushSample(uint32_t sample);
+  /// Extend the expiration of the information
+  void Refresh(Time expire);
+  Mode m_mode;///< smoothing mode
+  uint32_t m_ewmaWeight;///< weight of a new sample in EWMA mode in fixed point
+  uint32_t m_windowSize;///< size of the sliding window
+  double m_neighborWeight;///< minimum weight of a neighbor report
+  uint32_t m_estimate;///< current estimate in fixed point
+  std::vector<uint32_t> m_window;///< samples of the sliding window in fixed point
+  uint32_t m_windowHead;///< next place in the sliding window
+  uint64_t m_windowSum;///< sum of the samples in the sliding window
+  double m_samples;///< effective number of samples which support the estimate
+  Time m_lifetime;///< lifetime of the information, used to decay the confidence
+  Time m_lastLocal;///< time of the last local sample
+  Time m_lastUpdate;///< time of the last update
+  Time m_expireTime;///< the estimate is reset after this time
+};/*SicaBxEstimator*/
+
+}/*namespace ns3 */
+
+#endif /* SICABXESTIMATOR_H */
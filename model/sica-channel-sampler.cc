@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-channel-sampler.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("SicaChannelSampler");
+
+namespace ns3 {
+
+SicaChannelSampler::SicaChannelSampler()
+{
+}
+
+void
+SicaChannelSampler::Build(const std::vector<uint32_t> &channels, const std::vector<double> &prob)
+{
+  NS_ASSERT_MSG(channels.size() == prob.size(),"One probability is needed for each channel");
+  const uint32_t n=channels.size();
+  m_channels=channels;
+  m_threshold.assign(n,1);
+  m_alias.assign(n,0);
+  if (n == 0)
+    return;
+  double total=0;
+  for (uint32_t i=0; i < n; i++)
+    total+=std::max(prob[i],0.0);
+  // scale the probabilities so that the average column is 1 and split them in under and over full columns
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i=0; i < n; i++)
+    {
+      m_alias[i]=i;
+      m_threshold[i]=(total > 0) ? std::max(prob[i],0.0)*n/total : 1;
+      if (m_threshold[i] < 1)
+        small.push_back(i);
+      else
+        large.push_back(i);
+    }
+  // fill each under full column with the excess of an over full one
+  while (!small.empty() && !large.empty())
+    {
+      uint32_t s=small.back();
+      small.pop_back();
+      uint32_t l=large.back();
+      m_alias[s]=l;
+      m_threshold[l]-=1-m_threshold[s];
+      if (m_threshold[l] < 1)
+        {
+          large.pop_back();
+          small.push_back(l);
+        }
+    }
+  // the remaining columns are full up to the rounding errors
+  for (uint32_t i=0; i < small.size(); i++)
+    m_threshold[small[i]]=1;
+  for (uint32_t i=0; i < large.size(); i++)
+    m_threshold[large[i]]=1;
+}
+
+uint32_t
+SicaChannelSampler::Sample(double u) const
+{
+  NS_ASSERT_MSG(!m_channels.empty(),"The alias table is empty");
+  // one uniform number gives both the column and the coin of the column
+  double x=u*m_channels.size();
+  uint32_t column=std::min(static_cast<uint32_t>(x),static_cast<uint32_t>(m_channels.size()-1));
+  if (x-column < m_threshold[column])
+    return m_channels[column];
+  return m_channels[m_alias[column]];
+}
+
+uint32_t
+SicaChannelSampler::Sample(Ptr<UniformRandomVariable> rng) const
+{
+  return Sample(rng->GetValue(0,1));
+}
+
+}/*namespace ns3 */
@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICACHANNELSAMPLER_H
+#define SICACHANNELSAMPLER_H
+
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sica
+ * \defgroup channelsampler SicaChannelSampler
+ */
+
+/**
+ * \brief Draw a channel according to the probabilities of the decision game with the alias method of Walker.
+ *
+ * The alias table is built in O(n) each time the probabilities change (once per channel assignment round)
+ * and every draw costs one uniform random number and one comparison. The random numbers come from the
+ * stream given by the caller, so the draws are reproducible when the stream is fixed with AssignStreams.
+ */
+class SicaChannelSampler
+{
+public:
+  /// c-tor
+  SicaChannelSampler();
+  /**
+   *\brief Build the alias table
+   *\param channels the id of the channels
+   *\param prob the probability of each channel, prob[i] is the probability of channels[i], it is normalized if needed
+   */
+  void Build(const std::vector<uint32_t> &channels, const std::vector<double> &prob);
+  /**
+   *\brief Draw a channel
+   *\param u a uniform random number in [0,1)
+   *\return the id of the channel
+   */
+  uint32_t Sample(double u) const;
+  /**
+   *\brief Draw a channel
+   *\param rng the uniform random variable used for the draw
+   *\return the id of the channel
+   */
+  uint32_t Sample(Ptr<UniformRandomVariable> rng) const;
+  /// Return the number of channels in the table
+  uint32_t GetN() const {return m_channels.size();}
+  /// Return true if the table was not built
+  bool IsEmpty() const {return m_channels.empty();}
+private:
+  std::vector<uint32_t> m_channels;///< id of the channels
+  std::vector<double> m_threshold;///< probability to keep the column, otherwise its alias is returned
+  std::vector<uint32_t> m_alias;///< alias of each column
+};/*SicaChannelSampler*/
+
+}/*namespace ns3 */
+
+#endif /* SICACHANNELSAMPLER_H */
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-channel-strategy.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("SicaChannelStrategy");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (SicaChannelSelectionStrategy);
+NS_OBJECT_ENSURE_REGISTERED (SicaMultiplicativeWeightsStrategy);
+NS_OBJECT_ENSURE_REGISTERED (SicaExp3Strategy);
+NS_OBJECT_ENSURE_REGISTERED (SicaRegretMatchingStrategy);
+NS_OBJECT_ENSURE_REGISTERED (SicaLeastLoadedStrategy);
+
+//////////////////////SicaChannelObservation
+int
+SicaChannelObservation::GetIndex(uint32_t chId) const
+{
+  for (uint32_t i=0; i < channels.size(); i++)
+    if (channels[i] == chId)
+      return i;
+  return -1;
+}
+
+//////////////////////SicaChannelSelectionStrategy
+TypeId
+SicaChannelSelectionStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId("ns3::SicaChannelSelectionStrategy")
+    .SetParent<Object> ()
+    ;
+  return tid;
+}
+
+SicaChannelSelectionStrategy::SicaChannelSelectionStrategy()
+{
+}
+
+SicaChannelSelectionStrategy::~SicaChannelSelectionStrategy()
+{
+}
+
+//////////////////////SicaMultiplicativeWeightsStrategy
+TypeId
+SicaMultiplicativeWeightsStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId("ns3::SicaMultiplicativeWeightsStrategy")
+    .SetParent<SicaChannelSelectionStrategy> ()
+    .AddConstructor<SicaMultiplicativeWeightsStrategy> ()
+    .AddAttribute("Beta","Beta parameter for calculating channel weight default is 0.7, the Beta attribute of Sica is used unless this default is changed",
+		  DoubleValue(0.7),
+		  MakeDoubleAccessor (&SicaMultiplicativeWeightsStrategy::m_beta),
+		  MakeDoubleChecker<double> ())
+    ;
+  return tid;
+}
+
+SicaMultiplicativeWeightsStrategy::SicaMultiplicativeWeightsStrategy():
+  m_beta(0.7)
+{
+}
+
+void
+SicaMultiplicativeWeightsStrategy::Update(const SicaChannelObservation &obs, SicaChannels &table)
+{
+  NS_ASSERT_MSG(m_beta > 0,"Beta must be positive");
+  if (obs.channels.empty())
+    return;
+  // w(t+1)=w(t)*beta^loss is computed as log(w(t+1))=log(w(t))+loss*log(beta), then the weights are normalized
+  table.UpdateChannelWeights(std::log(m_beta),obs.loss,obs.channels.front());
+  for (uint32_t i=0; i < obs.channels.size(); i++)
+    NS_LOG_INFO("weight for channel "<< obs.channels[i] << " is  "<< table.GetChannelWeight(obs.channels[i]) << " loss is  " << obs.loss[i]);
+}
+
+//////////////////////SicaExp3Strategy
+TypeId
+SicaExp3Strategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId("ns3::SicaExp3Strategy")
+    .SetParent<SicaChannelSelectionStrategy> ()
+    .AddConstructor<SicaExp3Strategy> ()
+    .AddAttribute("Eta","Learning rate of EXP3 default is 0.1",
+		  DoubleValue(0.1),
+		  MakeDoubleAccessor (&SicaExp3Strategy::m_eta),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("ImplicitExploration","Implicit exploration parameter of EXP3-IX, 0 gives EXP3 default is 0.05",
+		  DoubleValue(0.05),
+		  MakeDoubleAccessor (&SicaExp3Strategy::m_gammaIx),
+		  MakeDoubleChecker<double> (0))
+    ;
+  return tid;
+}
+
+SicaExp3Strategy::SicaExp3Strategy():
+  m_eta(0.1),
+  m_gammaIx(0.05)
+{
+}
+
+void
+SicaExp3Strategy::Update(const SicaChannelObservation &obs, SicaChannels &table)
+{
+  const uint32_t n=obs.channels.size();
+  if (n == 0)
+    return;
+  if (m_cumLoss.size() != n)
+    {
+      m_cumLoss.assign(n,0);
+      m_prob.assign(n,1.0/n);
+    }
+  // only the loss of the channel played is observed by a bandit
+  int played=obs.GetIndex(obs.current);
+  if (played != -1)
+    {
+      double l=std::min(std::max(obs.loss[played],0.0),1.0);
+      m_cumLoss[played]+=l/(m_prob[played]+m_gammaIx);
+    }
+  double minLoss=*std::min_element(m_cumLoss.begin(),m_cumLoss.end());
+  double total=0;
+  for (uint32_t i=0; i < n; i++)
+    {
+      m_prob[i]=std::exp(-m_eta*(m_cumLoss[i]-minLoss));
+      total+=m_prob[i];
+    }
+  for (uint32_t i=0; i < n; i++)
+    {
+      m_prob[i]/=total;
+      table.SetChannelWeight(obs.channels[i],m_prob[i]);
+      NS_LOG_INFO("EXP3 probability for channel "<< obs.channels[i] << " is  "<< m_prob[i] << " estimated loss is  " << m_cumLoss[i]);
+    }
+  table.NormalizeChannelWeights();
+}
+
+//////////////////////SicaRegretMatchingStrategy
+TypeId
+SicaRegretMatchingStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId("ns3::SicaRegretMatchingStrategy")
+    .SetParent<SicaChannelSelectionStrategy> ()
+    .AddConstructor<SicaRegretMatchingStrategy> ()
+    ;
+  return tid;
+}
+
+SicaRegretMatchingStrategy::SicaRegretMatchingStrategy()
+{
+}
+
+void
+SicaRegretMatchingStrategy::Update(const SicaChannelObservation &obs, SicaChannels &table)
+{
+  const uint32_t n=obs.channels.size();
+  if (n == 0)
+    return;
+  if (m_regret.size() != n)
+    m_regret.assign(n,0);
+  int played=obs.GetIndex(obs.current);
+  if (played == -1)
+    return;
+  // regret of not having played channel i instead of the channel played
+  double total=0;
+  for (uint32_t i=0; i < n; i++)
+    {
+      m_regret[i]+=obs.loss[played]-obs.loss[i];
+      total+=std::max(m_regret[i],0.0);
+    }
+  for (uint32_t i=0; i < n; i++)
+    {
+      double w;
+      if (total > 0)
+        w=std::max(m_regret[i],0.0)/total;
+      else
+        w=(static_cast<int>(i) == played) ? 1 : 0;
+      table.SetChannelWeight(obs.channels[i],w);
+      NS_LOG_INFO("Regret for channel "<< obs.channels[i] << " is  "<< m_regret[i] << " probability is " << w);
+    }
+  table.NormalizeChannelWeights();
+}
+
+//////////////////////SicaLeastLoadedStrategy
+TypeId
+SicaLeastLoadedStrategy::GetTypeId (void)
+{
+  static TypeId tid = TypeId("ns3::SicaLeastLoadedStrategy")
+    .SetParent<SicaChannelSelectionStrategy> ()
+    .AddConstructor<SicaLeastLoadedStrategy> ()
+    ;
+  return tid;
+}
+
+SicaLeastLoadedStrategy::SicaLeastLoadedStrategy()
+{
+}
+
+void
+SicaLeastLoadedStrategy::Update(const SicaChannelObservation &obs, SicaChannels &table)
+{
+  const uint32_t n=obs.channels.size();
+  if (n == 0)
+    return;
+  int best=obs.GetIndex(obs.current);
+  if (best == -1)
+    best=0;
+  for (uint32_t i=0; i < n; i++)
+    if (obs.loss[i] < obs.loss[best])
+      best=i;
+  for (uint32_t i=0; i < n; i++)
+    table.SetChannelWeight(obs.channels[i],(static_cast<int>(i) == best) ? 1 : 0);
+  NS_LOG_INFO("Least loaded channel is "<< obs.channels[best] << " loss is  " << obs.loss[best]);
+}
+
+}/*namespace ns3 */
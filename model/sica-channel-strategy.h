@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICACHANNELSTRATEGY_H
+#define SICACHANNELSTRATEGY_H
+
+/**
+ * \ingroup sica
+ * \defgroup channelstrategy SicaChannelSelectionStrategy
+ */
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/double.h"
+#include "ns3/sica-channel.h"
+
+namespace ns3 {
+
+/**
+ * \brief The per-channel observations given to a channel selection strategy at each channel assignment round.
+ *
+ * All the vectors are indexed like SicaChannelObservation::channels.
+ */
+struct SicaChannelObservation
+{
+  std::vector<uint32_t> channels;///< the id of the channels
+  std::vector<double> loss;///< the stage loss of each channel computed by Sica::ComputeStageLoss
+  std::vector<double> bx;///< the estimated external bandwidth of each channel in Mbps
+  std::vector<uint32_t> neighbors;///< the number of neighbors with their R interface on each channel
+  uint32_t totalNeighbors;///< the number of neighbors of the node
+  uint32_t current;///< the channel of the R interface during the last round (the action played)
+  /// Return the position of the channel in the vectors, -1 if the channel is unknown
+  int GetIndex(uint32_t chId) const;
+};
+
+/**
+ * \brief Interface of the decision algorithm which turns the channel observations into selection weights.
+ *
+ * At each channel assignment round Sica computes the observations and calls Update. The strategy writes the
+ * new weights of the channels into the channel table. Sica then draws the channel of the R interface with
+ * a probability proportional to these weights. The strategy is selected with the
+ * Sica::ChannelSelectionStrategy attribute.
+ */
+class SicaChannelSelectionStrategy : public Object
+{
+public:
+  /// Return the TypeId of the interface
+  static TypeId GetTypeId (void);
+  /// c-tor
+  SicaChannelSelectionStrategy();
+  /// d-tor
+  virtual ~SicaChannelSelectionStrategy();
+  /**
+   *\brief Run one round of the decision algorithm
+   *\param obs the observations of the round
+   *\param table the channel table into which the new weights are written
+   */
+  virtual void Update(const SicaChannelObservation &obs, SicaChannels &table) = 0;
+};
+
+/**
+ * \brief The multiplicative weights game of Sica, the weight of each channel is multiplied by Beta^loss.
+ */
+class SicaMultiplicativeWeightsStrategy : public SicaChannelSelectionStrategy
+{
+public:
+  /// Return the TypeId of the strategy
+  static TypeId GetTypeId (void);
+  /// c-tor
+  SicaMultiplicativeWeightsStrategy();
+  virtual void Update(const SicaChannelObservation &obs, SicaChannels &table);
+private:
+  double m_beta;///< Beta parameter for calculating the channel weights
+};
+
+/**
+ * \brief The EXP3-IX adversarial bandit, only the loss of the channel played is used.
+ *
+ * The loss of the channel played is divided by its probability plus the implicit exploration parameter and
+ * accumulated; the weight of each channel is exp(-Eta * cumulated estimated loss).
+ */
+class SicaExp3Strategy : public SicaChannelSelectionStrategy
+{
+public:
+  /// Return the TypeId of the strategy
+  static TypeId GetTypeId (void);
+  /// c-tor
+  SicaExp3Strategy();
+  virtual void Update(const SicaChannelObservation &obs, SicaChannels &table);
+private:
+  double m_eta;///< learning rate
+  double m_gammaIx;///< implicit exploration parameter, 0 gives the plain EXP3 estimator
+  std::vector<double> m_cumLoss;///< cumulated estimated loss of each channel
+  std::vector<double> m_prob;///< probability of each channel after the last round
+};
+
+/**
+ * \brief The regret matching of Hart and Mas-Colell, a channel is selected with a probability proportional to
+ * the positive part of the cumulated regret of not having played it. The current channel is kept while no
+ * channel has a positive regret.
+ */
+class SicaRegretMatchingStrategy : public SicaChannelSelectionStrategy
+{
+public:
+  /// Return the TypeId of the strategy
+  static TypeId GetTypeId (void);
+  /// c-tor
+  SicaRegretMatchingStrategy();
+  virtual void Update(const SicaChannelObservation &obs, SicaChannels &table);
+private:
+  std::vector<double> m_regret;///< cumulated regret of each channel
+};
+
+/**
+ * \brief Greedy baseline, the channel with the lowest loss is selected, the current channel wins the ties.
+ */
+class SicaLeastLoadedStrategy : public SicaChannelSelectionStrategy
+{
+public:
+  /// Return the TypeId of the strategy
+  static TypeId GetTypeId (void);
+  /// c-tor
+  SicaLeastLoadedStrategy();
+  virtual void Update(const SicaChannelObservation &obs, SicaChannels &table);
+};
+
+}/*namespace ns3 */
+
+#endif /* SICACHANNELSTRATEGY_H */
@@ -10,11 +10,16 @@
 
 #include"ns3/sica-channel.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
 
 NS_LOG_COMPONENT_DEFINE ("SicaChannel");
 
 namespace ns3 {
 
+/// Floor of the log weights, a channel keeps a chance to be selected again and the weights never underflow to 0
+static const double MIN_LOG_WEIGHT = -700;
+
 
 
 SicaChannels::SicaChannels()
@@ -32,26 +37,41 @@ SicaChannels::FindChannel(uint32_t chId)
      }
    return(c);
 }
+
+int
+SicaChannels::FindChannelIndex(uint32_t chId)
+{
+  for (uint32_t i=0; i < m_channel.size(); i++)
+    if (m_channel[i].m_cId==chId)
+      return i;
+  return -1;
+}
    
 void 
-SicaChannels::UpdateChannel(uint32_t chId,uint32_t bw,uint32_t bx,uint32_t niNo,Time bxExpTime)
+SicaChannels::SetBxEstimatorParameters(SicaBxEstimator::Mode mode, double ewmaWeight, uint32_t windowSize, double neighborWeight)
+{
+  m_bxPrototype.SetParameters(mode,ewmaWeight,windowSize,neighborWeight);
+}
+
+void 
+SicaChannels::UpdateChannel(uint32_t chId,uint32_t bw,double bx,double bxConfidence,uint32_t niNo,Time bxExpTime)
 {
   SicaChannel *i= FindChannel(chId);
   if (i)
     {
       i->m_bw=bw;
-      //i->m_bx=(i->m_bx+bx)/2;
-      i->m_bx=bx;
       i->m_neighborsNo=niNo;
-      i->m_bxExpireTime=std::max(bxExpTime+Simulator::Now(),i->m_bxExpireTime);
       NS_LOG_DEBUG("Information for channel with ID "<< chId <<" is updated");
     }
   else 
     {
-    i = new SicaChannel(chId,bw,bx,niNo,bxExpTime);
-    m_channel.push_back(*i);
+    m_channel.push_back(SicaChannel(chId,bw,m_bxPrototype,niNo));
+    m_logWeight.push_back(MIN_LOG_WEIGHT);
+    i=&m_channel.back();
     NS_LOG_DEBUG("Information for channel with ID "<< chId <<" is added to channel list");
     }
+  if (bx <= bw)
+    i->m_bx.MergeNeighborReport(bx,bxConfidence,bxExpTime);
 }
 
 void 
@@ -73,13 +93,14 @@ else
 }
 
 void 
-SicaChannels::SetChannelExtBandwidth(uint32_t chId, uint32_t bx,Time bxExpTime)
+SicaChannels::SetChannelExtBandwidth(uint32_t chId, double bx,Time bxExpTime)
 {
  SicaChannel *i= FindChannel(chId);
  if (i){
    if (i->m_bw >= bx ){
-     i->m_bx=bx;
-     i->m_bxExpireTime=std::max(bxExpTime+Simulator::Now(),i->m_bxExpireTime);
+     i->m_bx.AddLocalSample(bx,bxExpTime);
+     i->m_lastSensed=Simulator::Now();
+     i->m_senseCount++;
      NS_LOG_DEBUG("External bandwidth is updated "<< bx);
    }
    else 
@@ -88,16 +109,21 @@ SicaChannels::SetChannelExtBandwidth(uint32_t chId, uint32_t bx,Time bxExpTime)
  
 }
 
-uint32_t
+double
 SicaChannels::GetChannelExtBandwidth(uint32_t chId)
 {
 SicaChannel *i= FindChannel(chId);
- if (i){
-   if ( (i->m_bxExpireTime-Simulator::Now()).IsPositive())
-    return (i->m_bx);
-  else
-    i->m_bx=0;
-      }
+ if (i)
+   return (i->m_bx.GetEstimate());
+ return (0);
+}
+
+double
+SicaChannels::GetChannelExtBandwidthConfidence(uint32_t chId)
+{
+SicaChannel *i= FindChannel(chId);
+ if (i)
+   return (i->m_bx.GetConfidence());
  return (0);
 }
 
@@ -106,10 +132,66 @@ SicaChannels::GetExtBandwidthExpireTime(uint32_t chId)
 {
 SicaChannel *i= FindChannel(chId);
  if (i)
-   return (i->m_bxExpireTime-Simulator::Now());
+   return (i->m_bx.GetExpireTime());
  return (Seconds(0));
 }
 
+Time
+SicaChannels::GetChannelSenseAge(uint32_t chId)
+{
+SicaChannel *i= FindChannel(chId);
+ if (i && i->m_senseCount > 0)
+   return (Simulator::Now()-i->m_lastSensed);
+ return (Time::Max());
+}
+
+uint32_t
+SicaChannels::GetChannelSenseCount(uint32_t chId)
+{
+SicaChannel *i= FindChannel(chId);
+ if (i)
+   return (i->m_senseCount);
+ return (0);
+}
+
+void
+SicaChannels::RecordTxResult(uint32_t chId, bool ok, uint32_t count)
+{
+SicaChannel *i= FindChannel(chId);
+ if (!i || count==0)
+   return;
+ i->m_tx.Record(ok,count);
+}
+
+double
+SicaChannels::GetTxFailureRatio(uint32_t chId)
+{
+SicaChannel *i= FindChannel(chId);
+ if (!i)
+   return (0);
+ return (i->m_tx.GetFailureRatio());
+}
+
+int
+SicaChannels::FindStaleChannel(Time staleTime, uint32_t exclude)
+{
+  int chId=-1;
+  Time maxAge=staleTime;
+  for (std::vector<SicaChannels::SicaChannel>::iterator i =  m_channel.begin (); i !=  m_channel.end (); ++i)
+    {
+      if (i->m_cId == exclude)
+        continue;
+      Time age=GetChannelSenseAge(i->m_cId);
+      // a channel never sensed is older than any other, the first one found is kept
+      if (age > maxAge)
+        {
+          maxAge=age;
+          chId=i->m_cId;
+        }
+    }
+  return chId;
+}
+
 void 
 SicaChannels::SetChannelNeighbors(uint32_t chId,uint32_t niNo)
 {
@@ -148,40 +230,101 @@ SicaChannel *i= FindChannel(chId);
 void 
 SicaChannels::SetChannelWeight(uint32_t chId,double w)
 {
-  SicaChannel *i= FindChannel(chId);
- if (i)
-   i->m_weight=w;
- 
+ int i= FindChannelIndex(chId);
+ if (i != -1)
+   m_logWeight[i]=(w > 0) ? std::max(std::log(w),MIN_LOG_WEIGHT) : MIN_LOG_WEIGHT;
 }
 
- void 
-SicaChannels::SetChannelSenseFlag(uint32_t chId)
- {
-   SicaChannel *i= FindChannel(chId);
- if (i)
-   i->m_senseFalg=true;
- }
+void 
+SicaChannels::UpdateChannelWeights(double logBeta,const std::vector<double> &loss,uint32_t firstCh)
+{
+  const uint32_t n=m_logWeight.size();
+  double *w=n ? &m_logWeight[0] : 0;
+  for (uint32_t i=0; i < n; i++)
+    {
+      uint32_t l=m_channel[i].m_cId-firstCh;
+      if (l < loss.size())
+        w[i]+=logBeta*loss[l];
+    }
+  NormalizeChannelWeights();
+}
 
 void 
-SicaChannels::ResetChannelSenseFlag(uint32_t chId)
+SicaChannels::NormalizeChannelWeights()
 {
-   SicaChannel *i= FindChannel(chId);
- if (i)
-   i->m_senseFalg=false;
- }
+  if (m_logWeight.empty())
+    return;
+  const uint32_t n=m_logWeight.size();
+  double *w=&m_logWeight[0];
+  double maxW=*std::max_element(m_logWeight.begin(),m_logWeight.end());
+  for (uint32_t i=0; i < n; i++)
+    w[i]=std::max(w[i]-maxW,MIN_LOG_WEIGHT);
+}
+
+void 
+SicaChannels::AddSenseWindow(uint32_t chId, Time start, Time end)
+{
+  SicaChannel *i= FindChannel(chId);
+  if (!i || end <= start || end <= Simulator::Now())
+    return;
+  std::map<Time, Time> &w=i->m_senseWindows;
+  // forget the periods which are over
+  while (!w.empty() && w.begin()->second <= Simulator::Now())
+    w.erase(w.begin());
+  // merge with the period starting before and overlapping the new one
+  std::map<Time, Time>::iterator it=w.upper_bound(start);
+  if (it != w.begin())
+    {
+      std::map<Time, Time>::iterator prev=it;
+      --prev;
+      if (prev->second >= start)
+	{
+	  start=prev->first;
+	  end=std::max(end,prev->second);
+	  w.erase(prev);
+	}
+    }
+  // merge with the periods starting inside the new one
+  it=w.lower_bound(start);
+  while (it != w.end() && it->first <= end)
+    {
+      end=std::max(end,it->second);
+      w.erase(it++);
+    }
+  w.insert(std::make_pair(start,end));
+  NS_LOG_DEBUG("Channel "<< chId <<" is sensed from "<< start.GetSeconds() <<"s to "<< end.GetSeconds() << "s");
+}
+
+uint32_t 
+SicaChannels::GetSenseWindowCount(uint32_t chId)
+{
+  SicaChannel *i= FindChannel(chId);
+  if (!i)
+    return 0;
+  uint32_t n=0;
+  for (std::map<Time, Time>::iterator it=i->m_senseWindows.begin(); it != i->m_senseWindows.end(); ++it)
+    if (it->second > Simulator::Now())
+      n++;
+  return n;
+}
 
 bool 
 SicaChannels::IsBeingSensed(uint32_t chId)
 {
  SicaChannel *i= FindChannel(chId);
- if (i)
-   return i->m_senseFalg;
- return false;
+ if (!i || i->m_senseWindows.empty())
+   return false;
+ Time now=Simulator::Now();
+ // the last period which starts at or before now
+ std::map<Time, Time>::iterator it=i->m_senseWindows.upper_bound(now);
+ if (it == i->m_senseWindows.begin())
+   return false;
+ --it;
+ return (it->second > now);
 }
 
 
 
-
 void 
 SicaChannels::PrintChannel(std::ostream &os)
 {
@@ -195,14 +338,19 @@ for (std::vector<SicaChannels::SicaChannel>::iterator i =  m_channel.begin (); i
   {
     os << "\nChannel ID : " << i->m_cId;
     os << "\n-- Total Bandwidth (mbps): " << i->m_bw ;
-    if ( (i->m_bxExpireTime-Simulator::Now()).IsPositive()){
-      os << "\n-- External  Bandwidth Consumption  (mbps): " << i->m_bx ;
-      os << "\n-- The expiration time for bx is :" << i->m_bxExpireTime;
+    if (!i->m_bx.IsExpired()){
+      os << "\n-- External  Bandwidth Consumption  (mbps): " << i->m_bx.GetEstimate() ;
+      os << "\n-- Confidence of the estimation : " << i->m_bx.GetConfidence() ;
+      os << "\n-- The expiration time for bx is :" << i->m_bx.GetExpireTime();
     }
     else 
       os << "\n-- External  Bandwidth Consumption  (mbps): " << 0;
+    if (i->m_senseCount > 0)
+      os << "\n-- Last sensed locally at : " << i->m_lastSensed.GetSeconds() << "s (" << i->m_senseCount << " times)";
+    else 
+      os << "\n-- Never sensed locally";
     os << "\n-- Number of neighboring radios on channel : " << i->m_neighborsNo ;
-    os << "\n-- Channel Weight : " << i->m_weight << "\n";
+    os << "\n-- Channel Weight : " << GetChannelWeight(i->m_cId) << "\n";
   } 
 }
 
@@ -210,32 +358,42 @@ for (std::vector<SicaChannels::SicaChannel>::iterator i =  m_channel.begin (); i
 double 
 SicaChannels::GetChannelWeight(uint32_t chId)
 {
- SicaChannel *i= FindChannel(chId);
-if (i)
-  return (i->m_weight);
+ int i= FindChannelIndex(chId);
+ if (i != -1)
+   return (std::exp(m_logWeight[i]));
  else 
  return (0);
 }
 
+double 
+SicaChannels::GetChannelLogWeight(uint32_t chId)
+{
+ int i= FindChannelIndex(chId);
+ if (i != -1)
+   return (m_logWeight[i]);
+ else 
+ return (MIN_LOG_WEIGHT);
+}
+
 double 
 SicaChannels::CalculateCLCPF(uint32_t ccc)
 {
-  double clcpf=m_channel.begin()->m_weight;
-  for (std::vector<SicaChannels::SicaChannel>::iterator i =  m_channel.begin (); i !=  m_channel.end (); ++i)
-    if (i->m_cId != ccc && clcpf > i->m_weight)
-      clcpf=i->m_weight;
-  return clcpf;
+  double clcpf=m_logWeight[0];
+  for (uint32_t i=0; i < m_channel.size(); i++)
+    if (m_channel[i].m_cId != ccc && clcpf > m_logWeight[i])
+      clcpf=m_logWeight[i];
+  return std::exp(clcpf);
 }
 
 int 
 SicaChannels::FindMaxWeightChannel(uint32_t ccc)
 {
-  double maxW=m_channel.begin ()->m_weight;
+  double maxW=m_logWeight[0];
   int chId = m_channel.begin ()->m_cId;
-  for (std::vector<SicaChannels::SicaChannel>::iterator i =  m_channel.begin (); i !=  m_channel.end (); ++i)
-    if (i->m_cId != ccc && maxW < i->m_weight){
-     maxW =i->m_weight;
-     chId=i->m_cId;
+  for (uint32_t i=0; i < m_channel.size(); i++)
+    if (m_channel[i].m_cId != ccc && maxW < m_logWeight[i]){
+     maxW =m_logWeight[i];
+     chId=m_channel[i].m_cId;
     }
   return chId;
 }
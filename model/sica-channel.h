@@ -13,9 +13,12 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 #include "ns3/timer.h"
+#include "ns3/sica-bx-estimator.h"
+#include "ns3/sica-tx-history.h"
 
 namespace ns3 {
 
@@ -41,20 +44,20 @@ public:
   {
     uint32_t m_cId;///< Channel ID
     uint32_t m_bw; ///< Channel's total bandwidth in mbps
-    uint32_t m_bx; ///< Estimated external interference bandwidth consumption for this channel
+    SicaBxEstimator m_bx; ///< Estimated external interference bandwidth consumption for this channel, it expires if there is no update
     uint32_t m_neighborsNo; ///< Number of neighboring interface on the channel
-    double m_weight;///< Channel weights according to decision game
-    Time m_bxExpireTime; ///< Reset Bx after a long period of time if there is no update happens
-    bool m_senseFalg; ///< Used to show whether this channel is being sensed or not, during the sense period no data transmission is done
+    std::map<Time, Time> m_senseWindows; ///< Disjoint periods during which the channel is sensed (start, end), no data transmission is done over the channel during these periods
+    Time m_lastSensed; ///< The time of the last local sensing of the channel
+    uint32_t m_senseCount; ///< Number of local sensing of the channel, 0 if it was never sensed
+    SicaTxHistory m_tx; ///< Recent data frames acknowledged, failed or dropped from the queue of the channel
     ///c-tor of the SicaChannel struct
-    SicaChannel(uint32_t chId,uint32_t bw,uint32_t bx,uint32_t niNo,Time bxExpTime):
+    SicaChannel(uint32_t chId,uint32_t bw,SicaBxEstimator bx,uint32_t niNo):
       m_cId(chId),
       m_bw(bw),
       m_bx(bx),
       m_neighborsNo(niNo),
-      m_weight(0),
-      m_bxExpireTime(Simulator::Now()+bxExpTime),
-      m_senseFalg(false)
+      m_lastSensed(Seconds(0)),
+      m_senseCount(0)
     {
     }
   };
@@ -68,15 +71,24 @@ public:
    *\param chId the id of the channel 
    */
   SicaChannel *FindChannel(uint32_t chId);
+  /**
+   *\brief Set the parameters of the external bandwidth estimators of the channels created afterwards
+   *\param mode EWMA or sliding window smoothing
+   *\param ewmaWeight weight of a new sample in EWMA mode
+   *\param windowSize number of samples in the sliding window
+   *\param neighborWeight minimum weight of a neighbor report
+   */
+  void SetBxEstimatorParameters(SicaBxEstimator::Mode mode, double ewmaWeight, uint32_t windowSize, double neighborWeight);
   /**
    *\brief  Update or insert information in channel list
    *\param chId the Id of the channel
    *\param bw the bandwidth of the channel in Mb
-*\param bx the amount of channel  bandwidth consumed by external interference 
+*\param bx the amount of channel  bandwidth consumed by external interference reported by a neighbor, it is merged into the estimator of the channel
+*\param bxConfidence the confidence of the neighbor in the reported bx, 0 means no report
    *\param niNo number of neighboring radio interface tuned to the channel
    *\param bxExpTime the expire time of the information about channel
    */
-  void UpdateChannel(uint32_t chId,uint32_t bw,uint32_t bx,uint32_t niNo ,Time bxExpTime);
+  void UpdateChannel(uint32_t chId,uint32_t bw,double bx,double bxConfidence,uint32_t niNo ,Time bxExpTime);
   /**
    *\brief  Set the total bandwidth of the channel with ID id
    *\param chId the Id of the channel
@@ -89,22 +101,56 @@ public:
    */
   uint32_t  GetChannelBandwidth(uint32_t chId);
   /**
-   *\brief  Set the external bandwidth consumption for  channel with ID id
+   *\brief  Add a local measurement of the external bandwidth consumption for  channel with ID id
 *\param chId the Id of the channel
 *\param bx the amount of channel  bandwidth consumed by external interference
 *\param bxExpTime the expiration time of new information
 */
-  void SetChannelExtBandwidth(uint32_t chId, uint32_t bx,Time bxExpTime);
+  void SetChannelExtBandwidth(uint32_t chId, double bx,Time bxExpTime);
   /**
-   *\brief  Return the external bandwidth consumption for  channel with ID id
+   *\brief  Return the estimated external bandwidth consumption for  channel with ID id in Mbps
   *\param chId the Id of the channel
   */
-  uint32_t GetChannelExtBandwidth(uint32_t chId);
+  double GetChannelExtBandwidth(uint32_t chId);
+  /**
+   *\brief  Return the confidence [0,1] of the estimated external bandwidth consumption for  channel with ID id
+  *\param chId the Id of the channel
+  */
+  double GetChannelExtBandwidthConfidence(uint32_t chId);
   /**
    *\brief Return the expiration time for estimated external bandwidth for channel with ID id
 *\param chId the Id of the channel
 */
   Time GetExtBandwidthExpireTime(uint32_t chId);
+  /**
+   *\brief Return the time elapsed since the last local sensing of the channel with ID id, Time::Max() if it was never sensed
+*\param chId the Id of the channel
+*/
+  Time GetChannelSenseAge(uint32_t chId);
+  /**
+   *\brief Return the number of local sensing of the channel with ID id
+*\param chId the Id of the channel
+*/
+  uint32_t GetChannelSenseCount(uint32_t chId);
+  /**
+   *\brief  Find the channel whose local sensing is the oldest, channels never sensed come first
+   *\param staleTime only channels sensed more than staleTime ago are considered
+   *\param exclude the Id of a channel to be avoided (e.g. the channel sensed by the R interface)
+   *\return the Id of the channel or -1 if all channels are fresh
+   */
+  int FindStaleChannel(Time staleTime, uint32_t exclude);
+  /**
+   *\brief Count the result of transmissions over the channel with ID id, old results are aged so that the counts follow the recent traffic
+*\param chId the Id of the channel
+*\param ok true if the transmissions succeeded, false if they failed or were dropped
+*\param count the number of transmissions
+*/
+  void RecordTxResult(uint32_t chId, bool ok, uint32_t count=1);
+  /**
+   *\brief Return the fraction [0,1] of the recent transmissions over the channel with ID id which failed, 0 if there was no transmission
+*\param chId the Id of the channel
+*/
+  double GetTxFailureRatio(uint32_t chId);
   /**
    *\brief  Set the number of neighbors that have one receiving radio on  channel with ID id
    *\param chId the Id of the channel
@@ -127,28 +173,46 @@ public:
 */
   void DecChannelNeighbors(uint32_t chId);
   /**
-   *\brief  Set the weight of a channel with ID id
+   *\brief  Set the weight of a channel with ID id, the weight is kept in log space
 *\param chId the Id of the channel
 *\param w the weight of the channel 
 */
   void SetChannelWeight(uint32_t chId,double w);
   /**
-   *\brief  Return  the  weight of a channel with ID id
+   *\brief  Return  the  weight of a channel with ID id relative to the biggest weight after the last normalization
 *\param chId the Id of the channel
 */
   double GetChannelWeight(uint32_t chId); 
   /**
-   *\ Set the sense flag for the channel
+   *\brief  Return  the  log of the weight of a channel with ID id
+*\param chId the Id of the channel
+*/
+  double GetChannelLogWeight(uint32_t chId); 
+  /**
+   *\brief  Multiply the weight of every channel by beta^loss in one pass over the log weights, then normalize the weights so that the biggest one is 1
+*\param logBeta the log of the beta parameter of the decision game
+*\param loss the loss of the channels, loss[c-firstCh] is the loss of channel c
+*\param firstCh the Id of the channel of the first loss
+*/
+  void UpdateChannelWeights(double logBeta,const std::vector<double> &loss,uint32_t firstCh);
+  /**
+   *\brief  Normalize the log weights so that the biggest weight is 1
+   */
+  void NormalizeChannelWeights();
+  /**
+   *\brief Add a period during which the channel is sensed, it is merged with the overlapping periods already known
 *\param chId the Id of the channel
+*\param start the absolute start time of the sensing
+*\param end the absolute end time of the sensing
 */
-  void SetChannelSenseFlag(uint32_t chId);
+  void AddSenseWindow(uint32_t chId, Time start, Time end);
   /**
-   *\brief Reset the sense flag for the channel
+   *\brief Return the number of known sensing periods of the channel which are not over
 *\param chId the Id of the channel
 */
-  void ResetChannelSenseFlag(uint32_t chId);
+  uint32_t GetSenseWindowCount(uint32_t chId);
   /**
-   *\brief  Return true if any neighbor is sensing this channel, otherwise false
+   *\brief  Return true if we or any neighbor is sensing this channel now, otherwise false
 *\param chId the Id of the channel
 */
   bool IsBeingSensed(uint32_t chId);
@@ -158,7 +222,7 @@ public:
    */
   void PrintChannel(std::ostream &os);
   /// Clear channel list
-  void Clear(){m_channel.clear();}
+  void Clear(){m_channel.clear(); m_logWeight.clear();}
   /**
    *\brief  calculate and return clcpf for Urbanx::Urbanx protocol 
    *\return channel with minimum weight
@@ -171,8 +235,14 @@ public:
    */
   int FindMaxWeightChannel(uint32_t ccc);
 private:
+  /// Return the position of the channel with ID id in the channel list, -1 if not found
+  int FindChannelIndex(uint32_t chId);
   /// List of channels
   std::vector<SicaChannel> m_channel; 
+  /// Log of the channel weights according to decision game, m_logWeight[i] is the weight of m_channel[i]
+  std::vector<double> m_logWeight;
+  /// Estimator copied into the new channels, holds the estimator parameters
+  SicaBxEstimator m_bxPrototype;
 };/*SicaChannels*/
 
 
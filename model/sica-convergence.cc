@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-convergence.h"
+#include "ns3/log.h"
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("SicaConvergenceMonitor");
+
+namespace ns3 {
+
+/// Weight of the last round in the moving average of the switch rate
+static const double SWITCH_RATE_WEIGHT = 0.25;
+/// Maximum switch rate of a converged node, about one switch every five rounds
+static const double MAX_CONVERGED_SWITCH_RATE = 0.2;
+
+SicaConvergenceMonitor::SicaConvergenceMonitor():
+  m_threshold(0.05),
+  m_rounds(3),
+  m_lastChange(0),
+  m_switchRate(0),
+  m_stableRounds(0),
+  m_converged(false)
+{
+}
+
+void
+SicaConvergenceMonitor::SetParameters(double threshold, uint32_t rounds)
+{
+  m_threshold=threshold;
+  m_rounds=rounds;
+}
+
+bool
+SicaConvergenceMonitor::Update(const std::vector<double> &prob, bool switched)
+{
+  bool wasConverged=m_converged;
+  if (m_prob.size() == prob.size())
+    {
+      m_lastChange=0;
+      for (uint32_t i=0; i < prob.size(); i++)
+        m_lastChange+=std::fabs(prob[i]-m_prob[i]);
+    }
+  else
+    m_lastChange=2; // first round, the biggest possible change
+  m_prob=prob;
+  m_switchRate=(1-SWITCH_RATE_WEIGHT)*m_switchRate+SWITCH_RATE_WEIGHT*(switched ? 1 : 0);
+  if (m_lastChange < m_threshold && !switched)
+    m_stableRounds++;
+  else
+    m_stableRounds=0;
+  // a node which keeps switching between stable periods oscillates
+  m_converged=(m_stableRounds >= m_rounds && m_switchRate < MAX_CONVERGED_SWITCH_RATE);
+  NS_LOG_DEBUG("Probability change "<< m_lastChange << " switch rate "<< m_switchRate << " stable rounds "<< m_stableRounds);
+  return (wasConverged != m_converged);
+}
+
+void
+SicaConvergenceMonitor::Reset()
+{
+  m_prob.clear();
+  m_lastChange=0;
+  m_stableRounds=0;
+  m_converged=false;
+}
+
+}/*namespace ns3 */
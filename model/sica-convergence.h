@@ -0,0 +1,75 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICACONVERGENCE_H
+#define SICACONVERGENCE_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup sica
+ * \defgroup convergence SicaConvergenceMonitor
+ */
+
+/**
+ * \brief Detect the convergence of the channel assignment of a node.
+ *
+ * At each channel assignment round the monitor receives the probability vector of the channels and whether
+ * the round decided a switch. A round is stable when the L1 distance to the previous probability vector is
+ * below the threshold and no switch was decided. The node is converged after a number of consecutive
+ * stable rounds while the moving average of its switches stays low, and it leaves the converged state at
+ * the first round which is not stable.
+ */
+class SicaConvergenceMonitor
+{
+public:
+  /// c-tor
+  SicaConvergenceMonitor();
+  /**
+   *\brief Set the parameters of the detection
+   *\param threshold maximum L1 change of the probability vector of a stable round
+   *\param rounds number of consecutive stable rounds needed to be converged
+   */
+  void SetParameters(double threshold, uint32_t rounds);
+  /**
+   *\brief Add the result of one channel assignment round
+   *\param prob the probability of the channels after the round
+   *\param switched true if the round decided to switch the R interface
+   *\return true if the converged state has changed
+   */
+  bool Update(const std::vector<double> &prob, bool switched);
+  /// Return true if the channel assignment has converged
+  bool IsConverged() const {return m_converged;}
+  /// Return true if the last round was stable
+  bool IsStable() const {return (m_stableRounds > 0);}
+  /// Return the L1 change of the probability vector in the last round
+  double GetLastChange() const {return m_lastChange;}
+  /// Return the moving average of the number of switches per round
+  double GetSwitchRate() const {return m_switchRate;}
+  /// Return the number of consecutive stable rounds
+  uint32_t GetStableRounds() const {return m_stableRounds;}
+  /// Forget the history, e.g. after a change of the interference
+  void Reset();
+private:
+  double m_threshold;///< maximum L1 change of a stable round
+  uint32_t m_rounds;///< number of stable rounds to be converged
+  std::vector<double> m_prob;///< probability vector of the previous round
+  double m_lastChange;///< L1 change of the last round
+  double m_switchRate;///< moving average of the switches per round
+  uint32_t m_stableRounds;///< number of consecutive stable rounds
+  bool m_converged;///< converged state
+};/*SicaConvergenceMonitor*/
+
+}/*namespace ns3 */
+
+#endif /* SICACONVERGENCE_H */
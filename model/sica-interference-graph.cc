@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-interference-graph.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("SicaInterferenceGraph");
+
+namespace ns3 {
+
+SicaInterferenceGraph::SicaInterferenceGraph():
+  m_oneHopWeight(1),
+  m_twoHopWeight(1),
+  m_pathWeight(1)
+{
+}
+
+void
+SicaInterferenceGraph::SetWeights(double oneHop, double twoHop, double onPath)
+{
+  m_oneHopWeight=oneHop;
+  m_twoHopWeight=twoHop;
+  m_pathWeight=onPath;
+}
+
+void
+SicaInterferenceGraph::Build(SicaNeighbors &nb, const std::set<uint32_t> &pathNodes)
+{
+  m_vertex.clear();
+  for (uint32_t i = 1; i <= nb.GetNiNo(); i++)
+    {
+      Vertex v;
+      v.m_id=static_cast<uint32_t>(nb.GetNeighborIdByIndex(i));
+      v.m_channel=static_cast<uint32_t>(nb.GetNiChannelByIndex(i));
+      v.m_hops=nb.GetNiHops(v.m_id);
+      if (v.m_hops == 1)
+        v.m_weight=m_oneHopWeight;
+      else if (v.m_hops == 2)
+        v.m_weight=m_twoHopWeight;
+      else
+        continue; // out of the interference range
+      v.m_onPath=(pathNodes.find(v.m_id) != pathNodes.end());
+      if (v.m_onPath)
+        v.m_weight*=m_pathWeight;
+      m_vertex.push_back(v);
+      NS_LOG_DEBUG("Vertex "<< v.m_id << " channel "<< v.m_channel << " hops "<< v.m_hops << " on path "<< v.m_onPath << " weight "<< v.m_weight);
+    }
+}
+
+double
+SicaInterferenceGraph::GetConflictWeight(uint32_t channel) const
+{
+  double w=0;
+  for (std::vector<Vertex>::const_iterator i = m_vertex.begin (); i != m_vertex.end (); ++i)
+    {
+      if (i->m_channel == channel)
+        w+=i->m_weight;
+    }
+  return w;
+}
+
+double
+SicaInterferenceGraph::GetTotalWeight() const
+{
+  double w=0;
+  for (std::vector<Vertex>::const_iterator i = m_vertex.begin (); i != m_vertex.end (); ++i)
+    w+=i->m_weight;
+  return w;
+}
+
+double
+SicaInterferenceGraph::GetConflictFraction(uint32_t channel) const
+{
+  double total=GetTotalWeight();
+  if (total <= 0)
+    return 0;
+  return (GetConflictWeight(channel)/total);
+}
+
+}/*namespace ns3 */
@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICAINTERFERENCEGRAPH_H
+#define SICAINTERFERENCEGRAPH_H
+
+#include <vector>
+#include <set>
+#include <stdint.h>
+#include "ns3/sica-neighbor.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sica
+ * \defgroup interferencegraph SicaInterferenceGraph
+ */
+
+/**
+ * \brief Local interference graph of a node built from its 1-hop and 2-hop neighbors.
+ *
+ * Every neighbor within two hops is a vertex which conflicts with the node when its receiving radio
+ * is tuned to the same channel. The conflict is weighted by the hop distance (a 2-hop neighbor is a
+ * hidden terminal, it can not be heard but its transmissions collide at the node) and it is amplified
+ * when the neighbor is on a forwarding path of the node (next or previous hop of a route), since the
+ * traffic relayed by the node crosses it. With all the weights equal to 1 the conflict fraction of a
+ * channel is the fraction of neighbors tuned to it.
+ */
+class SicaInterferenceGraph
+{
+public:
+  /// A neighbor which may conflict with the node
+  struct Vertex
+  {
+    uint32_t m_id;///< Node Id of the neighbor
+    uint32_t m_channel;///< Channel of the receiving radio of the neighbor
+    uint32_t m_hops;///< Distance to the neighbor
+    bool m_onPath;///< True if the neighbor is on a forwarding path of the node
+    double m_weight;///< Weight of a conflict with the neighbor
+  };
+  /// c-tor
+  SicaInterferenceGraph();
+  /**
+   *\brief Set the weights of the conflicts
+   *\param oneHop weight of a conflict with a 1-hop neighbor
+   *\param twoHop weight of a conflict with a 2-hop neighbor
+   *\param onPath factor applied to the weight of a neighbor on a forwarding path
+   */
+  void SetWeights(double oneHop, double twoHop, double onPath);
+  /**
+   *\brief Rebuild the graph from the neighbor table
+   *\param nb the neighbor table of the node
+   *\param pathNodes the Ids of the next and previous hops of the routes crossing the node
+   */
+  void Build(SicaNeighbors &nb, const std::set<uint32_t> &pathNodes);
+  /**
+   *\brief Return the sum of the weights of the neighbors tuned to a channel
+   *\param channel the Id of the channel
+   */
+  double GetConflictWeight(uint32_t channel) const;
+  /// Return the sum of the weights of all the neighbors
+  double GetTotalWeight() const;
+  /**
+   *\brief Return the share [0,1] of the conflict weight which is on a channel, 0 if there is no neighbor
+   *\param channel the Id of the channel
+   */
+  double GetConflictFraction(uint32_t channel) const;
+  /// Return the number of vertices of the graph
+  uint32_t GetVertexNo() const {return m_vertex.size();}
+  /// Return the i th vertex of the graph, starting from 0
+  const Vertex &GetVertex(uint32_t i) const {return m_vertex[i];}
+  /// Remove all the vertices
+  void Clear(){m_vertex.clear();}
+private:
+  double m_oneHopWeight;///< weight of a 1-hop conflict
+  double m_twoHopWeight;///< weight of a 2-hop conflict
+  double m_pathWeight;///< factor of a conflict with a neighbor on a forwarding path
+  std::vector<Vertex> m_vertex;///< the neighbors within two hops
+};/*SicaInterferenceGraph*/
+
+}/*namespace ns3 */
+
+#endif /* SICAINTERFERENCEGRAPH_H */
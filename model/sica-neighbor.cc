@@ -15,9 +15,14 @@
 NS_LOG_COMPONENT_DEFINE ("SicaNeighbors");
 namespace ns3 {
 
+/// ETX of a link which delivers nothing
+static const double MAX_LINK_ETX = 100;
+/// Minimum number of data attempts to estimate the ETX from the data transmissions
+static const double MIN_LINK_TX = 4;
 
 SicaNeighbors::SicaNeighbors():
-m_ni(0)
+m_ni(0),
+m_linkWindow(16)
 {
 }
 
@@ -278,6 +283,179 @@ for (std::vector<SicaNeighbor>::iterator i = m_neighbor.begin (); i != m_neighbo
  return (chCount);
 }
 
+uint32_t
+SicaNeighbors::GetNiLoad(uint32_t id)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (i)
+    return (i->m_load);
+  return (0);
+}
+
+void
+SicaNeighbors::SetNiLoad(uint32_t id, uint32_t load)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (i)
+    i->m_load=load;
+}
+
+void
+SicaNeighbors::SetNiLifetime(uint32_t id, Time lifetime)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (i)
+    i->m_lifetime=lifetime;
+}
+
+void
+SicaNeighbors::RecordNiHello(uint32_t id, uint32_t seqNo)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (!i)
+    return;
+  if (i->m_helloSpan > 0 && seqNo <= i->m_helloSeq && i->m_helloSeq-seqNo < 32)
+    {
+      // a late hello of the window
+      i->m_helloWindow|=1u << (i->m_helloSeq-seqNo);
+      return;
+    }
+  if (i->m_helloSpan == 0 || seqNo < i->m_helloSeq)
+    {
+      // first hello or the neighbor has restarted its sequence numbers
+      i->m_helloWindow=1;
+      i->m_helloSpan=1;
+    }
+  else
+    {
+      uint32_t gap=seqNo-i->m_helloSeq;
+      i->m_helloWindow=(gap >= 32) ? 1 : ((i->m_helloWindow << gap) | 1);
+      i->m_helloSpan=std::min(i->m_helloSpan+std::min(gap,32u),32u);
+    }
+  i->m_helloSeq=seqNo;
+}
+
+void
+SicaNeighbors::SetNiForwardRatio(uint32_t id, double ratio)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (i)
+    i->m_fwdRatio=std::min(ratio,1.0);
+}
+
+void
+SicaNeighbors::RecordNiTx(uint32_t id, bool ok, uint32_t count)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (!i || count==0)
+    return;
+  i->m_tx.Record(ok,count);
+}
+
+double
+SicaNeighbors::GetNiReverseRatio(uint32_t id)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (!i)
+    return (-1);
+  return (GetReverseRatio(*i));
+}
+
+double
+SicaNeighbors::GetReverseRatio(const SicaNeighbor &ni) const
+{
+  if (ni.m_helloSpan == 0)
+    return (-1);
+  uint32_t span=std::min(ni.m_helloSpan,m_linkWindow);
+  uint32_t received=0;
+  for (uint32_t k = 0; k < span; ++k)
+    received+=(ni.m_helloWindow >> k) & 1;
+  return (static_cast<double>(received)/span);
+}
+
+double
+SicaNeighbors::GetNiForwardRatio(uint32_t id)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (i)
+    return (i->m_fwdRatio);
+  return (-1);
+}
+
+double
+SicaNeighbors::GetNiEtx(uint32_t id)
+{
+  SicaNeighbor *i =FindNeighbor(id);
+  if (!i || i->m_hopCount != 1)
+    return (-1);
+  return (GetEtx(*i));
+}
+
+double
+SicaNeighbors::GetEtx(const SicaNeighbor &ni) const
+{
+  if (ni.m_tx.GetAttempts() >= MIN_LINK_TX)
+    {
+      if (ni.m_tx.GetOk() <= 0)
+        return (MAX_LINK_ETX);
+      return (std::min(ni.m_tx.GetAttempts()/ni.m_tx.GetOk(),MAX_LINK_ETX));
+    }
+  double dr=GetReverseRatio(ni);
+  if (dr < 0)
+    return (1); // no hello counted yet
+  // without report from the neighbor the link is supposed symmetric
+  double df=(ni.m_fwdRatio < 0) ? dr : ni.m_fwdRatio;
+  if (df*dr <= 1/MAX_LINK_ETX)
+    return (MAX_LINK_ETX);
+  return (1/(df*dr));
+}
+
+double
+SicaNeighbors::GetNiLinkLossOnChannel(uint32_t channel)
+{
+  double loss=0;
+  uint32_t links=0;
+  for (std::vector<SicaNeighbor>::iterator i = m_neighbor.begin (); i != m_neighbor.end (); ++i)
+    {
+      if (i->m_hopCount==1 && i->m_neighborChannel==channel)
+        {
+          loss+=1-1/GetEtx(*i);
+          links++;
+        }
+    }
+  return (links > 0 ? loss/links : 0);
+}
+
+double
+SicaNeighbors::GetMaxEtx()
+{
+  return (MAX_LINK_ETX);
+}
+
+uint32_t
+SicaNeighbors::GetNiLoadOnChannel(uint32_t channel)
+{
+  uint32_t load=0;
+  for (std::vector<SicaNeighbor>::iterator i = m_neighbor.begin (); i != m_neighbor.end (); ++i)
+    {
+      if (i->m_hopCount==1 && i->m_neighborChannel==channel)
+        load+=i->m_load;
+    }
+  return (load);
+}
+
+uint32_t
+SicaNeighbors::GetNiLoadTotal()
+{
+  uint32_t load=0;
+  for (std::vector<SicaNeighbor>::iterator i = m_neighbor.begin (); i != m_neighbor.end (); ++i)
+    {
+      if (i->m_hopCount==1)
+        load+=i->m_load;
+    }
+  return (load);
+}
+
 uint32_t 
 SicaNeighbors::GetNiOnChannelByHops(uint32_t channel, uint32_t fromHopC , uint32_t toHopC)
 {
@@ -325,6 +503,8 @@ SicaNeighbors::PrintNeighborTable(std::ostream &os)
             os <<"\n-- Address  of the transmitting  radio:  "<< i->m_tAddr;
             os <<"\n-- Distance in hop counts:  "<<i->m_hopCount;
             os << "\n-- Update time :  "<< i->m_updateTime.GetSeconds();
+            if (i->m_hopCount==1)
+              os << "\n-- ETX :  "<< GetNiEtx(i->m_id);
             if (i->m_neighborNewChannel!=i->m_neighborChannel )
               {
                 os << "\n-- Node will switch to channel "<< i->m_neighborNewChannel << "in " << (i->m_switchTime-Simulator::Now()).GetMilliSeconds() << "ms.";
@@ -352,23 +532,23 @@ for (std::vector<SicaNeighbor>::iterator i = m_neighbor.begin (); i != m_neighbo
 
 
 void 
-SicaNeighbors::RmvExpiredNi(Time maxExpireTime){
+SicaNeighbors::RmvExpiredNi(Time maxExpireTime, std::vector<uint32_t> *removed){
   if (m_neighbor.empty())
     return;
-  std::vector<std::vector<SicaNeighbor>::iterator> eraseNi;
-for (std::vector<SicaNeighbor>::iterator i = m_neighbor.begin (); i != m_neighbor.end (); ++i)
+  std::vector<SicaNeighbor>::iterator i = m_neighbor.begin ();
+  while (i != m_neighbor.end ())
      {
-       if ((Simulator::Now()-(i->m_updateTime)) > maxExpireTime){
-         eraseNi.push_back(i);
+       Time expire=std::max(maxExpireTime,i->m_lifetime);
+       if ((Simulator::Now()-(i->m_updateTime)) > expire){
+         NS_LOG_DEBUG("RmvExpiredNi: One neighbor is erased "<< i->m_id<<" \n--Updated at "<<i->m_updateTime.GetSeconds() << "\n--Expires after "<< expire.GetSeconds() <<"\n--Sim time " << Simulator::Now().GetSeconds());
+         m_ni--;
+         if (removed)
+           removed->push_back(i->m_id);
+         i=m_neighbor.erase(i);
        }
+       else
+         ++i;
      }
- if (!eraseNi.empty())
- for (uint32_t i=0; i< eraseNi.size(); i++)
-   {
-     m_ni--;
-     m_neighbor.erase(eraseNi[i]);
-     NS_LOG_DEBUG("RmvExpiredNi: One neighbor is erased "<< eraseNi[i]->m_id<<" \n--Updated at "<<eraseNi[i]->m_updateTime.GetSeconds() << "\n--Expires after "<< maxExpireTime.GetSeconds() <<"\n--Sim time " << Simulator::Now().GetSeconds());
-   }
 }
 
 
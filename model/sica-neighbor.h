@@ -13,6 +13,7 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include "ns3/simulator.h"
 #include "ns3/header.h"
 #include "ns3/timer.h"
@@ -21,6 +22,7 @@
 #include "ns3/wifi-mac-header.h"
 #include "ns3/arp-cache.h"
 #include "ns3/nstime.h"
+#include "ns3/sica-tx-history.h"
 
 namespace ns3 {
 
@@ -54,6 +56,13 @@ public:
     Time m_updateTime;///< Time stamp, which shows the moment that the information is updated
     Time m_switchTime;///< Shows that when a neighbor will switch its receiving interface to another channel
     uint32_t m_neighborNewChannel;///< New channel for neighboring node where it will switch after m_switchTime
+    uint32_t m_load;///< Data backlog advertised by the neighbor in its hello (packets), only known for direct neighbors
+    Time m_lifetime;///< Minimum time the information is kept without update, derived from the hello interval advertised by the neighbor
+    uint32_t m_helloSeq;///< Sequence number of the last hello received from the neighbor
+    uint32_t m_helloWindow;///< Hellos received among the last sequence numbers, bit 0 is m_helloSeq
+    uint32_t m_helloSpan;///< Number of hello sequence numbers covered by m_helloWindow, 0 if no hello was received
+    double m_fwdRatio;///< Delivery ratio of our hellos reported by the neighbor, negative if unknown
+    SicaTxHistory m_tx;///< Recent data transmission attempts to the neighbor which were acknowledged or failed
     bool close; ///< Variable for future need!!
     ///c-tor
     SicaNeighbor(uint32_t id ,uint32_t h,uint32_t r,uint32_t ch,
@@ -62,7 +71,8 @@ public:
       m_id(id),m_hopCount(h),m_neighborRadio(r),m_neighborChannel(ch),
       m_rAddr(rAddr),m_tAddr(tAddr),m_updateTime(utime),
       m_switchTime(stime+Simulator::Now()),m_neighborNewChannel(nch),
-      close(false)
+      m_load(0),m_lifetime(Seconds(0)),m_helloSeq(0),m_helloWindow(0),m_helloSpan(0),
+      m_fwdRatio(-1),close(false)
     {
     }
   };
@@ -116,6 +126,40 @@ public:
   bool IsDirectNeighborByIndex (uint32_t i);
   ///Return the number of neighbors on a specific channel
   uint32_t GetNiOnChannel(uint32_t channel);
+  /// Return the data backlog advertised by the neighbor with ID id, 0 if unknown
+  uint32_t GetNiLoad(uint32_t id);
+  /// Set the data backlog advertised by the neighbor with ID id
+  void SetNiLoad(uint32_t id, uint32_t load);
+  /// Set the minimum time the information of the neighbor with ID id is kept without update
+  void SetNiLifetime(uint32_t id, Time lifetime);
+  /// Set the number of the last hello sequence numbers used to compute the delivery ratio of the hellos (at most 32)
+  void SetLinkWindow(uint32_t window){m_linkWindow=std::min(std::max(window,1u),32u);}
+  /// Record the reception of a hello with sequence number seqNo from the neighbor with ID id
+  void RecordNiHello(uint32_t id, uint32_t seqNo);
+  /// Set the delivery ratio of our hellos reported by the neighbor with ID id
+  void SetNiForwardRatio(uint32_t id, double ratio);
+  /// Record count data transmission attempts to the neighbor with ID id which were acknowledged (ok) or failed
+  void RecordNiTx(uint32_t id, bool ok, uint32_t count=1);
+  /// Return the delivery ratio of the hellos of the neighbor with ID id over the last SicaNeighbors::SetLinkWindow sequence numbers, negative if unknown
+  double GetNiReverseRatio(uint32_t id);
+  /// Return the delivery ratio of our hellos reported by the neighbor with ID id, negative if unknown
+  double GetNiForwardRatio(uint32_t id);
+  /**
+   * \brief Return the expected number of transmissions (ETX) to deliver a data packet to the neighbor with ID id
+   *
+   * It is measured from the acknowledged and failed data attempts when there are enough of them, otherwise it is
+   * 1/(df*dr) with the forward (df) and reverse (dr) delivery ratios of the hellos, a link without information costs 1.
+   * \return the ETX, at most SicaNeighbors::GetMaxEtx, or a negative value if id is not a direct neighbor
+   */
+  double GetNiEtx(uint32_t id);
+  /// Return the mean delivery failure (1-1/ETX) of the links to the direct neighbors on a specific channel, 0 if there is none
+  double GetNiLinkLossOnChannel(uint32_t channel);
+  /// Return the ETX of a link which delivers nothing
+  static double GetMaxEtx();
+  /// Return the sum of the data backlog advertised by the direct neighbors on a specific channel
+  uint32_t GetNiLoadOnChannel(uint32_t channel);
+  /// Return the sum of the data backlog advertised by all the direct neighbors
+  uint32_t GetNiLoadTotal();
   ///Return the number of neighbors which are far as hopC and have a radio a specific channel
   uint32_t GetNiOnChannelByHops(uint32_t channel, uint32_t fromHopC , uint32_t toHopC);
   /// Return the IP address of the receiving radio of i th neighbor from neighbor list
@@ -128,13 +172,19 @@ public:
   uint32_t GetNiNo(){return m_ni;}
   /// Return the number of neighbors from distance fromHopC to toHopC 
   uint32_t GetNiNobyHops(uint32_t fromHopC , uint32_t toHopC);
-  /// Remove expired neighbor information
-  void RmvExpiredNi(Time maxExpireTime);
+  /// Remove expired neighbor information, a neighbor is kept at least for its own lifetime (SicaNeighbors::SetNiLifetime), the Ids of the removed neighbors are added to removed if it is given
+  void RmvExpiredNi(Time maxExpireTime, std::vector<uint32_t> *removed=0);
   /// Cleare neighbor list
   void Clear(){m_neighbor.clear(); m_ni=0;}
 private:
+  /// Return the delivery ratio of the hellos of a neighbor, see SicaNeighbors::GetNiReverseRatio
+  double GetReverseRatio(const SicaNeighbor &ni) const;
+  /// Return the ETX of the link to a direct neighbor, see SicaNeighbors::GetNiEtx
+  double GetEtx(const SicaNeighbor &ni) const;
   /// number of neighbors 
   uint32_t m_ni;
+  /// number of hello sequence numbers used to compute the delivery ratio of the hellos
+  uint32_t m_linkWindow;
   /// List of Neighbors 
   std::vector<SicaNeighbor> m_neighbor;
 };/*SicaNeighbors*/
@@ -12,27 +12,78 @@
 #include "ns3/log.h"
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("SicaHelloHeader");
 
 namespace ns3
 {
 
+const uint32_t SicaHelloHeader::CLCPF_FRACTION_BITS;
+
+/// Return the number of bytes of a varint
+static uint32_t
+VarintSize (uint32_t v)
+{
+  return (1+(v >= (1u << 7))+(v >= (1u << 14))+(v >= (1u << 21))+(v >= (1u << 28)));
+}
+
+/// Write a varint, 7 bits per byte starting from the least significant ones
+static void
+WriteVarint (Buffer::Iterator &i, uint32_t v)
+{
+  while (v >= 0x80)
+    {
+      i.WriteU8(static_cast<uint8_t>(v | 0x80));
+      v >>= 7;
+    }
+  i.WriteU8(static_cast<uint8_t>(v));
+}
+
+/// Read a varint
+static uint32_t
+ReadVarint (Buffer::Iterator &i)
+{
+  uint32_t v=0;
+  uint8_t b=0x80;
+  for (uint32_t shift=0; (b & 0x80) && shift < 35; shift+=7)
+    {
+      b=i.ReadU8();
+      v|=static_cast<uint32_t>(b & 0x7f) << shift;
+    }
+  return v;
+}
+
+/// Order the neighbors by node ID
+static bool
+NiIdLess (const std::pair<uint32_t, uint8_t> &ni, uint32_t id)
+{
+  return (ni.first < id);
+}
+
   SicaHelloHeader::SicaHelloHeader(uint32_t sqNo,uint32_t origin,
                                    Time originTime,uint8_t radios,uint8_t rCh,
-                                   uint8_t extBw,uint8_t rNewCh,
+                                   uint16_t extBw,uint8_t rNewCh,
                                    Address rAddr,Time rSwitchTime,
                                    Time rSenseTime):
+  m_format(FULL_FORMAT),
   m_seqNo(sqNo),
   m_origin(origin),
   m_originTime(originTime.GetMilliSeconds()),
   m_radios(radios),
   m_rCh(rCh),
   m_extBw(extBw),
+  m_extBwConf(0),
+  m_load(0),
   m_rNewCh(rNewCh),
+  m_version(0),
+  m_flags(0),
+  m_part(0),
+  m_parts(1),
   m_rAddr(rAddr),
   m_rSwitchTime(rSwitchTime.GetMilliSeconds()),
   m_rSenseTime( rSenseTime.GetMilliSeconds()),
+  m_helloInterval(0),
   m_ni(0),
   m_clcpf(0),
   m_ttl(1)
@@ -62,15 +113,197 @@ SicaHelloHeader::GetInstanceTypeId () const
 uint32_t 
 SicaHelloHeader::GetSerializedSize () const
 {
-  return (37+m_rAddr.GetLength()+5*GetNiNo());
+  if (m_format == COMPACT_FORMAT)
+    return (GetCompactSize());
+  return (50+(m_flags & MULTI_PART ? 2 : 0)+m_rAddr.GetLength()+(m_flags & LINK_QUALITY ? 6 : 5)*GetNiNo());
+}
+
+uint8_t
+SicaHelloHeader::GetCompactFields () const
+{
+  return ((m_rAddr.GetLength() > 0 ? ADDR_PRESENT : 0)
+          | (m_extBw > 0 || m_extBwConf > 0 ? BX_PRESENT : 0)
+          | (m_load > 0 ? LOAD_PRESENT : 0)
+          | (m_rNewCh != m_rCh || m_rSwitchTime > 0 ? SWITCH_PRESENT : 0)
+          | (m_rSenseTime > 0 ? SENSE_PRESENT : 0)
+          | (m_helloInterval > 0 ? INTERVAL_PRESENT : 0)
+          | (m_version > 0 || m_flags > 0 ? STATE_PRESENT : 0)
+          | (GetFixedCLCPF() > 0 || m_ttl != 1 ? URBANX_PRESENT : 0));
+}
+
+uint32_t
+SicaHelloHeader::GetFixedCLCPF () const
+{
+  if (m_clcpf <= 0)
+    return 0;
+  return (static_cast<uint32_t>(m_clcpf*(1 << CLCPF_FRACTION_BITS)+0.5));
 }
 
+uint32_t
+SicaHelloHeader::GetCompactSize () const
+{
+  uint8_t fields=GetCompactFields();
+  uint32_t size=4+VarintSize(m_seqNo)+VarintSize(m_origin)+VarintSize(m_originTime);
+  if (fields & ADDR_PRESENT)
+    size+=1+m_rAddr.GetLength();
+  if (fields & BX_PRESENT)
+    size+=3;
+  if (fields & LOAD_PRESENT)
+    size+=VarintSize(m_load);
+  if (fields & SWITCH_PRESENT)
+    size+=1+VarintSize(m_rSwitchTime);
+  if (fields & SENSE_PRESENT)
+    size+=VarintSize(m_rSenseTime);
+  if (fields & INTERVAL_PRESENT)
+    size+=VarintSize(m_helloInterval);
+  if (fields & STATE_PRESENT)
+    size+=(m_flags & MULTI_PART ? 5 : 3);
+  if (fields & URBANX_PRESENT)
+    size+=VarintSize(GetFixedCLCPF())+1;
+  size+=VarintSize(m_neighborRChannel.size())+m_neighborRChannel.size();
+  uint32_t prev=0;
+  for (NiRChannels::const_iterator j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
+    {
+      size+=VarintSize(j->first-prev);
+      prev=j->first;
+    }
+  if (m_flags & LINK_QUALITY)
+    size+=m_neighborRChannel.size();
+  return size;
+}
 
+void
+SicaHelloHeader::SerializeCompact (Buffer::Iterator &i) const
+{
+  uint8_t fields=GetCompactFields();
+  i.WriteU8(fields);
+  i.WriteU8(m_radios);
+  i.WriteU8(m_rCh);
+  WriteVarint(i,m_seqNo);
+  WriteVarint(i,m_origin);
+  WriteVarint(i,m_originTime);
+  if (fields & ADDR_PRESENT)
+    {
+      i.WriteU8(m_rAddr.GetLength());
+      WriteTo(i,m_rAddr);
+    }
+  if (fields & BX_PRESENT)
+    {
+      i.WriteHtonU16(m_extBw);
+      i.WriteU8(m_extBwConf);
+    }
+  if (fields & LOAD_PRESENT)
+    WriteVarint(i,m_load);
+  if (fields & SWITCH_PRESENT)
+    {
+      i.WriteU8(m_rNewCh);
+      WriteVarint(i,m_rSwitchTime);
+    }
+  if (fields & SENSE_PRESENT)
+    WriteVarint(i,m_rSenseTime);
+  if (fields & INTERVAL_PRESENT)
+    WriteVarint(i,m_helloInterval);
+  if (fields & STATE_PRESENT)
+    {
+      i.WriteHtonU16(m_version);
+      i.WriteU8(m_flags);
+      if (m_flags & MULTI_PART)
+        {
+          i.WriteU8(m_part);
+          i.WriteU8(m_parts);
+        }
+    }
+  if (fields & URBANX_PRESENT)
+    {
+      WriteVarint(i,GetFixedCLCPF());
+      i.WriteU8(static_cast<uint8_t>(std::min(m_ttl,255u)));
+    }
+  WriteVarint(i,m_neighborRChannel.size());
+  uint32_t prev=0;
+  for (NiRChannels::const_iterator j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
+    {
+      WriteVarint(i,j->first-prev);
+      i.WriteU8(j->second);
+      prev=j->first;
+    }
+  if (m_flags & LINK_QUALITY)
+    WriteNiQuality(i);
+}
 
+void
+SicaHelloHeader::DeserializeCompact (Buffer::Iterator &i)
+{
+  uint8_t fields=i.ReadU8();
+  m_radios=i.ReadU8();
+  m_rCh=i.ReadU8();
+  m_seqNo=ReadVarint(i);
+  m_origin=ReadVarint(i);
+  m_originTime=ReadVarint(i);
+  m_rAddr=Address();
+  if (fields & ADDR_PRESENT)
+    ReadFrom(i,m_rAddr,i.ReadU8());
+  m_extBw=0;
+  m_extBwConf=0;
+  if (fields & BX_PRESENT)
+    {
+      m_extBw=i.ReadNtohU16();
+      m_extBwConf=i.ReadU8();
+    }
+  m_load=(fields & LOAD_PRESENT) ? ReadVarint(i) : 0;
+  m_rNewCh=m_rCh;
+  m_rSwitchTime=0;
+  if (fields & SWITCH_PRESENT)
+    {
+      m_rNewCh=i.ReadU8();
+      m_rSwitchTime=ReadVarint(i);
+    }
+  m_rSenseTime=(fields & SENSE_PRESENT) ? ReadVarint(i) : 0;
+  m_helloInterval=(fields & INTERVAL_PRESENT) ? ReadVarint(i) : 0;
+  m_version=0;
+  m_flags=0;
+  m_part=0;
+  m_parts=1;
+  if (fields & STATE_PRESENT)
+    {
+      m_version=i.ReadNtohU16();
+      m_flags=i.ReadU8();
+      if (m_flags & MULTI_PART)
+        {
+          m_part=i.ReadU8();
+          m_parts=i.ReadU8();
+        }
+    }
+  m_clcpf=0;
+  m_ttl=1;
+  if (fields & URBANX_PRESENT)
+    {
+      m_clcpf=static_cast<double>(ReadVarint(i))/(1 << CLCPF_FRACTION_BITS);
+      m_ttl=i.ReadU8();
+    }
+  uint32_t niNo=ReadVarint(i);
+  m_ni=niNo;
+  m_neighborRChannel.clear();
+  m_neighborRChannel.reserve(niNo);
+  uint32_t id=0;
+  for (uint32_t k = 0; k < niNo; ++k)
+    {
+      id+=ReadVarint(i);
+      m_neighborRChannel.push_back(std::make_pair(id,i.ReadU8()));
+    }
+  m_niQuality.clear();
+  if (m_flags & LINK_QUALITY)
+    ReadNiQuality(i);
+}
 
 void 
 SicaHelloHeader::Serialize (Buffer::Iterator i) const
 {
+  i.WriteU8(m_format);
+  if (m_format == COMPACT_FORMAT)
+    {
+      SerializeCompact(i);
+      return;
+    }
   uint32_t deciPart= static_cast <uint32_t>(m_clcpf);
   double fPart=m_clcpf-deciPart;
   uint32_t fIntPart=static_cast<uint32_t>(fPart*1000);
@@ -79,52 +312,85 @@ SicaHelloHeader::Serialize (Buffer::Iterator i) const
   i.WriteHtonU32 (m_originTime);
   i.WriteU8(m_radios);
   i.WriteU8(m_rCh);
-  i.WriteU8(m_extBw);
+  i.WriteHtonU16(m_extBw);
+  i.WriteU8(m_extBwConf);
+  i.WriteHtonU16(m_load);
   i.WriteU8(m_rNewCh);
+  i.WriteHtonU16(m_version);
+  i.WriteU8(m_flags);
+  if (m_flags & MULTI_PART)
+    {
+      i.WriteU8(m_part);
+      i.WriteU8(m_parts);
+    }
+  i.WriteU8(m_rAddr.GetLength());
   WriteTo(i,m_rAddr);
   i.WriteHtonU32 (m_rSwitchTime);
   i.WriteHtonU32 (m_rSenseTime);
+  i.WriteHtonU32 (m_helloInterval);
+  NS_ASSERT_MSG (m_ni < 256,"can't support more than 255 neighbor information in single hello of full format");
   i.WriteU8(m_ni);
   i.WriteU32(deciPart);
   i.WriteU32(fIntPart);
   i.WriteU32(m_ttl);
-  if (m_ni > 0){
-    std::map<uint32_t, uint8_t>::const_iterator j;
-    for (j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
-      {
-        i.WriteU32((*j).first);
-        i.WriteU8 ((*j).second);
-      }
-  }
+  for (NiRChannels::const_iterator j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
+    {
+      i.WriteU32((*j).first);
+      i.WriteU8 ((*j).second);
+    }
+  if (m_flags & LINK_QUALITY)
+    WriteNiQuality(i);
 }
 
 uint32_t 
 SicaHelloHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
+  m_format=i.ReadU8 ();
+  if (m_format == COMPACT_FORMAT)
+    {
+      DeserializeCompact(i);
+      uint32_t dist = i.GetDistanceFrom (start);
+      NS_ASSERT (dist == GetSerializedSize ());
+      return dist;
+    }
   m_seqNo=i.ReadU32 ();
   m_origin=i.ReadU32 ();
   m_originTime=i.ReadNtohU32 ();
   m_radios=i.ReadU8 ();
   m_rCh=i.ReadU8 ();
-  m_extBw=i.ReadU8 ();
+  m_extBw=i.ReadNtohU16 ();
+  m_extBwConf=i.ReadU8 ();
+  m_load=i.ReadNtohU16 ();
   m_rNewCh=i.ReadU8 ();
-  ReadFrom(i,m_rAddr,6);
+  m_version=i.ReadNtohU16 ();
+  m_flags=i.ReadU8 ();
+  m_part=0;
+  m_parts=1;
+  if (m_flags & MULTI_PART)
+    {
+      m_part=i.ReadU8 ();
+      m_parts=i.ReadU8 ();
+    }
+  ReadFrom(i,m_rAddr,i.ReadU8 ());
   m_rSwitchTime=i.ReadNtohU32 ();
   m_rSenseTime=i.ReadNtohU32 ();
+  m_helloInterval=i.ReadNtohU32 ();
   m_ni=i.ReadU8 ();
   uint32_t deciPart=i.ReadU32();
   double fIntPart=i.ReadU32();
   m_clcpf=deciPart+(fIntPart/1000);
   m_ttl=i.ReadU32();
-  uint32_t id;
-  uint8_t rch;
-  for (uint8_t k = 0; k < m_ni; ++k)
+  m_neighborRChannel.clear();
+  m_neighborRChannel.reserve(m_ni);
+  for (uint16_t k = 0; k < m_ni; ++k)
     {
-      id= i.ReadU32();
-      rch=i.ReadU8 ();
-      m_neighborRChannel.insert(std::make_pair (id,rch));
+      uint32_t id= i.ReadU32();
+      m_neighborRChannel.push_back(std::make_pair (id,i.ReadU8 ()));
     }
+  m_niQuality.clear();
+  if (m_flags & LINK_QUALITY)
+    ReadNiQuality(i);
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
   return dist;
@@ -136,13 +402,18 @@ SicaHelloHeader::Print(std::ostream &os) const
 {
   os<< "---------------------------------------------------" ;
   os<< "\nSica Hello Header...";
+  os << "\nFormat is : "<< static_cast <uint32_t>(m_format) ;
   os << "\nSequence number is : "<< m_seqNo ;
   os << "\nOriginator (ID): "<< m_origin ;
   os <<"\nTime of origin " << m_originTime ;
   os<<"\n#radios is : " <<  static_cast <uint32_t> (m_radios); 
   os <<"\nReceiving MAC is : " << m_rAddr;
   os <<"\nReceiving channel is : "<< static_cast <uint32_t>(m_rCh);
-  os  <<"\nEstimated Ext. BW is: " << static_cast <uint32_t>(m_extBw);
+  os  <<"\nEstimated Ext. BW is: " << m_extBw/256.0 << " confidence "<< m_extBwConf/255.0;
+  os  <<"\nData backlog is: " << m_load << " packets";
+  os  <<"\nVersion is: " << m_version << " flags " << static_cast <uint32_t>(m_flags);
+  if (m_flags & MULTI_PART)
+    os  <<"\nPart " << static_cast <uint32_t>(m_part) << " of " << static_cast <uint32_t>(m_parts);
   os << "\n CLCPF is: "<< m_clcpf;
   os << "\n TTL  is: "<< m_ttl;
   os <<"\n" ;
@@ -150,24 +421,39 @@ SicaHelloHeader::Print(std::ostream &os) const
     os << "\nThere is an announcement for  switching to channel number: " << static_cast <uint32_t>(m_rNewCh) << " in " << m_rSwitchTime << " miliseconds" ;
   if (m_rSenseTime > 0)
     os<< "\nSenseing timer is "<< m_rSenseTime << " miliseconds";  
+  if (m_helloInterval > 0)
+    os<< "\nNext hello in "<< m_helloInterval << " miliseconds";  
   if (m_ni >0)
     {
-      std::map<uint32_t, uint8_t>::const_iterator j;
+      NiRChannels::const_iterator j;
       os << "\nThere are information about " << static_cast <uint32_t>(m_ni) << " neighbors\n";
       for (j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
-        os << "Node ID: "<<(*j).first << ",R-Channel:  " << static_cast <uint32_t>((*j).second)<<"\n";
+        {
+          os << "Node ID: "<<(*j).first << ",R-Channel:  " << static_cast <uint32_t>((*j).second);
+          if (m_flags & LINK_QUALITY)
+            os << ",Link quality: " << GetNiQuality((*j).first);
+          os << "\n";
+        }
       
     }
 }
 
+SicaHelloHeader::NiRChannels::const_iterator
+SicaHelloHeader::FindNi (uint32_t ni) const
+{
+  return (std::lower_bound(m_neighborRChannel.begin (),m_neighborRChannel.end (),ni,NiIdLess));
+}
+
 bool 
 SicaHelloHeader::AddNiRChannel (uint32_t ni, uint8_t rCh)
 {
-  if (m_neighborRChannel.find (ni) != m_neighborRChannel.end ())
+  NiRChannels::const_iterator i = FindNi (ni);
+  if (i != m_neighborRChannel.end () && i->first == ni)
     return true;
 
-  NS_ASSERT_MSG (GetNiNo() < 255,"can't support more than 255 neighbor information in single hello"); 
-  m_neighborRChannel.insert (std::make_pair (ni,rCh));
+  if (GetNiNo() == 65535)
+    return false;
+  m_neighborRChannel.insert (m_neighborRChannel.begin ()+(i-m_neighborRChannel.begin ()),std::make_pair (ni,rCh));
   m_ni++;
   return true;
 }
@@ -178,9 +464,8 @@ SicaHelloHeader::RemoveNiRChannel (std::pair<uint32_t, uint8_t> & ni)
   if (m_neighborRChannel.empty ())
     return false;
 
-  std::map<uint32_t, uint8_t>::iterator i =m_neighborRChannel.begin();
-  ni=(*i);
-  m_neighborRChannel.erase (i);
+  ni=m_neighborRChannel.front ();
+  m_neighborRChannel.erase (m_neighborRChannel.begin ());
   m_ni--;
   return true;
 }
@@ -190,40 +475,429 @@ SicaHelloHeader::DeleteNiRChannel (uint32_t ni)
   if (m_neighborRChannel.empty ())
     return false;
   else { 
-    std::map<uint32_t, uint8_t>::iterator i = m_neighborRChannel.find (ni);
-    if (i != m_neighborRChannel.end()){
-      m_neighborRChannel.erase (i);
+    NiRChannels::const_iterator i = FindNi (ni);
+    if (i != m_neighborRChannel.end() && i->first == ni){
+      m_neighborRChannel.erase (m_neighborRChannel.begin ()+(i-m_neighborRChannel.begin ()));
       m_ni--;
     }
   }
   return true;
 }
+
+int32_t 
+SicaHelloHeader::GetNiRChannel (uint32_t ni) const
+{
+  NiRChannels::const_iterator i = FindNi (ni);
+  if (i == m_neighborRChannel.end() || i->first != ni)
+    return (-1);
+  return (i->second);
+}
+
+void
+SicaHelloHeader::KeepNiRange (uint32_t first, uint32_t count)
+{
+  first=std::min<uint32_t>(first,m_neighborRChannel.size());
+  count=std::min<uint32_t>(count,m_neighborRChannel.size()-first);
+  m_neighborRChannel.erase (m_neighborRChannel.begin ()+first+count,m_neighborRChannel.end ());
+  m_neighborRChannel.erase (m_neighborRChannel.begin (),m_neighborRChannel.begin ()+first);
+  m_ni=count;
+}
+
+void
+SicaHelloHeader::SetNiQuality (uint32_t ni, double ratio)
+{
+  m_niQuality[ni]=static_cast<uint8_t>(std::min(std::max(ratio,0.0),1.0)*255+0.5);
+  m_flags|=LINK_QUALITY;
+}
+
+double
+SicaHelloHeader::GetNiQuality (uint32_t ni) const
+{
+  std::map<uint32_t, uint8_t>::const_iterator i=m_niQuality.find(ni);
+  if (!(m_flags & LINK_QUALITY) || i == m_niQuality.end())
+    return (-1);
+  return (i->second/255.0);
+}
+
+void
+SicaHelloHeader::WriteNiQuality (Buffer::Iterator &i) const
+{
+  // in the order of the neighbors, 0 for a neighbor without measure
+  for (NiRChannels::const_iterator j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
+    {
+      std::map<uint32_t, uint8_t>::const_iterator q=m_niQuality.find(j->first);
+      i.WriteU8(q == m_niQuality.end() ? 0 : q->second);
+    }
+}
+
+void
+SicaHelloHeader::ReadNiQuality (Buffer::Iterator &i)
+{
+  for (NiRChannels::const_iterator j = m_neighborRChannel.begin (); j != m_neighborRChannel.end (); ++j)
+    {
+      uint8_t q=i.ReadU8();
+      if (q > 0)
+        m_niQuality[j->first]=q;
+    }
+}
+
+void
+SicaHelloHeader::SetPart (uint8_t part, uint8_t parts)
+{
+  m_part=part;
+  m_parts=parts;
+  if (parts > 1)
+    m_flags|=MULTI_PART;
+  else
+    m_flags&=~MULTI_PART;
+}
   
 
 void 
 SicaHelloHeader::Clear()
 {
   m_neighborRChannel.clear();
+  m_niQuality.clear();
   m_seqNo=0;
   m_origin=0;
   m_originTime=0;
   m_radios=0;
   m_rCh=0;
   m_extBw=0;
+  m_extBwConf=0;
   m_rNewCh=0;
+  m_version=0;
+  m_flags=0;
+  m_part=0;
+  m_parts=1;
   m_rAddr=Address();
   m_rSwitchTime=0;
   m_rSenseTime=0;
+  m_helloInterval=0;
   m_ni=0;
   m_clcpf=0;
   m_ttl=0;
 }
 
 
+//////////////////////////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (SicaHelloDeltaHeader);
+
+SicaHelloDeltaHeader::SicaHelloDeltaHeader():
+  m_seqNo(0),
+  m_origin(0),
+  m_originTime(0),
+  m_version(0),
+  m_flags(0),
+  m_fields(0),
+  m_rCh(0),
+  m_rNewCh(0),
+  m_extBw(0),
+  m_extBwConf(0),
+  m_rSwitchTime(0),
+  m_rSenseTime(0),
+  m_load(0),
+  m_helloInterval(0)
+{}
+
+
+TypeId 
+SicaHelloDeltaHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId("ns3::SicaHelloDeltaHeader")
+   .SetParent<Header> ()
+  .AddConstructor<SicaHelloDeltaHeader> ()
+      ;
+  return tid;
+}
+
+TypeId
+SicaHelloDeltaHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+
+uint32_t 
+SicaHelloDeltaHeader::GetSerializedSize () const
+{
+  uint32_t size=17+5*m_changes.size();
+  if (m_fields & CHANNEL_FIELD)
+    size+=2;
+  if (m_fields & BX_FIELD)
+    size+=3;
+  if (m_fields & SWITCH_FIELD)
+    size+=4;
+  if (m_fields & SENSE_FIELD)
+    size+=4;
+  if (m_fields & LOAD_FIELD)
+    size+=2;
+  if (m_fields & INTERVAL_FIELD)
+    size+=4;
+  return (size);
+}
+
+
+void 
+SicaHelloDeltaHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU32(m_seqNo);
+  i.WriteU32(m_origin);
+  i.WriteHtonU32 (m_originTime);
+  i.WriteHtonU16(m_version);
+  i.WriteU8(m_flags);
+  i.WriteU8(m_fields);
+  if (m_fields & CHANNEL_FIELD)
+    {
+      i.WriteU8(m_rCh);
+      i.WriteU8(m_rNewCh);
+    }
+  if (m_fields & BX_FIELD)
+    {
+      i.WriteHtonU16(m_extBw);
+      i.WriteU8(m_extBwConf);
+    }
+  if (m_fields & SWITCH_FIELD)
+    i.WriteHtonU32 (m_rSwitchTime);
+  if (m_fields & SENSE_FIELD)
+    i.WriteHtonU32 (m_rSenseTime);
+  if (m_fields & LOAD_FIELD)
+    i.WriteHtonU16(m_load);
+  if (m_fields & INTERVAL_FIELD)
+    i.WriteHtonU32 (m_helloInterval);
+  i.WriteU8(m_changes.size());
+  for (std::map<uint32_t, uint8_t>::const_iterator j = m_changes.begin (); j != m_changes.end (); ++j)
+    {
+      i.WriteU32((*j).first);
+      i.WriteU8 ((*j).second);
+    }
+}
+
+uint32_t 
+SicaHelloDeltaHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_seqNo=i.ReadU32 ();
+  m_origin=i.ReadU32 ();
+  m_originTime=i.ReadNtohU32 ();
+  m_version=i.ReadNtohU16 ();
+  m_flags=i.ReadU8 ();
+  m_fields=i.ReadU8 ();
+  if (m_fields & CHANNEL_FIELD)
+    {
+      m_rCh=i.ReadU8 ();
+      m_rNewCh=i.ReadU8 ();
+    }
+  if (m_fields & BX_FIELD)
+    {
+      m_extBw=i.ReadNtohU16 ();
+      m_extBwConf=i.ReadU8 ();
+    }
+  if (m_fields & SWITCH_FIELD)
+    m_rSwitchTime=i.ReadNtohU32 ();
+  if (m_fields & SENSE_FIELD)
+    m_rSenseTime=i.ReadNtohU32 ();
+  if (m_fields & LOAD_FIELD)
+    m_load=i.ReadNtohU16 ();
+  if (m_fields & INTERVAL_FIELD)
+    m_helloInterval=i.ReadNtohU32 ();
+  uint8_t changes=i.ReadU8 ();
+  m_changes.clear();
+  for (uint8_t k = 0; k < changes; ++k)
+    {
+      uint32_t id= i.ReadU32();
+      m_changes[id]=i.ReadU8 ();
+    }
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+
+void
+SicaHelloDeltaHeader::Print(std::ostream &os) const
+{
+  os<< "---------------------------------------------------" ;
+  os<< "\nSica Incremental Hello Header...";
+  os << "\nSequence number is : "<< m_seqNo ;
+  os << "\nOriginator (ID): "<< m_origin ;
+  os << "\nVersion is: " << m_version << " fields " << static_cast <uint32_t>(m_fields);
+  os << "\nThere are " << m_changes.size() << " neighbor changes\n";
+  for (std::map<uint32_t, uint8_t>::const_iterator j = m_changes.begin (); j != m_changes.end (); ++j)
+    os << "Node ID: "<<(*j).first << ",R-Channel:  " << static_cast <uint32_t>((*j).second)<<"\n";
+}
+
+/// Return the timer of the previous hello minus the time elapsed between the two hellos
+static uint32_t
+ElapsedTimer (uint32_t timer, uint32_t elapsed)
+{
+  return (timer > elapsed ? timer-elapsed : 0);
+}
+
+SicaHelloDeltaHeader
+SicaHelloDeltaHeader::Diff (SicaHelloHeader prev, SicaHelloHeader cur)
+{
+  SicaHelloDeltaHeader delta;
+  delta.m_seqNo=cur.GetSeqNo();
+  delta.m_origin=cur.GetOrigin();
+  delta.m_originTime=cur.GetOriginTime().GetMilliSeconds();
+  delta.m_version=cur.GetVersion();
+  delta.m_flags=cur.GetFlags();
+  uint32_t elapsed=delta.m_originTime-prev.GetOriginTime().GetMilliSeconds();
+  delta.m_rCh=cur.GetRChannel();
+  delta.m_rNewCh=cur.GetRNewChannel();
+  if (delta.m_rCh != prev.GetRChannel() || delta.m_rNewCh != prev.GetRNewChannel())
+    delta.m_fields|=CHANNEL_FIELD;
+  delta.m_extBw=cur.GetExtBw();
+  delta.m_extBwConf=static_cast<uint8_t>(cur.GetExtBwConfidence()*255+0.5);
+  if (delta.m_extBw != prev.GetExtBw() || cur.GetExtBwConfidence() != prev.GetExtBwConfidence())
+    delta.m_fields|=BX_FIELD;
+  delta.m_rSwitchTime=cur.GetTimeToSwitch().GetMilliSeconds();
+  if (delta.m_rSwitchTime != ElapsedTimer(prev.GetTimeToSwitch().GetMilliSeconds(),elapsed))
+    delta.m_fields|=SWITCH_FIELD;
+  delta.m_rSenseTime=cur.GetSenseTime().GetMilliSeconds();
+  if (delta.m_rSenseTime != ElapsedTimer(prev.GetSenseTime().GetMilliSeconds(),elapsed))
+    delta.m_fields|=SENSE_FIELD;
+  delta.m_load=cur.GetLoad();
+  if (delta.m_load != prev.GetLoad())
+    delta.m_fields|=LOAD_FIELD;
+  delta.m_helloInterval=cur.GetHelloInterval().GetMilliSeconds();
+  if (delta.m_helloInterval != prev.GetHelloInterval().GetMilliSeconds())
+    delta.m_fields|=INTERVAL_FIELD;
+  const SicaHelloHeader::NiRChannels &after=cur.GetNiRChannels();
+  for (SicaHelloHeader::NiRChannels::const_iterator j = after.begin (); j != after.end (); ++j)
+    if (prev.GetNiRChannel(j->first) != j->second)
+      delta.m_changes[j->first]=j->second;
+  const SicaHelloHeader::NiRChannels &before=prev.GetNiRChannels();
+  for (SicaHelloHeader::NiRChannels::const_iterator k = before.begin (); k != before.end (); ++k)
+    if (cur.GetNiRChannel(k->first) < 0)
+      delta.m_changes[k->first]=0;
+  NS_ASSERT_MSG (delta.m_changes.size() < 256,"can't support more than 255 neighbor changes in single hello");
+  return delta;
+}
+
+void
+SicaHelloDeltaHeader::Apply (SicaHelloHeader &base) const
+{
+  uint32_t elapsed=m_originTime-base.GetOriginTime().GetMilliSeconds();
+  base.SetSeqNo(m_seqNo);
+  base.SetOriginTime(MilliSeconds(m_originTime));
+  base.SetVersion(m_version);
+  base.SetFlags(m_flags);
+  if (m_fields & CHANNEL_FIELD)
+    {
+      base.SetRChannel(m_rCh);
+      base.SetRNewChannel(m_rNewCh);
+    }
+  if (m_fields & BX_FIELD)
+    {
+      base.SetExtBw(m_extBw);
+      base.SetExtBwConfidence(m_extBwConf/255.0);
+    }
+  if (m_fields & SWITCH_FIELD)
+    base.SetTimeToSwitch(MilliSeconds(m_rSwitchTime));
+  else
+    base.SetTimeToSwitch(MilliSeconds(ElapsedTimer(base.GetTimeToSwitch().GetMilliSeconds(),elapsed)));
+  if (m_fields & SENSE_FIELD)
+    base.SetSenseTime(MilliSeconds(m_rSenseTime));
+  else
+    base.SetSenseTime(MilliSeconds(ElapsedTimer(base.GetSenseTime().GetMilliSeconds(),elapsed)));
+  if (m_fields & LOAD_FIELD)
+    base.SetLoad(m_load);
+  if (m_fields & INTERVAL_FIELD)
+    base.SetHelloInterval(MilliSeconds(m_helloInterval));
+  for (std::map<uint32_t, uint8_t>::const_iterator j = m_changes.begin (); j != m_changes.end (); ++j)
+    {
+      base.DeleteNiRChannel(j->first);
+      if (j->second > 0)
+        base.AddNiRChannel(j->first,j->second);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (SicaSwitchHeader);
+
+SicaSwitchHeader::SicaSwitchHeader(uint32_t sqNo,uint32_t origin,
+                                   uint8_t rCh,uint8_t rNewCh,
+                                   Time rSwitchTime):
+  m_seqNo(sqNo),
+  m_origin(origin),
+  m_rCh(rCh),
+  m_rNewCh(rNewCh),
+  m_rSwitchTime(rSwitchTime.GetMicroSeconds())
+{}
+
+
+TypeId 
+SicaSwitchHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId("ns3::SicaSwitchHeader")
+   .SetParent<Header> ()
+  .AddConstructor<SicaSwitchHeader> ()
+      ;
+  return tid;
+}
+
+TypeId
+SicaSwitchHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+
+uint32_t 
+SicaSwitchHeader::GetSerializedSize () const
+{
+  return (14);
+}
+
+
+void 
+SicaSwitchHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU32(m_seqNo);
+  i.WriteU32(m_origin);
+  i.WriteU8(m_rCh);
+  i.WriteU8(m_rNewCh);
+  i.WriteHtonU32 (m_rSwitchTime);
+}
+
+uint32_t 
+SicaSwitchHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_seqNo=i.ReadU32 ();
+  m_origin=i.ReadU32 ();
+  m_rCh=i.ReadU8 ();
+  m_rNewCh=i.ReadU8 ();
+  m_rSwitchTime=i.ReadNtohU32 ();
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+
+void
+SicaSwitchHeader::Print(std::ostream &os) const
+{
+  os<< "---------------------------------------------------" ;
+  os<< "\nSica Switch Header...";
+  os << "\nSequence number is : "<< m_seqNo ;
+  os << "\nOriginator (ID): "<< m_origin ;
+  os <<"\nReceiving channel is : "<< static_cast <uint32_t>(m_rCh);
+  os << "\nSwitch to channel number: " << static_cast <uint32_t>(m_rNewCh) << " in " << m_rSwitchTime << " microseconds" ;
+}
+
+
 //////////////////////////////////////////////////////////////
 
 NS_OBJECT_ENSURE_REGISTERED (SicaHeader);
 
+const uint32_t SicaHeader::MAX_TRAFFIC_CLASSES;
+
 SicaHeader::SicaHeader(uint32_t sqNo,uint32_t origin,
                        uint32_t dest,uint32_t nextHop,
                        Time originTime):
@@ -231,7 +905,13 @@ SicaHeader::SicaHeader(uint32_t sqNo,uint32_t origin,
   m_origin(origin),
   m_dest(dest),
   m_nextHop(nextHop),
-  m_originTime(originTime.GetMilliSeconds())
+  m_originTime(originTime.GetMilliSeconds()),
+  m_flags(0),
+  m_rCh(0),
+  m_rNewCh(0),
+  m_extBw(0),
+  m_extBwConf(0),
+  m_rSwitchTime(0)
 {}
 
 
@@ -255,7 +935,18 @@ SicaHeader::GetInstanceTypeId () const
 uint32_t 
 SicaHeader::GetSerializedSize () const
 {
-  return (20);
+  return (21+(HasStateTrailer() ? 9 : 0));
+}
+
+void
+SicaHeader::SetStateTrailer(uint8_t rCh, uint8_t rNewCh, Time switchTime, uint16_t extBw, double confidence)
+{
+  m_flags|=STATE_TRAILER;
+  m_rCh=rCh;
+  m_rNewCh=rNewCh;
+  m_rSwitchTime=switchTime.GetMilliSeconds();
+  m_extBw=extBw;
+  m_extBwConf=static_cast<uint8_t>(std::min(std::max(confidence,0.0),1.0)*255+0.5);
 }
 
 
@@ -267,7 +958,15 @@ SicaHeader::Serialize (Buffer::Iterator i) const
   i.WriteU32(m_dest);
   i.WriteU32(m_nextHop);
   i.WriteHtonU32 (m_originTime);
- 
+  i.WriteU8(m_flags);
+  if (HasStateTrailer())
+    {
+      i.WriteU8(m_rCh);
+      i.WriteU8(m_rNewCh);
+      i.WriteHtonU16(m_extBw);
+      i.WriteU8(m_extBwConf);
+      i.WriteHtonU32(m_rSwitchTime);
+    }
 }
 
 uint32_t 
@@ -279,6 +978,15 @@ SicaHeader::Deserialize (Buffer::Iterator start)
   m_dest=i.ReadU32 ();
   m_nextHop=i.ReadU32 ();
   m_originTime=i.ReadNtohU32 ();
+  m_flags=i.ReadU8 ();
+  if (HasStateTrailer())
+    {
+      m_rCh=i.ReadU8 ();
+      m_rNewCh=i.ReadU8 ();
+      m_extBw=i.ReadNtohU16 ();
+      m_extBwConf=i.ReadU8 ();
+      m_rSwitchTime=i.ReadNtohU32 ();
+    }
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
   return dist;
@@ -295,6 +1003,57 @@ SicaHeader::Print(std::ostream &os) const
   os << "\nDestination (ID): "<< m_dest ;
   os << "\nNext Hop (ID): "<< m_nextHop ;
   os <<"\nTime of origin " << m_originTime ;
+  os <<"\nTraffic class " << static_cast <uint32_t>(GetTrafficClass()) ;
+  if (HasStateTrailer())
+    os << "\nTransmitter R channel " << static_cast <uint32_t>(m_rCh) << " new channel " << static_cast <uint32_t>(m_rNewCh)
+       << " in " << m_rSwitchTime << " miliseconds, Ext. BW " << m_extBw/256.0 << " confidence " << m_extBwConf/255.0;
+}
+
+//////////////////////////////////////////////////////////////
+SicaRetryTag::SicaRetryTag(uint8_t retries):
+  m_retries(retries)
+{}
+
+NS_OBJECT_ENSURE_REGISTERED (SicaRetryTag);
+
+TypeId 
+SicaRetryTag::GetTypeId ()
+{
+  static TypeId tid = TypeId("ns3::SicaRetryTag")
+   .SetParent<Tag> ()
+  .AddConstructor<SicaRetryTag> ()
+      ;
+  return tid;
+}
+
+TypeId
+SicaRetryTag::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t 
+SicaRetryTag::GetSerializedSize () const
+{
+  return (1);
+}
+
+void 
+SicaRetryTag::Serialize (TagBuffer i) const
+{
+  i.WriteU8(m_retries);
+}
+
+void 
+SicaRetryTag::Deserialize (TagBuffer i)
+{
+  m_retries=i.ReadU8();
+}
+
+void
+SicaRetryTag::Print(std::ostream &os) const
+{
+  os << "Sica retransmissions " << static_cast <uint32_t>(m_retries);
 }
 
 
@@ -13,10 +13,13 @@
 
 #include <iostream>
 #include "ns3/header.h"
+#include "ns3/tag.h"
 #include "ns3/simulator.h"
 #include "ns3/enum.h"
 #include "ns3/address.h"
 #include <map>
+#include <vector>
+#include <algorithm>
 #include "ns3/nstime.h"
 
 namespace ns3 {
@@ -33,12 +36,27 @@ namespace ns3 {
    *\param {Originator Time }:Used to distinguish between old and new hello messages
    * \param {#R-Radios} : Number of receiving radios 
    * \param {Channel R-R}: current channel of receiving radio
-   * \param {Bx(Channel R-R)}: Estimated consumed bandwidth by external interference over current channel of R-R
+   * \param {Bx(Channel R-R)}: Estimated consumed bandwidth by external interference over current channel of R-R, in fixed point (1/256 Mbps)
+   * \param {Bx Confidence}: Confidence of the originator in its Bx estimation (1/255), 0 means no estimation
    * \param {R-R -NewChannel}: The next channel for channel switching attempt of R-R,  R-R -NewChannel=0 shows no switching
+   * \param {Hello Version}: Version of the hello state of the originator, the incremental hellos (SicaHelloDeltaHeader) are relative to it
+   * \param {Flags}: SicaHelloHeader::SNAPSHOT_REQUEST asks the neighbors for a full hello, SicaHelloHeader::MULTI_PART tells that the Part and #Parts bytes follow
+   * \param {Part, #Parts}: When the neighbors do not fit in one hello, each hello carries one part of them, the parts rotate over the successive hellos
+   * \param {Time To the next Hello}: Time in milliseconds until the next periodic hello of the originator, the receivers keep its information at least twice as long
    * \param {Time To Switch R interface} : Time in milliseconds until R-R switch
+   *
+   * Every hello starts with a format byte. SicaHelloHeader::FULL_FORMAT is the fixed layout below, the receiving
+   * radio address is preceded by its length. SicaHelloHeader::COMPACT_FORMAT encodes the integers as varints
+   * (7 bits per byte, the high bit tells that another byte follows), sends the optional fields only when their
+   * bit is set in the Fields mask and encodes each neighbor ID as the difference with the previous one in the
+   * sorted neighbor list. The CLCPF is sent in fixed point (SicaHelloHeader::CLCPF_FRACTION_BITS fractional bits)
+   * and the TTL in one byte.
  \verbatim
+  Full format
   0                   1                   2                   3
   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+
+  |  Format (1)   |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                    Hello Sequence Number                      |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -46,8 +64,14 @@ namespace ns3 {
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                    Originator Time                            |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  |  #Radios    |  Channel R-R  |Bx(Channel R-R)|R-R -NewChannel  |
+  |  #Radios    |  Channel R-R  |       Bx(Channel R-R)         |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Bx Confidence |     Data backlog (load)       |R-R -NewChannel|
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |        Hello Version          |     Flags     |Part (optional)|
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |#Parts(option)|Address Length |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                Receiving Radio #1  MAC Address (part 1)       | 
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                Receiving Radio #1  MAC Address (part 2)       | 
@@ -56,6 +80,8 @@ namespace ns3 {
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |               Time To Sense the current channel of R-R        |    
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |               Time To the next Hello                          |    
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   | # Neighbors   |Channel R-R N#1|Channel R-R N#2|Channel R-R N#3|
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                    Neighbor #1 ID                             |
@@ -70,6 +96,28 @@ namespace ns3 {
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                    TTL (for Urbanx protocol)                  |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |Link Quality#1 |Link Quality#2 |Link Quality#3 |  (LINK_QUALITY)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+  Compact format (v: varint)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Format (2)   |    Fields     |   #Radios     |  Channel R-R  |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Sequence Number (v), Originator ID (v), Originator Time (v)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Address Length, Address                                         (ADDR_PRESENT)
+  | Bx(Channel R-R) (16 bits), Bx Confidence                        (BX_PRESENT)
+  | Data backlog (v)                                                (LOAD_PRESENT)
+  | R-R -NewChannel, Time To Switch (v)                             (SWITCH_PRESENT)
+  | Time To Sense (v)                                               (SENSE_PRESENT)
+  | Time To the next Hello (v)                                      (INTERVAL_PRESENT)
+  | Hello Version (16 bits), Flags, Part and #Parts if MULTI_PART   (STATE_PRESENT)
+  | CLCPF (v), TTL                                                  (URBANX_PRESENT)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | # Neighbors (v), then for each neighbor ID difference (v) and Channel R-R
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Link Quality of each neighbor                                   (LINK_QUALITY)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
 */ 
 
@@ -77,10 +125,36 @@ namespace ns3 {
 class SicaHelloHeader : public Header
 {
 public:
+  /// flags of the hello
+  enum Flags {
+    SNAPSHOT_REQUEST = 1,///< the originator missed an incremental hello and asks for a full one
+    MULTI_PART       = 2,///< the hello carries one part of the neighbors of the originator
+    LINK_QUALITY     = 4,///< the hello carries the delivery ratio of the hellos of each neighbor, one byte per neighbor (1/255)
+  };
+  /// wire formats of the hello
+  enum Format {
+    FULL_FORMAT    = 1,///< fixed size fields
+    COMPACT_FORMAT = 2,///< varints and optional fields
+  };
+  /// optional fields of the compact format, a field is omitted when it has its default value
+  enum CompactFields {
+    ADDR_PRESENT     = 1,///< address of the receiving radio
+    BX_PRESENT       = 2,///< external bandwidth and confidence
+    LOAD_PRESENT     = 4,///< data backlog
+    SWITCH_PRESENT   = 8,///< new channel and time to switch R-R, otherwise no switch is scheduled
+    SENSE_PRESENT    = 16,///< time to sense the channel of R-R
+    INTERVAL_PRESENT = 32,///< time to the next hello
+    STATE_PRESENT    = 64,///< hello version and flags
+    URBANX_PRESENT   = 128,///< CLCPF and TTL, otherwise 0 and 1
+  };
+  /// number of fractional bits of the CLCPF in the compact format
+  static const uint32_t CLCPF_FRACTION_BITS = 10;
+  /// The neighbors carried by the message sorted by node ID: node ID and receiving channel
+  typedef std::vector<std::pair<uint32_t, uint8_t> > NiRChannels;
 /// c-tor
   SicaHelloHeader(uint32_t sqNo=0,uint32_t origin=0,
                   Time originTime=Simulator::Now(),
-                  uint8_t radios=1,uint8_t rCh=1, uint8_t extBw=0,
+                  uint8_t radios=1,uint8_t rCh=1, uint16_t extBw=0,
                   uint8_t rNewCh=0, Address rAddr=Address(), Time rSwitchTime=MilliSeconds (0),Time rSenseTime=MilliSeconds (0));
   virtual ~SicaHelloHeader(){}
 ///\name Header serialization/de-serialization
@@ -110,10 +184,40 @@ public:
   void SetRChannel(uint8_t rCh){m_rCh=rCh;}
   /// Return the receiving channel 
   uint8_t GetRChannel(){return m_rCh;}
-  ///Set the external bandwidth over a channel in Mbps
-  void SetExtBw (uint8_t extBw){m_extBw=extBw;}
-  /// Return the external bandwidth over a channel
-  uint8_t GetExtBw(){return m_extBw;}
+  ///Set the external bandwidth over a channel in fixed point (1/256 Mbps)
+  void SetExtBw (uint16_t extBw){m_extBw=extBw;}
+  /// Return the external bandwidth over a channel in fixed point (1/256 Mbps)
+  uint16_t GetExtBw(){return m_extBw;}
+  ///Set the confidence of the external bandwidth estimation [0,1]
+  void SetExtBwConfidence (double confidence){m_extBwConf=static_cast<uint8_t>(std::min(std::max(confidence,0.0),1.0)*255+0.5);}
+  /// Return the confidence of the external bandwidth estimation [0,1]
+  double GetExtBwConfidence(){return (m_extBwConf/255.0);}
+  ///Set the data backlog of the originator in packets
+  void SetLoad (uint16_t load){m_load=load;}
+  ///Return the data backlog of the originator in packets
+  uint16_t GetLoad(){return m_load;}
+  /// Set the version of the hello state
+  void SetVersion (uint16_t version){m_version=version;}
+  /// Return the version of the hello state
+  uint16_t GetVersion (){return m_version;}
+  /// Set the flags of the hello (SicaHelloHeader::Flags)
+  void SetFlags (uint8_t flags){m_flags=flags;}
+  /// Return the flags of the hello (SicaHelloHeader::Flags)
+  uint8_t GetFlags (){return m_flags;}
+  /**
+   * \brief Set the part of the neighbors carried by the hello, it sets SicaHelloHeader::MULTI_PART if there are several parts
+   *\param part the index of the part, from 0
+   *\param parts the number of parts
+   */
+  void SetPart (uint8_t part, uint8_t parts);
+  /// Return the index of the part of the neighbors carried by the hello
+  uint8_t GetPart () const {return m_part;}
+  /// Return the number of parts of the neighbors of the originator, 1 if the hello carries all of them
+  uint8_t GetParts () const {return m_parts;}
+  /// Set the wire format of the hello (SicaHelloHeader::Format)
+  void SetFormat (uint8_t format){m_format=format;}
+  /// Return the wire format of the hello (SicaHelloHeader::Format)
+  uint8_t GetFormat () const {return m_format;}
   /// Set new channel for receiving interface
   void  SetRNewChannel (uint8_t rNCh){m_rNewCh=rNCh;}
   /// Return New channel for receiving interface
@@ -140,6 +244,12 @@ public:
   Time GetSenseTime(){
     Time t (MilliSeconds (m_rSenseTime));
     return t;}
+  ///Set the time until the next periodic hello
+  void SetHelloInterval(Time hI){m_helloInterval=hI.GetMilliSeconds ();}
+  /// Return the time until the next periodic hello, 0 if it is not advertised
+  Time GetHelloInterval(){
+    Time t (MilliSeconds (m_helloInterval));
+    return t;}
   //Set the number of neighbors 
   //void SetNiNo (uint8_t niNo){m_ni=niNo;}
   ///Set the CLCPF
@@ -153,11 +263,11 @@ public:
   /// decrease the ttl by one 
   void DecreaseTTL(){m_ttl--;}
   ///Return the number of neighbors 
-  uint8_t GetNiNo() const {return m_ni;}
+  uint16_t GetNiNo() const {return m_ni;}
   /**
    * 
-   * \brief Add neighbor receiving channel information to the message
-   * \return false if we have already add maximum number of neighbors(255) to the message 
+   * \brief Add neighbor receiving channel information to the message, the full format can carry 255 neighbors at most
+   * \return false if we have already add maximum number of neighbors(65535) to the message 
    *\param ni the id of neighbor node 
    *\param rCh the receiving channel of the neighbor
    */
@@ -176,10 +286,54 @@ public:
    *\param ni the id of neighbor node 
    */
   bool DeleteNiRChannel (uint32_t ni);
+  /**
+   * \brief Return the receiving channel reported for a neighbor
+   * \return -1 if there is no such information in the message
+   *\param ni the id of neighbor node 
+   */
+  int32_t GetNiRChannel (uint32_t ni) const;
+  /**
+   * \brief Keep only a range of the neighbors sorted by node ID
+   *\param first the index of the first neighbor kept
+   *\param count the number of neighbors kept
+   */
+  void KeepNiRange (uint32_t first, uint32_t count);
+  /// Return the receiving channels of the neighbors carried by the message
+  const NiRChannels & GetNiRChannels () const {return m_neighborRChannel;}
+  /**
+   * \brief Set the delivery ratio of the hellos of a neighbor measured by the originator, it sets SicaHelloHeader::LINK_QUALITY
+   *\param ni the id of neighbor node
+   *\param ratio the delivery ratio [0,1]
+   */
+  void SetNiQuality (uint32_t ni, double ratio);
+  /**
+   * \brief Return the delivery ratio of the hellos of a neighbor measured by the originator
+   * \return -1 if there is no such information in the message
+   *\param ni the id of neighbor node
+   */
+  double GetNiQuality (uint32_t ni) const;
   
   /// Cleare Header
   void Clear();
 private:
+  /// Return the optional fields of the compact format which are sent (SicaHelloHeader::CompactFields)
+  uint8_t GetCompactFields () const;
+  /// Return the CLCPF in fixed point
+  uint32_t GetFixedCLCPF () const;
+  /// Return the size of the hello in compact format
+  uint32_t GetCompactSize () const;
+  /// Serialize the hello in compact format, after the format byte
+  void SerializeCompact (Buffer::Iterator &i) const;
+  /// Deserialize the hello in compact format, after the format byte
+  void DeserializeCompact (Buffer::Iterator &i);
+  /// Serialize the link quality of the neighbors, after the neighbors
+  void WriteNiQuality (Buffer::Iterator &i) const;
+  /// Deserialize the link quality of the neighbors, after the neighbors
+  void ReadNiQuality (Buffer::Iterator &i);
+  /// Return the first neighbor whose ID is not less than ni
+  NiRChannels::const_iterator FindNi (uint32_t ni) const;
+  /// Wire format
+  uint8_t m_format;
   /// The sequence number 
   uint32_t m_seqNo;
   /// Originator IP address
@@ -190,30 +344,230 @@ private:
   uint8_t  m_radios;
   /// Channel of the receiving (R) interface on originator node
   uint8_t m_rCh;
-  /// Consumed bandwidth by external interference  on receiving channel
-  uint8_t m_extBw;
+  /// Consumed bandwidth by external interference  on receiving channel in fixed point
+  uint16_t m_extBw;
+  /// Confidence in the external bandwidth estimation
+  uint8_t m_extBwConf;
+  /// Data packets queued by the originator for all the channels
+  uint16_t m_load;
   /// New channel of the receiving (R) interface (0 if there is no switching attempt)
   uint8_t m_rNewCh;
+  /// Version of the hello state of the originator
+  uint16_t m_version;
+  /// Flags of the hello
+  uint8_t m_flags;
+  /// Index of the part of the neighbors
+  uint8_t m_part;
+  /// Number of parts of the neighbors
+  uint8_t m_parts;
   /// The MAC address of the receiving radio
   Address m_rAddr;
   /// Switching time of the receiving (R) interface in milliseconds
   uint32_t   m_rSwitchTime;
   /// Switching time of the receiving (R) interface in milliseconds
   uint32_t   m_rSenseTime;
+  /// Time until the next periodic hello in milliseconds
+  uint32_t   m_helloInterval;
   /// number of neighbors 
-  uint8_t m_ni;
+  uint16_t m_ni;
   /// CLCPF for Urbanx
   double m_clcpf;
   /// ttl for Urbanx
   uint32_t m_ttl; 
-  /// List of Neighbors : Node ID  and Receiving Channel.
-  std::map<uint32_t, uint8_t> m_neighborRChannel; 
+  /// List of Neighbors sorted by node ID: Node ID  and Receiving Channel.
+  NiRChannels m_neighborRChannel; 
+  /// Delivery ratio of the hellos of the neighbors in 1/255, sent for the neighbors of m_neighborRChannel
+  std::map<uint32_t, uint8_t> m_niQuality;
 };/*SicaHelloHeader*/
 
-  /// Header used for static routing
+/**
+   * \ingroup sica
+   * \defgroup hellodeltaheader SicaHelloDeltaHeader
+   * \brief Sica Incremental Hello Message carries only the part of the hello state which changed since the previous hello.
+   * 
+   * The receiver applies it to the last hello state of the originator (SicaHelloDeltaHeader::Apply). A gap in the
+   * versions means that an incremental hello was lost, the receiver then asks for a full hello (SicaHelloHeader::SNAPSHOT_REQUEST).
+   * The optional fields are present when their bit is set in the Fields mask, a neighbor with channel 0 is removed.
+   * The timers are sent only when they differ from the previous timers minus the time elapsed between the two hellos.
+ \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                    Hello Sequence Number                      |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                    Originator ID                              |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                    Originator Time                            |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |        Hello Version          |     Flags     |    Fields     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Channel R-R  |R-R -NewChannel|       Bx(Channel R-R)         | (optional)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Bx Confidence |  Time To Switch, Time To Sense, Data backlog,   (optional)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Time To the next Hello                                         (optional)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | # Changes     |  Neighbor ID and Channel R-R of each change
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*/ 
+class SicaHelloDeltaHeader : public Header
+{
+public:
+  /// optional fields of the incremental hello
+  enum Fields {
+    CHANNEL_FIELD = 1,///< current and new channel of R-R
+    BX_FIELD      = 2,///< external bandwidth and confidence
+    SWITCH_FIELD  = 4,///< time to switch R-R
+    SENSE_FIELD   = 8,///< time to sense the channel of R-R
+    LOAD_FIELD    = 16,///< data backlog
+    INTERVAL_FIELD = 32,///< time to the next hello
+  };
+/// c-tor
+  SicaHelloDeltaHeader();
+  virtual ~SicaHelloDeltaHeader(){}
+///\name Header serialization/de-serialization
+  //\{
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator i) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+  //\}
+  /**
+   *\brief Build the incremental hello which turns one hello state into the next one
+   *\param prev the previous hello state sent by the originator
+   *\param cur the current hello state of the originator
+   */
+  static SicaHelloDeltaHeader Diff (SicaHelloHeader prev, SicaHelloHeader cur);
+  /**
+   *\brief Apply the incremental hello to the previous hello state of the originator
+   *\param base the previous hello state, it becomes the current one
+   */
+  void Apply (SicaHelloHeader &base) const;
+  /// Check whether the header has valid data or not
+  bool IsValid(){return (m_seqNo>0); }
+  /// Return the sequence number of the hello
+  uint32_t GetSeqNo() {return m_seqNo;}
+  /// Return the originator Id
+  uint32_t GetOrigin (){return m_origin;}
+  /// Return the version of the hello state
+  uint16_t GetVersion (){return m_version;}
+  /// Set the flags of the hello (SicaHelloHeader::Flags)
+  void SetFlags (uint8_t flags){m_flags=flags;}
+  /// Return the flags of the hello (SicaHelloHeader::Flags)
+  uint8_t GetFlags (){return m_flags;}
+  /// Return the mask of the optional fields (SicaHelloDeltaHeader::Fields)
+  uint8_t GetFields (){return m_fields;}
+  /// Return the number of neighbor changes
+  uint32_t GetChangeNo () const {return m_changes.size();}
+private:
+  uint32_t m_seqNo; ///< Sequence number
+  uint32_t m_origin; ///< Id of the originator
+  uint32_t m_originTime; ///< time of the hello in milliseconds
+  uint16_t m_version; ///< Version of the hello state
+  uint8_t m_flags; ///< Flags of the hello
+  uint8_t m_fields; ///< Mask of the optional fields
+  uint8_t m_rCh; ///< Channel of the receiving (R) interface
+  uint8_t m_rNewCh; ///< New channel of the receiving (R) interface
+  uint16_t m_extBw; ///< External bandwidth in fixed point
+  uint8_t m_extBwConf; ///< Confidence of the external bandwidth
+  uint32_t m_rSwitchTime; ///< Switching time of the receiving (R) interface in milliseconds
+  uint32_t m_rSenseTime; ///< Sensing time of the receiving (R) interface in milliseconds
+  uint16_t m_load; ///< Data backlog
+  uint32_t m_helloInterval; ///< Time until the next periodic hello in milliseconds
+  std::map<uint32_t, uint8_t> m_changes; ///< Changed neighbors: node ID and receiving channel, 0 if the neighbor is removed
+};/*SicaHelloDeltaHeader*/
+
+/**
+   * \ingroup sica
+   * \defgroup switchheader SicaSwitchHeader
+   * \brief Sica Switch Message announces a switch of the receiving interface to the neighbors.
+   * 
+   * It is sent on the channels of the neighbors ahead of the switch and repeated until every neighbor acknowledged it implicitly.
+   *\param {Switch Sequence Number }: Sequence number of the announcement
+   *\param {Originator ID}: Node Id of the originator
+   * \param {Channel R-R}: current channel of receiving radio
+   * \param {R-R -NewChannel}: The next channel of R-R, equal to Channel R-R when the switch is withdrawn
+   * \param {Time To Switch R interface} : Time in microseconds until R-R switch, 0 once the switch is done
+ \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                    Switch Sequence Number                     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                    Originator ID                              |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Channel R-R  |R-R -NewChannel|
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |               Time To Switch R interface                      |    
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*/ 
+class SicaSwitchHeader : public Header
+{
+public:
+/// c-tor
+  SicaSwitchHeader(uint32_t sqNo=0,uint32_t origin=0,uint8_t rCh=0,uint8_t rNewCh=0,Time rSwitchTime=MicroSeconds (0));
+  virtual ~SicaSwitchHeader(){}
+///\name Header serialization/de-serialization
+  //\{
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator i) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+  //\}
+  /// Check whether the header has valid data or not
+  bool IsValid(){return (m_seqNo>0); }
+  /// Return the sequence number of the announcement
+  uint32_t GetSeqNo() {return m_seqNo;}
+  /// Return the originator Id
+  uint32_t GetOrigin (){return m_origin;}
+  /// Return the current channel of the receiving interface
+  uint8_t GetRChannel(){return m_rCh;}
+  /// Return the new channel of the receiving interface
+  uint8_t GetRNewChannel (){return m_rNewCh;}
+  /// Return the time until the switch of the receiving interface
+  Time GetTimeToSwitch(){
+    Time t (MicroSeconds (m_rSwitchTime));
+    return t;}
+private:
+  uint32_t m_seqNo; ///< Sequence number
+  uint32_t m_origin; ///< Id of the originator
+  uint8_t m_rCh; ///< Current channel of the receiving (R) interface
+  uint8_t m_rNewCh; ///< New channel of the receiving (R) interface
+  uint32_t m_rSwitchTime; ///< Switching time of the receiving (R) interface in microseconds
+};/*SicaSwitchHeader*/
+
+/**
+   * \brief Header used for static routing.
+   *
+   * The Flags byte follows the originating time. With SicaHeader::STATE_TRAILER the header ends with the
+   * state of the transmitter (not of the originator) at the time of the transmission, the receiver uses it
+   * like a hello which carries no neighbors.
+ \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |     Flags     |  Channel R-R  |R-R -NewChannel|   Bx(Channel  (STATE_TRAILER)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  R-R)         | Bx Confidence |  Time To Switch R interface     (STATE_TRAILER)
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*/
 class SicaHeader : public Header
 {
 public:
+  /// flags of the header
+  enum Flags {
+    STATE_TRAILER = 1,///< the header carries the state of the transmitter
+    CLASS_MASK    = 0xf0,///< the upper four bits of the flags carry the traffic class of the packet
+  };
+  /// number of traffic classes the header can carry
+  static const uint32_t MAX_TRAFFIC_CLASSES = 16;
 /// c-tor
   SicaHeader(uint32_t sqNo=0,uint32_t origin=0,uint32_t dest=0,uint32_t nextHop=0,Time originTime=Simulator::Now());
   virtual ~SicaHeader(){}
@@ -271,12 +625,76 @@ public:
   Time GetOriginTime(){
     Time t (MilliSeconds (m_originTime));
     return t;}
+  /**
+   *\brief Add the state of the transmitter to the header
+   *\param rCh the channel of the receiving interface
+   *\param rNewCh the new channel of the receiving interface
+   *\param switchTime the time until the switch of the receiving interface
+   *\param extBw the external bandwidth over the channel of the receiving interface in fixed point (1/256 Mbps)
+   *\param confidence the confidence of the external bandwidth estimation [0,1]
+   */
+  void SetStateTrailer(uint8_t rCh, uint8_t rNewCh, Time switchTime, uint16_t extBw, double confidence);
+  /// Return true if the header carries the state of the transmitter
+  bool HasStateTrailer() const {return (m_flags & STATE_TRAILER);}
+  /// Return the channel of the receiving interface of the transmitter
+  uint8_t GetRChannel(){return m_rCh;}
+  /// Return the new channel of the receiving interface of the transmitter
+  uint8_t GetRNewChannel(){return m_rNewCh;}
+  /// Return the time until the switch of the receiving interface of the transmitter
+  Time GetTimeToSwitch(){
+    Time t (MilliSeconds (m_rSwitchTime));
+    return t;}
+  /// Return the external bandwidth over the channel of the transmitter in fixed point (1/256 Mbps)
+  uint16_t GetExtBw(){return m_extBw;}
+  /// Return the confidence of the external bandwidth estimation of the transmitter [0,1]
+  double GetExtBwConfidence(){return (m_extBwConf/255.0);}
+  /**
+   *\brief Set the traffic class of the packet, it selects the data queue of the packet at every hop
+   *\param tc the traffic class, lower than SicaHeader::MAX_TRAFFIC_CLASSES, the highest class has the highest priority
+   */
+  void SetTrafficClass(uint8_t tc){m_flags=static_cast<uint8_t>((m_flags & ~CLASS_MASK) | ((tc << 4) & CLASS_MASK));}
+  /// Return the traffic class of the packet
+  uint8_t GetTrafficClass() const {return ((m_flags & CLASS_MASK) >> 4);}
 private:
   uint32_t m_seqNo; /// Sequence number
   uint32_t m_origin; /// Id of the source node
   uint32_t m_dest; /// Id of the destination node
   uint32_t m_nextHop; /// Id of the next hop node to the destination
   uint32_t m_originTime; ///the time of originating the packet
+  uint8_t m_flags; ///flags of the header
+  uint8_t m_rCh; ///channel of the receiving interface of the transmitter
+  uint8_t m_rNewCh; ///new channel of the receiving interface of the transmitter
+  uint16_t m_extBw; ///external bandwidth over the channel of the transmitter
+  uint8_t m_extBwConf; ///confidence of the external bandwidth estimation
+  uint32_t m_rSwitchTime; ///time until the switch of the receiving interface in milliseconds
+};
+
+/**
+   * \brief Packet tag which counts the retransmissions of a data packet by Sica over the current hop.
+   *
+   * The MAC retries a frame on its own, Sica retransmits it when the MAC gives up. The tag is removed at
+   * the reception, so every hop has its own retransmissions.
+*/
+class SicaRetryTag : public Tag
+{
+public:
+  /// c-tor
+  SicaRetryTag(uint8_t retries=0);
+///\name Tag serialization/de-serialization
+  //\{
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (TagBuffer i) const;
+  void Deserialize (TagBuffer i);
+  void Print (std::ostream &os) const;
+  //\}
+  /// Set the number of retransmissions
+  void SetRetries(uint8_t retries){m_retries=retries;}
+  /// Return the number of retransmissions
+  uint8_t GetRetries() const {return m_retries;}
+private:
+  uint8_t m_retries; ///number of retransmissions over the current hop
 };
 
 }/*namespace ns3 */
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-phy-sensor.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("SicaPhySensor");
+
+namespace ns3 {
+
+SicaPhySensor::SicaPhySensor():
+  m_channel(0),
+  m_busyStart(Seconds(0)),
+  m_busyEnd(Seconds(0))
+{
+}
+
+SicaPhySensor::~SicaPhySensor()
+{
+  Detach();
+}
+
+void
+SicaPhySensor::SetPhy(Ptr<WifiPhy> phy)
+{
+  m_phy=phy;
+  m_channel=phy->GetChannelNumber();
+  phy->RegisterListener(this);
+}
+
+Time
+SicaPhySensor::GetBusyTime(uint32_t chId)
+{
+  Time busy=Seconds(0);
+  std::map<uint32_t, Time>::iterator i=m_busyTime.find(chId);
+  if (i != m_busyTime.end())
+    busy=i->second;
+  // the part of the current busy period which has already elapsed
+  if (chId==m_channel && m_busyEnd > m_busyStart)
+    busy+=std::min(Simulator::Now(),m_busyEnd)-m_busyStart;
+  return busy;
+}
+
+void
+SicaPhySensor::Detach()
+{
+  if (!m_phy)
+    return;
+  // a disposed phy has no channel and has already released its listeners
+  if (m_phy->GetChannel())
+    m_phy->UnregisterListener(this);
+  m_phy=0;
+}
+
+bool
+SicaPhySensor::IsBusy()
+{
+  return (m_busyEnd > Simulator::Now());
+}
+
+void
+SicaPhySensor::AddBusy(Time duration)
+{
+  Time now=Simulator::Now();
+  if (now >= m_busyEnd)
+    {
+      // the previous busy period is over, start a new one
+      CloseBusy(m_busyEnd);
+      m_channel=m_phy->GetChannelNumber();
+      m_busyStart=now;
+      m_busyEnd=now+duration;
+    }
+  else
+    m_busyEnd=std::max(m_busyEnd,now+duration);
+  NS_LOG_DEBUG("Busy period on channel "<< m_channel << " until "<< m_busyEnd.GetMicroSeconds());
+}
+
+void
+SicaPhySensor::CloseBusy(Time end)
+{
+  if (end > m_busyStart)
+    {
+      std::map<uint32_t, Time>::iterator i=m_busyTime.find(m_channel);
+      if (i == m_busyTime.end())
+        m_busyTime.insert(std::make_pair(m_channel,end-m_busyStart));
+      else
+        i->second+=end-m_busyStart;
+    }
+  m_busyStart=end;
+  m_busyEnd=end;
+}
+
+void
+SicaPhySensor::NotifyRxStart (Time duration)
+{
+  AddBusy(duration);
+}
+
+void
+SicaPhySensor::NotifyRxEndOk (void)
+{
+}
+
+void
+SicaPhySensor::NotifyRxEndError (void)
+{
+}
+
+void
+SicaPhySensor::NotifyTxStart (Time duration, double txPowerDbm)
+{
+  // own transmissions are not an occupancy of the channel by others
+}
+
+void
+SicaPhySensor::NotifyMaybeCcaBusyStart (Time duration)
+{
+  AddBusy(duration);
+}
+
+void
+SicaPhySensor::NotifySwitchingStart (Time duration)
+{
+  // the rest of the busy period belongs to a channel we are leaving
+  CloseBusy(std::min(Simulator::Now(),m_busyEnd));
+}
+
+void
+SicaPhySensor::NotifySleep (void)
+{
+  CloseBusy(std::min(Simulator::Now(),m_busyEnd));
+}
+
+void
+SicaPhySensor::NotifyWakeup (void)
+{
+}
+
+}/*namespace ns3 */
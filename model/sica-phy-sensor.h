@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICAPHYSENSOR_H
+#define SICAPHYSENSOR_H
+
+#include <map>
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/ptr.h"
+#include "ns3/wifi-phy.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup sica
+ * \defgroup physensor SicaPhySensor
+ */
+
+/**
+ * \brief Sensing backend which measures the channel occupancy from the WifiPhy of an interface.
+ *
+ * It is registered as a WifiPhyListener and accumulates the busy airtime (RX and CCA busy periods)
+ * per channel. Overlapping busy periods are merged and the busy time is attributed to the channel the
+ * phy is tuned to when the busy period starts. The own transmissions of the interface are not counted.
+ * Contrary to ChannelEmu, it sees both the contention of the mesh and the external interference.
+ */
+class SicaPhySensor : public WifiPhyListener
+{
+public:
+  /// c-tor
+  SicaPhySensor();
+  /// d-tor
+  virtual ~SicaPhySensor();
+  /**
+   *\brief Attach the sensor to the physical layer of an interface
+   *\param phy the physical layer to listen to
+   */
+  void SetPhy(Ptr<WifiPhy> phy);
+  /// Stop listening to the physical layer, the busy time accumulated so far is kept
+  void Detach();
+  /// Return true if the sensor is attached to a physical layer
+  bool IsAttached(){return (m_phy!=0);}
+  /**
+   *\brief Return the busy airtime accumulated over the given channel since the creation of the sensor up to now
+   *\param chId the id of the channel
+   */
+  Time GetBusyTime(uint32_t chId);
+  /// Return true if the medium is currently sensed busy
+  bool IsBusy();
+  ///\name WifiPhyListener methods
+  //\{
+  virtual void NotifyRxStart (Time duration);
+  virtual void NotifyRxEndOk (void);
+  virtual void NotifyRxEndError (void);
+  virtual void NotifyTxStart (Time duration, double txPowerDbm);
+  virtual void NotifyMaybeCcaBusyStart (Time duration);
+  virtual void NotifySwitchingStart (Time duration);
+  virtual void NotifySleep (void);
+  virtual void NotifyWakeup (void);
+  //\}
+private:
+  /// Merge a busy period starting now into the current busy period
+  void AddBusy(Time duration);
+  /// Close the current busy period at the given time
+  void CloseBusy(Time end);
+  /// The physical layer which is listened
+  Ptr<WifiPhy> m_phy;
+  /// The channel of the current busy period
+  uint32_t m_channel;
+  /// Start of the current busy period
+  Time m_busyStart;
+  /// End of the current busy period
+  Time m_busyEnd;
+  /// Busy airtime of the closed busy periods for each channel
+  std::map<uint32_t, Time> m_busyTime;
+};/*SicaPhySensor*/
+
+}/*namespace ns3 */
+
+#endif /* SICAPHYSENSOR_H */
@@ -30,7 +30,10 @@ namespace ns3 {
 
 
 //////////////SicaQueue
-SicaQueue::SicaQueue ()
+SicaQueue::SicaQueue ():
+  m_classes(1),
+  m_scheduler(STRICT_PRIORITY),
+  m_classWeight(1,1)
 {
 }
 
@@ -66,13 +69,135 @@ SicaQueue::GetSize(uint32_t ch, SicaQueueEntry::PacketType ptype)
       return cqueue->m_helloQueue.size();
     }
     else {
-      return cqueue->m_dataQueue.size();
+      uint32_t size=0;
+      for (uint32_t tc=0; tc < cqueue->m_dataQueue.size(); ++tc)
+        size+=cqueue->m_dataQueue[tc].size();
+      return size;
     }
   else 
     return (0);
 }
 
 
+//////////////GetClassSize
+uint32_t 
+SicaQueue::GetClassSize(uint32_t ch, uint32_t tc)
+{
+  SicaChannelQueue *cqueue = FindChannelQueue(ch);
+  Purge(ch,SicaQueueEntry::Data_Type);
+  if (!cqueue || tc >= cqueue->m_dataQueue.size())
+    return (0);
+  return (cqueue->m_dataQueue[tc].size());
+}
+
+
+//////////////SetTrafficClasses
+void 
+SicaQueue::SetTrafficClasses(uint32_t classes, Scheduler scheduler)
+{
+  m_classes=std::min(std::max(classes,1u),SicaHeader::MAX_TRAFFIC_CLASSES);
+  m_scheduler=scheduler;
+  m_classWeight.resize(m_classes,1);
+  for (std::vector<SicaChannelQueue>::iterator i =m_cqueue.begin() ;i != m_cqueue.end (); ++i)
+    {
+      for (uint32_t tc=m_classes; tc < i->m_dataQueue.size(); ++tc)
+        i->m_dataQueue[m_classes-1].insert(i->m_dataQueue[m_classes-1].end(),i->m_dataQueue[tc].begin(),i->m_dataQueue[tc].end());
+      i->m_dataQueue.resize(m_classes);
+      i->m_credit.assign(m_classes,0);
+      i->m_wrrClass=0;
+      i->m_headClass=0;
+    }
+  NS_LOG_DEBUG("The data queues have " << m_classes << " traffic classes.");
+}
+
+
+//////////////SetClassWeight
+void 
+SicaQueue::SetClassWeight(uint32_t tc, uint32_t weight)
+{
+  if (tc >= m_classes)
+    {
+      NS_LOG_WARN("No traffic class " << tc << " to weight.");
+      return;
+    }
+  m_classWeight[tc]=std::max(weight,1u);
+}
+
+
+//////////////GetEntryClass
+uint32_t 
+SicaQueue::GetEntryClass(SicaQueueEntry &ent)
+{
+  SicaHeader sHeader;
+  ent.GetPacket()->PeekHeader(sHeader);
+  return (std::min(static_cast<uint32_t>(sHeader.GetTrafficClass()),m_classes-1));
+}
+
+
+//////////////GetClassUserPriority
+uint8_t 
+SicaQueue::GetClassUserPriority(uint32_t tc, uint32_t classes)
+{
+  // user priorities of best effort, video and voice
+  static const uint8_t up[3] = {0, 5, 6};
+  if (classes <= 1)
+    return (up[0]);
+  uint32_t level=(std::min(tc,classes-1)*2+(classes-1)/2)/(classes-1);
+  return (up[level]);
+}
+
+
+//////////////SelectClass
+uint32_t 
+SicaQueue::SelectClass(SicaChannelQueue *cqueue)
+{
+  uint32_t classes=cqueue->m_dataQueue.size();
+  if (m_scheduler == STRICT_PRIORITY)
+    {
+      for (uint32_t tc=classes; tc > 0; --tc)
+        if (!cqueue->m_dataQueue[tc-1].empty())
+          return (tc-1);
+      return (0);
+    }
+  for (uint32_t round=0; round < 2; ++round)
+    {
+      for (uint32_t k=0; k < classes; ++k)
+        {
+          uint32_t tc=(cqueue->m_wrrClass+k)%classes;
+          if (!cqueue->m_dataQueue[tc].empty() && cqueue->m_credit[tc] > 0)
+            return (tc);
+        }
+      // every class with packets has used its credit, a new round starts
+      for (uint32_t tc=0; tc < classes; ++tc)
+        cqueue->m_credit[tc]=m_classWeight[tc];
+    }
+  return (0);
+}
+
+
+//////////////NextClass
+uint32_t 
+SicaQueue::NextClass(uint32_t tc)
+{
+  if (m_scheduler == STRICT_PRIORITY)
+    return ((tc+m_classes-1)%m_classes);
+  return ((tc+1)%m_classes);
+}
+
+
+//////////////ChargeClass
+void 
+SicaQueue::ChargeClass(SicaChannelQueue *cqueue, uint32_t tc)
+{
+  if (m_scheduler != WEIGHTED)
+    return;
+  if (cqueue->m_credit[tc] > 0)
+    cqueue->m_credit[tc]--;
+  // the class keeps the turn until it has used its credit
+  cqueue->m_wrrClass=(cqueue->m_credit[tc] > 0) ? tc : NextClass(tc);
+}
+
+
 //////////////CpQueuEntry
 void  
 SicaQueue::CpQueuEntry(SicaQueueEntry *cpy,SicaQueueEntry origin )
@@ -97,15 +222,16 @@ SicaQueue::Enqueue (uint32_t ch, SicaQueueEntry *ent )
       {
         cqueue->OpenChannelQueue();
       }
-    if (ent->GetPacketType() == SicaQueueEntry::Hello_Type)
+    if (ent->GetPacketType() != SicaQueueEntry::Data_Type)
       {
         cqueue->m_helloQueue.push_back(*ent);
         NS_LOG_DEBUG("Push one  queue entry to Hello-Channel-Queue #" << ch<<" hello will expire in " <<ent->GetExpireTime().GetMilliSeconds() <<"ms.");
       }
     else 
       {
-        cqueue->m_dataQueue.push_back(*ent); 
-        NS_LOG_DEBUG("Push one  queue entry to Data-Channel-Queue #" << ch<<" data will expire in " <<ent->GetExpireTime().GetMilliSeconds() <<"ms.");
+        uint32_t tc=GetEntryClass(*ent);
+        cqueue->m_dataQueue[tc].push_back(*ent); 
+        NS_LOG_DEBUG("Push one  queue entry to Data-Channel-Queue #" << ch<<" class " << tc <<" data will expire in " <<ent->GetExpireTime().GetMilliSeconds() <<"ms.");
       }
   }
   else 
@@ -134,11 +260,11 @@ SicaQueue::Dequeue (uint32_t ch, SicaQueueEntry::PacketType ptype)
             NS_LOG_DEBUG("Dequeue read one packet from Hello-Channel-Queue #" << ch );
             return (ent);
           }
-        else if (ptype == SicaQueueEntry::Data_Type && cqueue->m_dataQueue.size()>0)
+        else if (ptype == SicaQueueEntry::Data_Type)
           {
-            //ent = &(cqueue->m_dataQueue.front());
-            CpQueuEntry(ent,cqueue->m_dataQueue.front());
-            NS_LOG_DEBUG("Dequeue read  one packet from Data-Channel-Queue #" << ch );
+            cqueue->m_headClass=SelectClass(cqueue);
+            CpQueuEntry(ent,cqueue->m_dataQueue[cqueue->m_headClass].front());
+            NS_LOG_DEBUG("Dequeue read  one packet from Data-Channel-Queue #" << ch << " class " << cqueue->m_headClass );
             return (ent);
           }
       }
@@ -154,67 +280,112 @@ SicaQueueEntry *
 SicaQueue::DequeueWithDest(uint32_t ch,uint32_t dst)
 {
   Ptr <Packet> p;
-  std::vector<SicaQueueEntry>::iterator  eIndex= FindQueueEntryForDest(ch,dst);
+  SicaQueueEntry *eIndex= FindQueueEntryForDest(ch,dst);
   SicaQueueEntry::PacketType ptype=SicaQueueEntry::Data_Type;
-  SicaQueueEntry * ent=new SicaQueueEntry(p,ptype);
-   SicaChannelQueue *cqueue =FindChannelQueue(ch);
-  // Purge expired packets
-   if (Purge(ch,ptype)){
-     if (cqueue && !cqueue->m_close && eIndex != cqueue->m_dataQueue.end())
-       {
-         NS_LOG_DEBUG("One data packet with destination address : "<<dst << " is peeked from channel queue number: " << ch);
-         CpQueuEntry(ent,*eIndex);
-         return (ent);
-         
-       }
-   }//if cqueue
+   if (eIndex)
+     {
+       SicaQueueEntry * ent=new SicaQueueEntry(p,ptype);
+       NS_LOG_DEBUG("One data packet with destination address : "<<dst << " is peeked from channel queue number: " << ch);
+       CpQueuEntry(ent,*eIndex);
+       return (ent);
+     }
    return (NULL);
 }//DequeueRemoveWithDest
   
+///////////////////FindDataEntry
+bool
+SicaQueue::FindDataEntry(SicaChannelQueue *cqueue, uint32_t id, bool byNextHop, uint32_t &tc, std::vector<SicaQueueEntry>::iterator &entry)
+{
+  SicaHeader sHeader;
+  tc=SelectClass(cqueue);
+  for (uint32_t k=0; k < cqueue->m_dataQueue.size(); ++k, tc=NextClass(tc))
+    {
+      for (entry =cqueue->m_dataQueue[tc].begin() ; entry!= cqueue->m_dataQueue[tc].end(); ++entry)
+        {
+          entry->GetPacket()->PeekHeader(sHeader);
+          if ((byNextHop ? sHeader.GetNextHop() : sHeader.GetDest()) == id)
+            return (true);
+        }
+    }
+  return (false);
+}
+
 ///////////////////FindQueueEntryForDest
 
-std::vector<SicaQueueEntry>::iterator 
+SicaQueueEntry *
 SicaQueue::FindQueueEntryForDest(uint32_t ch,uint32_t dst)
 {
-  Ptr <Packet> p;
-  SicaHeader sHeader;
+  uint32_t tc;
+  std::vector<SicaQueueEntry>::iterator entry;
   SicaQueueEntry::PacketType ptype=SicaQueueEntry::Data_Type;
    SicaChannelQueue *cqueue =FindChannelQueue(ch);
   // Purge expired packets
-  if (Purge(ch,ptype))
+  if (Purge(ch,ptype) && cqueue && !cqueue->m_close && FindDataEntry(cqueue,dst,false,tc,entry))
     {
-    if (cqueue && !cqueue->m_close )
-      {
-        for (std::vector<SicaQueueEntry>::iterator i =cqueue->m_dataQueue.begin() ; i!= cqueue->m_dataQueue.end(); ++i)   
-          {
-            p=i->GetPacket();
-            p->PeekHeader(sHeader);
-            if (sHeader.GetDest() == dst)
-              {
-                NS_LOG_DEBUG("One data packet with destination address : "<<dst << " is found in channel queue number: " << ch);
-                return (i);
-              }
-          }
-      }//if cqueue
-  }// if purge
-  return (cqueue->m_dataQueue.end());
+      NS_LOG_DEBUG("One data packet with destination address : "<<dst << " is found in channel queue number: " << ch);
+      return (&(*entry));
+    }
+  return (NULL);
+
+}
+
 
+///////////////////FindQueueEntryForNextHop
+SicaQueueEntry *
+SicaQueue::FindQueueEntryForNextHop(uint32_t ch,uint32_t nextHop)
+{
+  uint32_t tc;
+  std::vector<SicaQueueEntry>::iterator entry;
+  SicaChannelQueue *cqueue =FindChannelQueue(ch);
+  NS_ASSERT_MSG(cqueue,"No queue for channel "<< ch);
+  Purge(ch,SicaQueueEntry::Data_Type);
+  if (FindDataEntry(cqueue,nextHop,true,tc,entry))
+    return (&(*entry));
+  return (NULL);
 }
 
+//////////////DequeueSkipping
+SicaQueueEntry *
+SicaQueue::DequeueSkipping(uint32_t ch,const std::set<uint32_t> &held)
+{
+  SicaHeader sHeader;
+  SicaChannelQueue *cqueue =FindChannelQueue(ch);
+  if (!cqueue || cqueue->m_close || Purge(ch,SicaQueueEntry::Data_Type)==0)
+    return (NULL);
+  uint32_t tc=SelectClass(cqueue);
+  for (uint32_t k=0; k < cqueue->m_dataQueue.size(); ++k, tc=NextClass(tc))
+    {
+      std::vector<SicaQueueEntry> &dataQueue=cqueue->m_dataQueue[tc];
+      for (std::vector<SicaQueueEntry>::iterator i =dataQueue.begin() ; i!= dataQueue.end(); ++i)
+        {
+          i->GetPacket()->PeekHeader(sHeader);
+          if (held.find(sHeader.GetNextHop()) == held.end())
+            {
+              SicaQueueEntry *ent=new SicaQueueEntry(Ptr<Packet>(),SicaQueueEntry::Data_Type);
+              CpQueuEntry(ent,*i);
+              dataQueue.erase(i);
+              ChargeClass(cqueue,tc);
+              return (ent);
+            }
+        }
+    }
+  NS_LOG_DEBUG("All the packets of Data-Channel-Queue #" << ch << " are held.");
+  return (NULL);
+}
 
 //////////////EraseWithIndex
 bool
 SicaQueue::EraseWithDest(uint32_t ch,uint32_t dst)
 {
  
+   uint32_t tc;
+   std::vector<SicaQueueEntry>::iterator eIndex;
    SicaChannelQueue *cqueue =FindChannelQueue(ch);  
-   std::vector<SicaQueueEntry>::iterator  eIndex= FindQueueEntryForDest(ch,dst);
-    if (cqueue && !cqueue->m_close && eIndex != cqueue->m_dataQueue.end() )
+    if (cqueue && !cqueue->m_close && Purge(ch,SicaQueueEntry::Data_Type) && FindDataEntry(cqueue,dst,false,tc,eIndex))
       {
         
                 NS_LOG_DEBUG("One data packet with destination address : "<<dst << " is erased from channel queue number: " << ch);
-                //CpQueuEntry(ent,*i);
-                cqueue->m_dataQueue.erase(eIndex);
+                cqueue->m_dataQueue[tc].erase(eIndex);
                 return (true);
             
       }//if cqueue
@@ -241,12 +412,19 @@ SicaQueue::Purge(uint32_t ch, SicaQueueEntry::PacketType ptype)
       }
     else 
       {
-     while (cqueue->m_dataQueue.size()>0 && cqueue->IsExpired(cqueue->m_dataQueue.front()))
+     uint32_t size=0;
+     for (uint32_t tc=0; tc < cqueue->m_dataQueue.size(); ++tc)
        {
-         NS_LOG_DEBUG("Purge found one expired packet in Data-Channel-Queue #" << ch <<".");
-         EraseFront(ch,ptype);
+         std::vector<SicaQueueEntry> &dataQueue=cqueue->m_dataQueue[tc];
+         while (dataQueue.size()>0 && cqueue->IsExpired(dataQueue.front()))
+           {
+             NS_LOG_DEBUG("Purge found one expired packet in Data-Channel-Queue #" << ch <<" class " << tc <<".");
+             dataQueue.erase(dataQueue.begin());
+             cqueue->m_dataExpired++;
+           }
+         size+=dataQueue.size();
        }
-     return(cqueue->m_dataQueue.size());
+     return(size);
       }
   }
   return(0);
@@ -255,6 +433,23 @@ SicaQueue::Purge(uint32_t ch, SicaQueueEntry::PacketType ptype)
 
 
 
+//////////////TakeExpiredData
+uint32_t
+SicaQueue::TakeExpiredData(uint32_t ch)
+{
+  uint32_t expired=0;
+  SicaChannelQueue *cqueue =FindChannelQueue(ch);
+  if (cqueue)
+    {
+      Purge(ch,SicaQueueEntry::Data_Type);
+      expired=cqueue->m_dataExpired;
+      cqueue->m_dataExpired=0;
+    }
+  return (expired);
+}
+
+
+
 //////////////EraseFront
 void 
 SicaQueue::EraseFront(uint32_t ch, SicaQueueEntry::PacketType ptype)
@@ -267,10 +462,17 @@ SicaQueue::EraseFront(uint32_t ch, SicaQueueEntry::PacketType ptype)
          cqueue->m_helloQueue.erase(cqueue->m_helloQueue.begin());
          NS_LOG_DEBUG("Erase one queue entry  from Hello-Queue #" << ch << ". Queue size is "<<cqueue->m_helloQueue.size()<<".");
        }
-     else if (ptype == SicaQueueEntry::Data_Type && cqueue->m_dataQueue.size()>0 )
+     else if (ptype == SicaQueueEntry::Data_Type)
       {
-       cqueue->m_dataQueue.erase(cqueue->m_dataQueue.begin()); 
-       NS_LOG_DEBUG("Erase one queue entry from Data-Queue #" << ch<< ". Queue size is "<<cqueue->m_dataQueue.size()<<".");
+       // a packet may have been queued in another class since the entry was read
+       uint32_t tc=cqueue->m_dataQueue[cqueue->m_headClass].empty() ? SelectClass(cqueue) : cqueue->m_headClass;
+       std::vector<SicaQueueEntry> &dataQueue=cqueue->m_dataQueue[tc];
+       if (dataQueue.size()>0)
+         {
+           dataQueue.erase(dataQueue.begin()); 
+           ChargeClass(cqueue,tc);
+           NS_LOG_DEBUG("Erase one queue entry from Data-Queue #" << ch<< " class " << tc << ". Class size is "<<dataQueue.size()<<".");
+         }
       } 
    }
 }
@@ -285,7 +487,8 @@ SicaQueue::CloseQueue (uint32_t ch)
   if (cqueue)
     {
     cqueue->m_close=true;
-    cqueue->m_dataQueue.clear();
+    for (uint32_t tc=0; tc < cqueue->m_dataQueue.size(); ++tc)
+      cqueue->m_dataQueue[tc].clear();
     cqueue->m_helloQueue.clear();
     NS_LOG_DEBUG("Queue #" << ch << "is closed.");
     }
@@ -299,11 +502,11 @@ return;
 SicaQueue::SicaChannelQueue *
 SicaQueue::CreatQueue (uint32_t ch){
   SicaChannelQueue *cqueue = FindChannelQueue(ch);
-  SicaChannelQueue *NewCqueue = new SicaChannelQueue(ch);
   if (!cqueue){
-    m_cqueue.push_back(*NewCqueue);
+    m_cqueue.push_back(SicaChannelQueue(ch,m_classes));
     NS_LOG_DEBUG("Queue related to channel #" << ch << " is created.");
-    return (NewCqueue);
+    // return the stored queue, not a copy, the packets pushed to it must not be lost
+    return (&m_cqueue.back());
   }
   else {
     NS_LOG_DEBUG("Queue related to channel #" << ch << " exists!!");
@@ -315,30 +518,41 @@ SicaQueue::CreatQueue (uint32_t ch){
 
 
 //////////////ShuffleData
-void 
+uint32_t 
 SicaQueue::ShuffleData(uint32_t originCh,uint32_t targetCh ,uint32_t addr)
 {
+  if (originCh==targetCh)
+    return (0);
+  // create the target first, the creation may move the other queues
+  SicaChannelQueue *targetQueue = CreatQueue(targetCh);
   SicaChannelQueue *originQueue = FindChannelQueue(originCh);
-  SicaChannelQueue *targetQueue = FindChannelQueue(targetCh);
-   std::vector<SicaQueueEntry>::iterator  eIndex= FindQueueEntryForDest(originCh,addr);
-   bool flag=false;
+  uint32_t moved=0;
+  SicaHeader sHeader;
    NS_LOG_DEBUG("Shuffle data from channel " <<originCh << " to channel " << targetCh << " for node address:  " <<  addr);
-   if (!targetQueue){
-     targetQueue=CreatQueue(targetCh);
-   }
-   if (originQueue && !originQueue->m_close){
-     while (eIndex != originQueue->m_dataQueue.end())
+   if (!originQueue || originQueue->m_close)
+     return (0);
+   Purge(originCh,SicaQueueEntry::Data_Type);
+   // the packets are sent to the next hop, it is the node which switches
+   for (uint32_t tc=0; tc < originQueue->m_dataQueue.size(); ++tc)
      {
-       flag=true;
-       targetQueue->m_dataQueue.push_back(*DequeueWithDest(originCh,addr));
-       originQueue->m_dataQueue.erase(eIndex);
-       eIndex= FindQueueEntryForDest(originCh,addr);    
-       NS_LOG_DEBUG("One queue entry for destination " <<addr << " is poped from channel " << originCh );
-       NS_LOG_DEBUG("One queue entry for destination " <<addr << " is pushed to channel " << targetCh );   
-     }//while 
-   }//if 
-   if (!flag)
+       std::vector<SicaQueueEntry>::iterator i=originQueue->m_dataQueue[tc].begin();
+       while (i != originQueue->m_dataQueue[tc].end())
+         {
+           i->GetPacket()->PeekHeader(sHeader);
+           if (sHeader.GetNextHop() == addr)
+             {
+               moved++;
+               targetQueue->m_dataQueue[tc].push_back(*i);
+               i=originQueue->m_dataQueue[tc].erase(i);
+               NS_LOG_DEBUG("One queue entry for next hop " <<addr << " is moved from channel " << originCh << " to channel " << targetCh);
+             }
+           else
+             ++i;
+         }
+     }
+   if (!moved)
      NS_LOG_DEBUG("Shuffle found no entry in the origin channel, end up with no packet movement");
+   return (moved);
 }
 
 ////////////////ShuffleDataALL
@@ -347,25 +561,20 @@ SicaQueue::ShuffleDataALL(uint32_t originCh,uint32_t targetCh )
 {
   if (originCh==targetCh)
     return;
+  // create the target first, the creation may move the other queues
+  SicaChannelQueue *targetQueue = CreatQueue(targetCh);
   SicaChannelQueue *originQueue = FindChannelQueue(originCh);
-  SicaChannelQueue *targetQueue = FindChannelQueue(targetCh);
-  SicaQueueEntry::PacketType datatype=SicaQueueEntry::Data_Type;
   SicaQueueEntry::PacketType hellotype=SicaQueueEntry::Hello_Type;
   std::vector<SicaQueueEntry>::iterator i;
   NS_LOG_DEBUG("Shuffle data from channel " <<originCh << " to channel " << targetCh);
-  if (!targetQueue){
-    targetQueue=CreatQueue(targetCh);
-  }
   if (originQueue && !originQueue->m_close){
-    while (originQueue->m_dataQueue.size() > 0)
+    for (uint32_t tc=0; tc < originQueue->m_dataQueue.size(); ++tc)
       {
-        i =originQueue->m_dataQueue.begin(); 
-        targetQueue->m_dataQueue.push_back(*Dequeue(originCh,datatype));
-        originQueue->m_dataQueue.erase(i);
-        NS_LOG_DEBUG("One data queue entry  is poped from channel " << originCh );
-        NS_LOG_DEBUG("One data queue entry is pushed to channel " << targetCh ); 
-        NS_LOG_DEBUG("Queue size  " << originQueue->m_dataQueue.size()  ); 
-      }//while 
+        std::vector<SicaQueueEntry> &dataQueue=originQueue->m_dataQueue[tc];
+        targetQueue->m_dataQueue[tc].insert(targetQueue->m_dataQueue[tc].end(),dataQueue.begin(),dataQueue.end());
+        NS_LOG_DEBUG(dataQueue.size() << " data queue entries of class " << tc << " are moved from channel " << originCh << " to channel " << targetCh);
+        dataQueue.clear();
+      }
     
     while (originQueue->m_helloQueue.size() > 0)
       {
@@ -392,7 +601,8 @@ SicaChannelQueue *cqueue = FindChannelQueue(ch);
  SicaHeader sHeader;
  SicaQueueEntry::PacketType ptype=SicaQueueEntry::Data_Type;
  Purge(ch,ptype);
- for (std::vector<SicaQueueEntry>::iterator i =cqueue->m_dataQueue.begin() ; i!= cqueue->m_dataQueue.end(); ++i)   
+ for (uint32_t tc=0; tc < cqueue->m_dataQueue.size(); ++tc)
+ for (std::vector<SicaQueueEntry>::iterator i =cqueue->m_dataQueue[tc].begin() ; i!= cqueue->m_dataQueue[tc].end(); ++i)   
           {
             p=i->GetPacket();
             p->PeekHeader(sHeader);
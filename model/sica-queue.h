@@ -21,6 +21,7 @@
 #include "ns3/sica-packet.h"
 #include "ns3/ptr.h"
 #include <vector>
+#include <set>
 #include <iostream> 
 
 namespace ns3 {
@@ -43,6 +44,8 @@ public:
   enum PacketType {
     Hello_Type = 1,///< SicaQueueEntry contains hello message
     Data_Type    = 2,///< SicaQueueEntry contains data message
+    Switch_Type  = 3,///< SicaQueueEntry contains switch announcement, it is queued and sent with the hello messages
+    HelloDelta_Type = 4,///< SicaQueueEntry contains incremental hello message, it is queued and sent with the hello messages
   };
   /// c-tor
   SicaQueueEntry (Ptr <Packet> p, PacketType ptype):
@@ -101,22 +104,40 @@ public:
     * \defgroup sicachannelqueue SicaChannelQueue
     */
 
+  ///\enum Scheduler the scheduling of the traffic classes of the data queue of a channel
+  enum Scheduler {
+    STRICT_PRIORITY = 0,///< the highest non empty traffic class is always served first
+    WEIGHTED        = 1,///< weighted round robin, each traffic class sends up to its weight in packets per round
+  };
   /**
    * \brief Sica Channel Queue is a structure which stores  data and signal queue for one channel
     */
   struct SicaChannelQueue {
     /// Store Hello packets targeted to  one channel in a vector
     std::vector <SicaQueueEntry> m_helloQueue;
-    /// Store Data packets targeted to  one channel in a vector
-    std::vector <SicaQueueEntry> m_dataQueue;
+    /// Store Data packets targeted to  one channel, one vector per traffic class (SicaHeader::GetTrafficClass), the highest class has the highest priority
+    std::vector <std::vector <SicaQueueEntry> > m_dataQueue;
+    /// Number of packets each traffic class may still send in the current round of the weighted scheduling
+    std::vector <uint32_t> m_credit;
+    /// Traffic class served by the weighted scheduling
+    uint32_t m_wrrClass;
+    /// Traffic class of the data entry returned by the last SicaQueue::Dequeue
+    uint32_t m_headClass;
     /// Channel number
     uint32_t m_ch;
     /// If this queue is active or not
     bool m_close;
+    /// Number of data packets which expired in the queue since the last call to SicaQueue::TakeExpiredData
+    uint32_t m_dataExpired;
     /// c-tor
-    SicaChannelQueue(uint32_t ch):
+    SicaChannelQueue(uint32_t ch, uint32_t classes=1):
+      m_dataQueue(classes),
+      m_credit(classes,0),
+      m_wrrClass(0),
+      m_headClass(0),
       m_ch (ch),
-      m_close(false)
+      m_close(false),
+      m_dataExpired(0)
     {
     }
    /// d-tor
@@ -145,12 +166,36 @@ public:
   SicaChannelQueue * FindChannelQueue(uint32_t ch);
   /// Number of entries in the channel queue (hello queue or data queue)
   uint32_t GetSize (uint32_t ch, SicaQueueEntry::PacketType ptype);
+  /**
+   *\brief Set the traffic classes of the data queues. The existing queues keep their packets, the packets of a removed class go to the highest class left
+   *\param classes the number of traffic classes, from 1 to SicaHeader::MAX_TRAFFIC_CLASSES
+   *\param scheduler the scheduling of the classes
+   */
+  void SetTrafficClasses(uint32_t classes, Scheduler scheduler);
+  /// Return the number of traffic classes
+  uint32_t GetTrafficClasses() const {return m_classes;}
+  /**
+   *\brief Set the weight of a traffic class in the weighted scheduling
+   *\param tc the traffic class
+   *\param weight the number of packets the class sends per round, at least 1
+   */
+  void SetClassWeight(uint32_t tc, uint32_t weight);
+  /// Return the traffic class of a data entry, the classes above the highest one are served as the highest one
+  uint32_t GetEntryClass(SicaQueueEntry &ent);
+  /// Number of data entries of one traffic class in the channel queue
+  uint32_t GetClassSize(uint32_t ch, uint32_t tc);
+  /**
+   *\brief Return the 802.11e user priority of a traffic class: the lowest class is best effort, the highest is voice and the classes between them are spread over best effort, video and voice
+   *\param tc the traffic class
+   *\param classes the number of traffic classes
+   */
+  static uint8_t GetClassUserPriority(uint32_t tc, uint32_t classes);
   /// Copy the entry fields of \param origin  into \param cpy Queue entry
   void  CpQueuEntry(SicaQueueEntry *cpy,SicaQueueEntry origin );
 /// Push entry in channel queue, if there is no entry with the same packet and destination address in queue.
   bool Enqueue (uint32_t ch, SicaQueueEntry* ent);
  /**
-  *\brief Return first  entry of channel queue for given packet type (hello or data)
+  *\brief Return first  entry of channel queue for given packet type (hello or data), the data entry is the head of the traffic class chosen by the scheduler
   * This function does not remove packets from queue
   * \param ch the channel ID
   * \param ptype  Hello or Data type 
@@ -171,16 +216,29 @@ public:
   */
   bool EraseWithDest(uint32_t ch,uint32_t dst);
 /**
-  *\brief Return the pointer to the  entry for the given destination address  from data queue of the given channel,, Return queue.end if there is no entry.
+  *\brief Return the pointer to the  entry for the given destination address  from data queue of the given channel, NULL if there is no entry. The traffic classes are searched in the order of the scheduler.
   *\param ch The channel ID
   *\param dst ID of the destination
-  *\return an iterator which refer to the  queue entry
+  *\return a pointer to the entry stored in the queue
   */
 
-  std::vector<SicaQueueEntry>::iterator FindQueueEntryForDest(uint32_t ch,uint32_t dst);
+  SicaQueueEntry *FindQueueEntryForDest(uint32_t ch,uint32_t dst);
+/**
+  *\brief Return the earliest data entry of the given channel whose next hop is the given node, NULL if there is no entry. The queue of the channel must exist. The traffic classes are searched in the order of the scheduler.
+  *\param ch The channel ID
+  *\param nextHop ID of the next hop
+  *\return a pointer to the entry stored in the queue
+  */
+  SicaQueueEntry *FindQueueEntryForNextHop(uint32_t ch,uint32_t nextHop);
+/**
+  *\brief Remove and return the earliest data entry of the given channel whose next hop is not held, NULL if there is no such entry. The traffic classes are searched in the order of the scheduler. The caller owns the returned entry.
+  *\param ch The channel ID
+  *\param held IDs of the next hops whose packets must stay in the queue
+  */
+  SicaQueueEntry *DequeueSkipping(uint32_t ch,const std::set<uint32_t> &held);
 /**
   *\brief Remove the first packet in the queue corresponding to the given packet
-  * type (hello or data) Close the channel queue on which we have no neighbor
+  * type (hello or data), the data entry is the one returned by the last SicaQueue::Dequeue. Close the channel queue on which we have no neighbor
   * 
   */
  void EraseFront(uint32_t ch, SicaQueueEntry::PacketType ptype);
@@ -190,14 +248,20 @@ public:
   *\param ptype the type of the queue selected from SicaQueueEntry::PacketType
   */
   uint32_t Purge(uint32_t ch, SicaQueueEntry::PacketType ptype);
+/**
+  *\brief Return the number of data packets which expired in the channel queue since the last call, and reset the count
+  * \param ch The id of the channel
+  */
+  uint32_t TakeExpiredData(uint32_t ch);
 
 /**
-  *\brief Move all data packets related to the node with the given address from one channel to another channel queue  
+  *\brief Move all data packets whose next hop is the node with the given address from one channel to another channel queue  
   *\param originCh the source channel
   * \param targetCh the destination channel
-  *\param addr ID of the destination node
+  *\param addr ID of the next hop node
+  *\return the number of packets moved
   */
-  void ShuffleData(uint32_t originCh,uint32_t targetCh ,uint32_t addr);
+  uint32_t ShuffleData(uint32_t originCh,uint32_t targetCh ,uint32_t addr);
 /**
   *\brief Move all data packets from one channel to another channel queue  
   *\param originCh the source channel
@@ -212,8 +276,30 @@ public:
   double ComputeFlowNumber(uint32_t ch);
 
 private:
+  /// Return the traffic class of the data queue served next by the scheduler, the lowest class if the data queue is empty
+  uint32_t SelectClass(SicaChannelQueue *cqueue);
+  /// Return the traffic class which follows tc in the order of the scheduler
+  uint32_t NextClass(uint32_t tc);
+  /// Count one packet sent by a traffic class in the weighted scheduling
+  void ChargeClass(SicaChannelQueue *cqueue, uint32_t tc);
+  /**
+   *\brief Find the first data entry for a destination or a next hop, the traffic classes are searched in the order of the scheduler
+   *\param cqueue the channel queue
+   *\param id ID of the destination or of the next hop
+   *\param byNextHop true to search by next hop, false by destination
+   *\param tc returns the traffic class of the entry
+   *\param entry returns the entry in the vector of the traffic class
+   *\return false if there is no entry
+   */
+  bool FindDataEntry(SicaChannelQueue *cqueue, uint32_t id, bool byNextHop, uint32_t &tc, std::vector<SicaQueueEntry>::iterator &entry);
   ///Vector of channel queues for each node
 std::vector<SicaChannelQueue> m_cqueue;
+  /// Number of traffic classes of the data queues
+  uint32_t m_classes;
+  /// Scheduling of the traffic classes
+  Scheduler m_scheduler;
+  /// Weight of each traffic class in the weighted scheduling
+  std::vector<uint32_t> m_classWeight;
 };/* Sica-Queue*/
 
 }/*namespace ns3 */
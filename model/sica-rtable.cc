@@ -7,6 +7,7 @@
  */
 
 #include "ns3/sica-rtable.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -142,6 +143,18 @@ RTable::MakeRoute(uint32_t srcId,uint32_t dstId, uint32_t nextHopId, double metr
   return;
 }
 
+void 
+RTable::AddRoute(uint32_t srcId,uint32_t dstId, uint32_t nextHopId, double metric)
+{
+  for (std::vector<SicaRoutingTableEntry*>::iterator i = m_rTable.begin (); i != m_rTable.end (); ++i)
+    if ((*i)->GetSrc() == srcId && (*i)->GetDest() == dstId && (*i)->GetNextHop() == nextHopId)
+      {
+        (*i)->SetMetric(metric);
+        return;
+      }
+  AddRouteToTable(new SicaRoutingTableEntry(srcId,dstId,nextHopId,metric));
+}
+
 SicaRoutingTableEntry*
 RTable::FindRoute(uint32_t srcId,uint32_t dstId)
 {
@@ -164,6 +177,54 @@ RTable::FindNextHop(uint32_t srcId,uint32_t dstId)
    return -1;
 }
 
+int 
+RTable::FindNextHop(uint32_t srcId,uint32_t dstId,Callback<double,uint32_t> linkCost)
+{
+  if (srcId==dstId)
+    return srcId;
+  int nextHop=-1;
+  double best=0;
+  for (std::vector<SicaRoutingTableEntry*>::iterator i = m_rTable.begin (); i != m_rTable.end (); ++i)
+    {
+      if ((*i)->GetSrc() != srcId || (*i)->GetDest() != dstId)
+        continue;
+      double cost=linkCost((*i)->GetNextHop());
+      if (cost < 0)
+        continue;
+      // on a tie the last route wins like in RTable::FindRoute
+      if (nextHop == -1 || (*i)->GetMetric()+cost <= best)
+        {
+          nextHop=(*i)->GetNextHop();
+          best=(*i)->GetMetric()+cost;
+        }
+    }
+  if (nextHop == -1)
+    return FindNextHop(srcId,dstId);
+  return nextHop;
+}
+
+std::vector<uint32_t>
+RTable::GetNextHops(uint32_t srcId)
+{
+  std::vector<uint32_t> nextHops;
+  for (std::vector<SicaRoutingTableEntry*>::iterator i = m_rTable.begin (); i != m_rTable.end (); ++i)
+    if ((*i)->GetSrc() == srcId && (*i)->GetNextHop() != srcId
+        && std::find(nextHops.begin(),nextHops.end(),(*i)->GetNextHop()) == nextHops.end())
+      nextHops.push_back((*i)->GetNextHop());
+  return (nextHops);
+}
+
+std::vector<uint32_t>
+RTable::GetPreviousHops(uint32_t nodeId)
+{
+  std::vector<uint32_t> prevHops;
+  for (std::vector<SicaRoutingTableEntry*>::iterator i = m_rTable.begin (); i != m_rTable.end (); ++i)
+    if ((*i)->GetNextHop() == nodeId && (*i)->GetSrc() != nodeId
+        && std::find(prevHops.begin(),prevHops.end(),(*i)->GetSrc()) == prevHops.end())
+      prevHops.push_back((*i)->GetSrc());
+  return (prevHops);
+}
+
 
 void 
 RTable::ReadRoutesFromFile(const char *fileName)
@@ -177,7 +238,7 @@ RTable::ReadRoutesFromFile(const char *fileName)
    rtfile >> dst;
    rtfile >>nextHop;
    rtfile >>metric;
-   MakeRoute(src,dst,nextHop,metric);
+   AddRoute(src,dst,nextHop,metric);
  }
  rtfile.close();
 }
@@ -33,6 +33,7 @@
 #include "ns3/log.h"
 #include "ns3/boolean.h"
 #include "ns3/type-id.h"
+#include "ns3/callback.h"
 #include "node-container.h"
 namespace ns3 {
 
@@ -133,9 +134,17 @@ bool AddRouteToTable(SicaRoutingTableEntry* route);
    *\param  srcId the Id of the source node 
    *\param dstId the Id of the destination node 
    *\param nextHopId the Id of the next hop node on the path to the destination 
-   *\param metric the metric of the path (reserved for future work if necessary)
+   *\param metric the metric of the path, it orders the alternative routes (RTable::AddRoute)
    */ 
 void MakeRoute(uint32_t srcId,uint32_t dstId, uint32_t nextHopId, double metric);
+  /**
+   *\brief  Add an alternative route to a node with destId through nexthop node, the metric is updated if the route exists
+   *\param  srcId the Id of the source node 
+   *\param dstId the Id of the destination node 
+   *\param nextHopId the Id of the next hop node on the path to the destination 
+   *\param metric the metric of the path
+   */ 
+void AddRoute(uint32_t srcId,uint32_t dstId, uint32_t nextHopId, double metric);
   /**
    *\brief  Find the route entry for the destination node with dstId
   *\param  srcId the Id of the source node 
@@ -148,9 +157,27 @@ SicaRoutingTableEntry* FindRoute(uint32_t srcId,uint32_t dstId);
    *\param dstId the Id of the destination node 
    */
 int FindNextHop(uint32_t srcId,uint32_t dstId);
+  /**
+   *\brief  Find the id of the nexthop node to  the destination node with dstId among the alternative routes, the one with the smallest metric plus link cost
+*\param  srcId the Id of the source node 
+   *\param dstId the Id of the destination node 
+   *\param linkCost the cost of the link to a next hop, negative if the next hop can not be used
+   *\return the next hop of RTable::FindNextHop(srcId,dstId) if no next hop can be used
+   */
+int FindNextHop(uint32_t srcId,uint32_t dstId,Callback<double,uint32_t> linkCost);
+  /**
+   *\brief  Return the Ids of the next hops used by the node with srcId to reach any destination, without duplicates
+   *\param  srcId the Id of the node
+   */
+std::vector<uint32_t> GetNextHops(uint32_t srcId);
+  /**
+   *\brief  Return the Ids of the nodes which use the node with nodeId as next hop to reach any destination, without duplicates
+   *\param  nodeId the Id of the node
+   */
+std::vector<uint32_t> GetPreviousHops(uint32_t nodeId);
   /**
    *\brief  Fill the routing tables from file
-   *\param fileName the name of the input file contains static routes with the following format (srcId dstId nextHop Id metric)
+   *\param fileName the name of the input file contains static routes with the following format (srcId dstId nextHop Id metric), several lines with the same source and destination are alternative routes
    */
   void ReadRoutesFromFile(const char* fileName);
   /**
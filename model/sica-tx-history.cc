@@ -0,0 +1,47 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#include "ns3/sica-tx-history.h"
+
+namespace ns3 {
+
+/// Number of transmissions after which the counts are halved
+static const double TX_HISTORY = 64;
+
+SicaTxHistory::SicaTxHistory():
+  m_ok(0),
+  m_fail(0)
+{
+}
+
+void
+SicaTxHistory::Record(bool ok, uint32_t count)
+{
+  if (ok)
+    m_ok+=count;
+  else
+    m_fail+=count;
+  // age the counts so that old results fade out
+  while (m_ok+m_fail > TX_HISTORY)
+    {
+      m_ok/=2;
+      m_fail/=2;
+    }
+}
+
+double
+SicaTxHistory::GetFailureRatio() const
+{
+  if (m_ok+m_fail <= 0)
+    return (0);
+  return (m_fail/(m_ok+m_fail));
+}
+
+}/*namespace ns3 */
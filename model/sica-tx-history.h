@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Pollitechnica the Catalunya
+ *
+ *
+ * Author: Maryam Amiri Nezhad <maryam@ac.upc.edu>
+ *
+ * This is doxygen module description, don't include
+ */
+
+#ifndef SICATXHISTORY_H
+#define SICATXHISTORY_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \brief Count the recent successful and failed transmissions over a channel or to a neighbor.
+ *
+ * Both counts are halved whenever their sum goes over a fixed history, so that the old results fade
+ * out and the counts follow the recent traffic.
+ */
+class SicaTxHistory
+{
+public:
+  /// c-tor
+  SicaTxHistory();
+  /**
+   *\brief Count the result of transmissions and age the counts
+   *\param ok true if the transmissions succeeded, false if they failed or were dropped
+   *\param count the number of transmissions
+   */
+  void Record(bool ok, uint32_t count=1);
+  /// Return the recent successful transmissions
+  double GetOk() const {return m_ok;}
+  /// Return the recent failed transmissions
+  double GetFail() const {return m_fail;}
+  /// Return the recent transmissions
+  double GetAttempts() const {return (m_ok+m_fail);}
+  /// Return the ratio of failed transmissions, 0 if there is none
+  double GetFailureRatio() const;
+private:
+  double m_ok;///< recent successful transmissions
+  double m_fail;///< recent failed transmissions
+};/*SicaTxHistory*/
+
+}/*namespace ns3 */
+
+#endif /* SICATXHISTORY_H */
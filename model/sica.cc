@@ -6,6 +6,8 @@
 
 #include "ns3/sica.h"
 #include "ns3/llc-snap-header.h"
+#include <cstdlib>
+#include <sstream>
 
 NS_LOG_COMPONENT_DEFINE ("Sica");
 
@@ -17,14 +19,22 @@ NS_OBJECT_ENSURE_REGISTERED (Sica);
 //////////////////////Sica
 
 Sica::Sica():
+  LossFormulaNum(0),
   SICA_DATA_PORT(550),
   SICA_HELLO_PORT(551),
+  SICA_SWITCH_PORT(552),
+  SICA_HELLO_DELTA_PORT(553),
   Max_CH(8),
   Min_CH(1),
   Max_BW(11),
   m_gamma(0.8),
   m_beta(0.7),
   m_alpha(0.5),
+  m_adjLossWeight(0),
+  m_queueLossWeight(0),
+  m_txFailLossWeight(0),
+  m_niLoadLossWeight(0),
+  m_linkLossWeight(0),
   HelloInterval(Seconds(100)),
   DataExpireTime(Seconds(2000)),
   HelloExpireTime(Seconds(100)),
@@ -37,9 +47,20 @@ Sica::Sica():
   BxExpireTime(Seconds (400)),
   ChannelBusyBackoffTime(MilliSeconds (8)),
   QueuePollTime(MilliSeconds(1)),
+  m_senseBackend(SENSE_EMULATOR),
+  m_bxEstimatorMode(SicaBxEstimator::EWMA_MODE),
+  m_bxEwmaWeight(0.25),
+  m_bxWindowSize(4),
+  m_bxNeighborWeight(0.3),
+  m_backgroundScan(false),
+  m_scanDwellTime(MilliSeconds(10)),
+  m_scanStaleTime(Seconds(200)),
+  m_scanChannel(0),
+  m_scanSampleTimer(Timer::CANCEL_ON_DESTROY),
   m_bcastSendDelay(NanoSeconds(10)),
   m_TInterfaceSendDelay(MicroSeconds(0)),
   m_sqNo(0),
+  m_helloSqNo(0),
   m_rNewChannel(0),
   m_switchTimer(Timer::CANCEL_ON_DESTROY),
   m_CATimer(Timer::CANCEL_ON_DESTROY),
@@ -50,9 +71,75 @@ Sica::Sica():
   m_niSwitchTimer(Timer::CANCEL_ON_DESTROY),
   m_TInterfaceSendTimer(Timer::CANCEL_ON_DESTROY),
   m_rInterfacePollTimer(Timer::CANCEL_ON_DESTROY),
-  TMax(MilliSeconds(10))
+  m_minSwitchDelay(Seconds(0)),
+  m_maxSwitchDelay(Seconds(0)),
+  TMax(MilliSeconds(10)),
+  m_adaptiveIntervals(false),
+  m_convergenceThreshold(0.05),
+  m_convergenceRounds(3),
+  m_intervalScale(2),
+  m_maxCAInterval(Seconds(1600)),
+  m_maxHelloInterval(Seconds(400)),
+  m_bxChangeThreshold(1),
+  m_useInterferenceGraph(false),
+  m_oneHopConflictWeight(1),
+  m_twoHopConflictWeight(0.5),
+  m_pathConflictWeight(2),
+  m_switchCoordination(false),
+  m_switchBackoff(Seconds(100)),
+  m_switchHoldDown(Seconds(0)),
+  m_lastSwitchTime(Seconds(0)),
+  m_switchCount(0),
+  m_switchDeferrals(0),
+  m_switchDelayed(0),
+  m_switchStale(0),
+  m_switchTransmitHold(false),
+  m_switchAnnouncement(false),
+  m_switchAnnounceRetries(3),
+  m_switchAnnounceInterval(MilliSeconds(20)),
+  m_switchAnnounceTimer(Timer::CANCEL_ON_DESTROY),
+  m_switchAnnounceTries(0),
+  m_switchSqNo(0),
+  m_incrementalHello(false),
+  m_helloSnapshotPeriod(5),
+  m_helloPaddingSize(100),
+  m_helloVersion(0),
+  m_hellosSinceSnapshot(0),
+  m_helloSnapshotRequested(false),
+  m_helloSnapshotWanted(false),
+  m_adaptiveHello(false),
+  m_minHelloGap(Seconds(1)),
+  m_helloBackoffFactor(2),
+  m_lastHelloTime(Seconds(0)),
+  m_hellosSent(0),
+  m_hellosSuppressed(0),
+  m_compactHello(false),
+  m_maxHelloNeighbors(255),
+  m_helloPart(0),
+  m_controlChannel(0),
+  m_rendezvousPeriod(Seconds(0)),
+  m_rendezvousWindow(MilliSeconds(50)),
+  m_rendezvousTimer(Timer::CANCEL_ON_DESTROY),
+  m_rendezvousEndTimer(Timer::CANCEL_ON_DESTROY),
+  m_inRendezvous(false),
+  m_stateTrailer(false),
+  m_linkWindow(16),
+  m_linkQualityHello(false),
+  m_etxRouting(false),
+  m_maxRetries(0),
+  m_txFeedbackTimeout(Seconds(1)),
+  m_inFlightTimer(Timer::CANCEL_ON_DESTROY),
+  m_macBackpressure(false),
+  m_maxDeviceBacklog(4),
+  m_tBackpressureChannel(0),
+  m_trafficClasses(1),
+  m_classScheduler(SicaQueue::STRICT_PRIORITY),
+  m_classWeights(""),
+  m_classExpireTimes(""),
+  m_classAccessCategories(false)
  
 {
+  m_uniformRandom = CreateObject<UniformRandomVariable> ();
 }
   
 
@@ -75,6 +162,207 @@ Sica::GetTypeId (void)
 		  DoubleValue(0.5),
 		  MakeDoubleAccessor (&Sica::m_alpha),
 		  MakeDoubleChecker<double> ())
+    .AddAttribute("AdjacentChannelLossWeight","Weight of the adjacent channel leakage from neighbors in the loss function of game decision default is 0 (orthogonal channels)",
+		  DoubleValue(0),
+		  MakeDoubleAccessor (&Sica::m_adjLossWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("QueueLossWeight","Weight of the share of the data backlog of the node queued for a channel in the loss function of game decision default is 0",
+		  DoubleValue(0),
+		  MakeDoubleAccessor (&Sica::m_queueLossWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("TxFailureLossWeight","Weight of the failure ratio of the transmissions over a channel in the loss function of game decision default is 0",
+		  DoubleValue(0),
+		  MakeDoubleAccessor (&Sica::m_txFailLossWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("NeighborLoadLossWeight","Weight of the share of the data backlog advertised by the neighbors on a channel in the loss function of game decision default is 0",
+		  DoubleValue(0),
+		  MakeDoubleAccessor (&Sica::m_niLoadLossWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("LinkQualityLossWeight","Weight of the mean delivery failure (1-1/ETX) of the links to the neighbors on a channel in the loss function of game decision default is 0",
+		  DoubleValue(0),
+		  MakeDoubleAccessor (&Sica::m_linkLossWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("ChannelSelectionStrategy","The TypeId of the decision algorithm used for channel assignment default is the multiplicative weights game",
+		  TypeIdValue(SicaMultiplicativeWeightsStrategy::GetTypeId ()),
+		  MakeTypeIdAccessor (&Sica::m_strategyTypeId),
+		  MakeTypeIdChecker ())
+    .AddAttribute("AdaptiveIntervals","Lengthen the channel assignment and hello intervals when the channel assignment has converged default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_adaptiveIntervals),
+		  MakeBooleanChecker())
+    .AddAttribute("ConvergenceThreshold","The maximum L1 change of the channel probabilities of a stable channel assignment round default is 0.05",
+		  DoubleValue(0.05),
+		  MakeDoubleAccessor (&Sica::m_convergenceThreshold),
+		  MakeDoubleChecker<double> (0,2))
+    .AddAttribute("ConvergenceRounds","The number of consecutive stable rounds after which the channel assignment has converged default is 3",
+		  UintegerValue(3),
+		  MakeUintegerAccessor (&Sica::m_convergenceRounds),
+		  MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute("IntervalScaleFactor","The factor by which the adaptive intervals are lengthened or shortened default is 2",
+		  DoubleValue(2),
+		  MakeDoubleAccessor (&Sica::m_intervalScale),
+		  MakeDoubleChecker<double> (1))
+    .AddAttribute("MaxChannelAssignmentInterval","The upper bound of the adaptive channel assignment interval, the interval never goes below ChannelAssignmentInterval default is 1600s",
+		  TimeValue(Seconds(1600)),
+		  MakeTimeAccessor (&Sica::m_maxCAInterval),
+		  MakeTimeChecker())
+    .AddAttribute("MaxHelloInterval","The upper bound of the adaptive hello interval, it is also bounded by NeighborExpireTime/2 default is 400s",
+		  TimeValue(Seconds(400)),
+		  MakeTimeAccessor (&Sica::m_maxHelloInterval),
+		  MakeTimeChecker())
+    .AddAttribute("InterferenceChangeThreshold","The change of the external bandwidth of a channel (Mbps) which restarts the convergence detection default is 1",
+		  DoubleValue(1),
+		  MakeDoubleAccessor (&Sica::m_bxChangeThreshold),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("InterferenceGraph","Weight the neighbors of a channel in the loss by hop distance and forwarding path instead of counting them equally default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_useInterferenceGraph),
+		  MakeBooleanChecker())
+    .AddAttribute("OneHopConflictWeight","Weight of a 1-hop neighbor in the interference graph default is 1",
+		  DoubleValue(1),
+		  MakeDoubleAccessor (&Sica::m_oneHopConflictWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("TwoHopConflictWeight","Weight of a 2-hop neighbor (hidden terminal) in the interference graph default is 0.5",
+		  DoubleValue(0.5),
+		  MakeDoubleAccessor (&Sica::m_twoHopConflictWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("PathConflictWeight","Factor of the weight of a neighbor on a forwarding path of the node in the interference graph default is 2",
+		  DoubleValue(2),
+		  MakeDoubleAccessor (&Sica::m_pathConflictWeight),
+		  MakeDoubleChecker<double> (0))
+    .AddAttribute("SwitchCoordination","Withdraw a switch of the R interface which conflicts with a switch announced by a neighbor with a lower Id default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_switchCoordination),
+		  MakeBooleanChecker())
+    .AddAttribute("SwitchBackoff","The maximum random backoff of the channel assignment after the neighbor switch when our switch is withdrawn default is 100s",
+		  TimeValue(Seconds(100)),
+		  MakeTimeAccessor (&Sica::m_switchBackoff),
+		  MakeTimeChecker())
+    .AddAttribute("SwitchHoldDown","The minimum time between two switches of the R interface, 0 disables the hold-down default is 0s",
+		  TimeValue(Seconds(0)),
+		  MakeTimeAccessor (&Sica::m_switchHoldDown),
+		  MakeTimeChecker())
+    .AddAttribute("SwitchTransmitHold","Hold the data packets of a neighbor which leaves the channel before the end of the frame and move them to the queue of its new channel default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_switchTransmitHold),
+		  MakeBooleanChecker())
+    .AddAttribute("SwitchAnnouncement","Announce the switches of the R interface with switch frames sent on the channels of the neighbors default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_switchAnnouncement),
+		  MakeBooleanChecker())
+    .AddAttribute("SwitchAnnounceRetries","The maximum number of repetitions of a switch announcement which is not acknowledged, they start after the switch default is 3",
+		  UintegerValue(3),
+		  MakeUintegerAccessor (&Sica::m_switchAnnounceRetries),
+		  MakeUintegerChecker<uint32_t> ())
+    .AddAttribute("SwitchAnnounceInterval","The time between the switch and the first repetition of its announcement and between two repetitions default is 20ms",
+		  TimeValue(MilliSeconds(20)),
+		  MakeTimeAccessor (&Sica::m_switchAnnounceInterval),
+		  MakeTimeChecker())
+    .AddAttribute("MinSwitchDelay","The minimum random delay before the switch of the R interface, 0 means two hello intervals default is 0",
+		  TimeValue(Seconds(0)),
+		  MakeTimeAccessor (&Sica::m_minSwitchDelay),
+		  MakeTimeChecker())
+    .AddAttribute("MaxSwitchDelay","The maximum random delay before the switch of the R interface, 0 means three hello intervals default is 0",
+		  TimeValue(Seconds(0)),
+		  MakeTimeAccessor (&Sica::m_maxSwitchDelay),
+		  MakeTimeChecker())
+    .AddAttribute("IncrementalHello","Send full hellos every HelloSnapshotPeriod hellos and incremental hellos with the changes in between default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_incrementalHello),
+		  MakeBooleanChecker())
+    .AddAttribute("HelloSnapshotPeriod","The number of hellos between two full hellos when IncrementalHello is set default is 5",
+		  UintegerValue(5),
+		  MakeUintegerAccessor (&Sica::m_helloSnapshotPeriod),
+		  MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute("HelloPaddingSize","The size of the payload of the full hellos in bytes default is 100",
+		  UintegerValue(100),
+		  MakeUintegerAccessor (&Sica::m_helloPaddingSize),
+		  MakeUintegerChecker<uint32_t> ())
+    .AddAttribute("AdaptiveHello","Send a hello when the state changes and back off the periodic hellos toward MaxHelloInterval when it does not default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_adaptiveHello),
+		  MakeBooleanChecker())
+    .AddAttribute("MinHelloGap","The minimum time between two hellos triggered by a change of the state default is 1s",
+		  TimeValue(Seconds(1)),
+		  MakeTimeAccessor (&Sica::m_minHelloGap),
+		  MakeTimeChecker())
+    .AddAttribute("HelloBackoffFactor","The growth factor of the hello interval while the state does not change default is 2",
+		  DoubleValue(2),
+		  MakeDoubleAccessor (&Sica::m_helloBackoffFactor),
+		  MakeDoubleChecker<double> (1))
+    .AddAttribute("CompactHello","Send the hellos in the compact format (varints and optional fields) default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_compactHello),
+		  MakeBooleanChecker())
+    .AddAttribute("MaxHelloNeighbors","The maximum number of neighbors carried by one hello, when there are more neighbors the successive hellos carry them in rotating parts default is 255",
+		  UintegerValue(255),
+		  MakeUintegerAccessor (&Sica::m_maxHelloNeighbors),
+		  MakeUintegerChecker<uint32_t> (1,255))
+    .AddAttribute("ControlChannel","The common control channel, when it is set the hellos and the switch announcements are sent only over this channel during the rendezvous windows, default is 0 (no common control channel)",
+		  UintegerValue(0),
+		  MakeUintegerAccessor (&Sica::m_controlChannel),
+		  MakeUintegerChecker<uint32_t> ())
+    .AddAttribute("RendezvousPeriod","The period of the rendezvous windows over the common control channel default is 0 (HelloInterval)",
+		  TimeValue(Seconds(0)),
+		  MakeTimeAccessor (&Sica::m_rendezvousPeriod),
+		  MakeTimeChecker())
+    .AddAttribute("RendezvousWindow","The duration of a rendezvous window over the common control channel, at most half of the period default is 50ms",
+		  TimeValue(MilliSeconds(50)),
+		  MakeTimeAccessor (&Sica::m_rendezvousWindow),
+		  MakeTimeChecker())
+    .AddAttribute("StateTrailer","Piggyback the state of the receiving interface (channel, new channel, switch time and Bx) on the unicast data packets default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_stateTrailer),
+		  MakeBooleanChecker())
+    .AddAttribute("LinkQualityWindow","The number of the last hello sequence numbers of a neighbor used to compute the delivery ratio of its hellos default is 16",
+		  UintegerValue(16),
+		  MakeUintegerAccessor (&Sica::m_linkWindow),
+		  MakeUintegerChecker<uint32_t> (1,32))
+    .AddAttribute("LinkQualityHello","Carry the delivery ratio of the hellos of each neighbor in the hellos, the neighbors compute the ETX from both directions default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_linkQualityHello),
+		  MakeBooleanChecker())
+    .AddAttribute("EtxRouting","Choose the next hop among the alternative routes of the routing table by the route metric plus the ETX of the link default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_etxRouting),
+		  MakeBooleanChecker())
+    .AddAttribute("MaxRetries","The maximum number of retransmissions of a data packet over one hop when the device gives it up, 0 disables the retransmissions default is 0",
+		  UintegerValue(0),
+		  MakeUintegerAccessor (&Sica::m_maxRetries),
+		  MakeUintegerChecker<uint32_t> (0,255))
+    .AddAttribute("TxFeedbackTimeout","A data packet without feedback from the device after this time is supposed dropped by the MAC and is retransmitted default is 1s",
+		  TimeValue(Seconds(1)),
+		  MakeTimeAccessor (&Sica::m_txFeedbackTimeout),
+		  MakeTimeChecker())
+    .AddAttribute("MacBackpressure","Hand the devices only the frames which end before the interface leaves the channel, by the depth of the queue of the MAC and the end of the transmissions default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_macBackpressure),
+		  MakeBooleanChecker())
+    .AddAttribute("MaxDeviceBacklog","The maximum number of frames waiting in a device with the backpressure default is 4",
+		  UintegerValue(4),
+		  MakeUintegerAccessor (&Sica::m_maxDeviceBacklog),
+		  MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute("TrafficClasses","The number of traffic classes of the data queue of each channel, the class of a packet is carried in its Sica header and the highest class has the highest priority default is 1",
+		  UintegerValue(1),
+		  MakeUintegerAccessor (&Sica::m_trafficClasses),
+		  MakeUintegerChecker<uint32_t> (1,SicaHeader::MAX_TRAFFIC_CLASSES))
+    .AddAttribute("ClassScheduler","The scheduling of the traffic classes of the data queues default is strict priority",
+		  EnumValue(SicaQueue::STRICT_PRIORITY),
+		  MakeEnumAccessor (&Sica::m_classScheduler),
+		  MakeEnumChecker (SicaQueue::STRICT_PRIORITY, "StrictPriority",
+				   SicaQueue::WEIGHTED, "Weighted"))
+    .AddAttribute("ClassWeights","The number of packets each traffic class sends per round of the weighted scheduling, separated by spaces from class 0, the missing classes have weight 1 default is empty",
+		  StringValue(""),
+		  MakeStringAccessor (&Sica::m_classWeights),
+		  MakeStringChecker())
+    .AddAttribute("ClassExpireTimes","The DataExpireTime of each traffic class, separated by spaces from class 0 (e.g. \"2000s 100ms\"), the missing classes use DataExpireTime default is empty",
+		  StringValue(""),
+		  MakeStringAccessor (&Sica::m_classExpireTimes),
+		  MakeStringChecker())
+    .AddAttribute("ClassAccessCategories","Map the traffic classes to the 802.11e access categories of QoS devices, from best effort for class 0 to voice for the highest class default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_classAccessCategories),
+		  MakeBooleanChecker())
     .AddAttribute("SicaDataPort","Port number used to send data packets defual is 550",
 		  IntegerValue(550),
 		  MakeIntegerAccessor (&Sica::SICA_DATA_PORT),
@@ -84,6 +372,14 @@ Sica::GetTypeId (void)
 		  IntegerValue(551),
 		  MakeIntegerAccessor (&Sica::SICA_HELLO_PORT),
 		  MakeIntegerChecker<uint32_t> ())
+    .AddAttribute("SicaSwitchPort","Port number used to send switch announcements default is 552",
+		  IntegerValue(552),
+		  MakeIntegerAccessor (&Sica::SICA_SWITCH_PORT),
+		  MakeIntegerChecker<uint32_t> ())
+    .AddAttribute("SicaHelloDeltaPort","Port number used to send incremental hellos default is 553",
+		  IntegerValue(553),
+		  MakeIntegerAccessor (&Sica::SICA_HELLO_DELTA_PORT),
+		  MakeIntegerChecker<uint32_t> ())
 
     .AddAttribute("MinChannelNumber","The first Index of  available channels defualt is 1",
 		  IntegerValue(1),
@@ -141,6 +437,42 @@ Sica::GetTypeId (void)
 		  TimeValue(MilliSeconds(1)),
 		  MakeTimeAccessor (&Sica::ChannelSenseRate),
 		  MakeTimeChecker())
+    .AddAttribute("SenseBackend","The source of the channel occupancy used to estimate the external bandwidth default is the channel emulators",
+		  EnumValue(SENSE_EMULATOR),
+		  MakeEnumAccessor (&Sica::m_senseBackend),
+		  MakeEnumChecker (SENSE_EMULATOR, "Emulator",
+				   SENSE_PHY, "Phy",
+				   SENSE_COMBINED, "Combined"))
+    .AddAttribute("BxEstimator","The smoothing of the external bandwidth estimation of each channel default is EWMA",
+		  EnumValue(SicaBxEstimator::EWMA_MODE),
+		  MakeEnumAccessor (&Sica::m_bxEstimatorMode),
+		  MakeEnumChecker (SicaBxEstimator::EWMA_MODE, "Ewma",
+				   SicaBxEstimator::WINDOW_MODE, "Window"))
+    .AddAttribute("BxEwmaWeight","The weight of a new sensing sample in the EWMA external bandwidth estimation default is 0.25",
+		  DoubleValue(0.25),
+		  MakeDoubleAccessor (&Sica::m_bxEwmaWeight),
+		  MakeDoubleChecker<double> (0,1))
+    .AddAttribute("BxWindowSize","The number of sensing samples of the sliding window external bandwidth estimation default is 4",
+		  UintegerValue(4),
+		  MakeUintegerAccessor (&Sica::m_bxWindowSize),
+		  MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute("BxNeighborWeight","The weight of an external bandwidth reported by a neighbor when our own estimation is confident default is 0.3",
+		  DoubleValue(0.3),
+		  MakeDoubleAccessor (&Sica::m_bxNeighborWeight),
+		  MakeDoubleChecker<double> (0,1))
+    
+    .AddAttribute("BackgroundScan","Scan the stale channels with the T interface when it has nothing to send default is false",
+		  BooleanValue(false),
+		  MakeBooleanAccessor (&Sica::m_backgroundScan),
+		  MakeBooleanChecker())
+    .AddAttribute("ScanDwellTime","The time the T interface stays over a channel for background scanning default is 10ms",
+		  TimeValue(MilliSeconds(10)),
+		  MakeTimeAccessor (&Sica::m_scanDwellTime),
+		  MakeTimeChecker())
+    .AddAttribute("ScanStaleTime","A channel whose last local sensing is older than this time is scanned again default is ChannelSenseInterval= 200s",
+		  TimeValue(Seconds(200)),
+		  MakeTimeAccessor (&Sica::m_scanStaleTime),
+		  MakeTimeChecker())
     
     .AddAttribute("BxExpireTime","The maximum period of time that Sica keeps estimated external bandwidth consumption for a channel entry in channel list defualt is 4*SenseInterval= 400s",
 		  TimeValue(Seconds (400)),
@@ -180,6 +512,34 @@ Sica::GetTypeId (void)
                      "Trace source indicating a Hello packet has been sent",
                      MakeTraceSourceAccessor (&Sica::m_sicaHelloSent),
                      "ns3::RegularWifiMac::TxOkHeader")
+    .AddTraceSource ("ChannelScanned", 
+                     "Trace source indicating the background scan of a channel has finished",
+                     MakeTraceSourceAccessor (&Sica::m_sicaChannelScanned),
+                     "ns3::Sica::ChannelScanned")
+    .AddTraceSource ("Converged", 
+                     "Trace source indicating the channel assignment of the node has converged or left the converged state",
+                     MakeTraceSourceAccessor (&Sica::m_sicaConverged),
+                     "ns3::Sica::Converged")
+    .AddTraceSource ("LossTerms", 
+                     "Trace source indicating the load terms of the loss of a channel have been computed",
+                     MakeTraceSourceAccessor (&Sica::m_sicaLossTerms),
+                     "ns3::Sica::LossTerms")
+    .AddTraceSource ("SwitchImpact", 
+                     "Trace source indicating data packets have been delayed or sent to a stale channel because of the switch of a neighbor",
+                     MakeTraceSourceAccessor (&Sica::m_sicaSwitchImpact),
+                     "ns3::Sica::SwitchImpact")
+    .AddTraceSource ("HelloSuppressed", 
+                     "Hellos were avoided by the adaptive hello scheduler, gives the number of hellos sent and suppressed so far",
+                     MakeTraceSourceAccessor (&Sica::m_sicaHelloSuppressed),
+                     "ns3::Sica::HelloSuppressed")
+    .AddTraceSource ("TxRetry", 
+                     "A data packet lost by the device is retransmitted or dropped, gives the neighbor, the number of retransmissions and whether it is dropped",
+                     MakeTraceSourceAccessor (&Sica::m_sicaTxRetry),
+                     "ns3::Sica::TxRetry")
+    .AddTraceSource ("SwitchAnnounced", 
+                     "A switch announcement is queued on the channels of the neighbors",
+                     MakeTraceSourceAccessor (&Sica::m_sicaSwitchAnnounced),
+                     "ns3::Sica::SwitchAnnounced")
     // .AddTraceSource ("ChannelProbability", 
     //                  "Trace source indicating the channel probability has been changed",
     //                  MakeTraceSourceAccessor (&Sica:: m_sicaChannelProb))
@@ -203,6 +563,23 @@ Sica::~Sica()
 {
 }
 
+//////////////////////DoDispose
+void
+Sica::DoDispose ()
+{
+  m_rSensor.Detach();
+  m_tSensor.Detach();
+  Object::DoDispose();
+}
+
+//////////////////////AssignStreams
+int64_t
+Sica::AssignStreams(int64_t stream)
+{
+  m_uniformRandom->SetStream(stream);
+  return 1;
+}
+
 //////////////////////NotifyRxReceived
 void 
 Sica::NotifyRxReceived (Ptr<Packet> packet)
@@ -282,6 +659,7 @@ Sica::Initialize()
   
   Ptr<Node> m_node = GetObject<Node>();
   m_sqNo=0;
+  m_helloSqNo=0;
   NS_ASSERT_MSG(m_node,"Using Sica without attaching to any node!");
   m_id=m_node->GetId();
   // Init Queues
@@ -297,6 +675,17 @@ Sica::Initialize()
     {
       m_loss.push_back(0);
     }
+  // decision algorithm
+  ObjectFactory strategyFactory;
+  strategyFactory.SetTypeId(m_strategyTypeId);
+  m_strategy=strategyFactory.Create<SicaChannelSelectionStrategy>();
+  // the Beta of Sica is the default of the strategy, a Beta set on the strategy itself is kept
+  struct TypeId::AttributeInformation betaInfo;
+  if (m_strategyTypeId.LookupAttributeByName("Beta",&betaInfo) && betaInfo.initialValue == betaInfo.originalInitialValue)
+    m_strategy->SetAttribute("Beta",DoubleValue(m_beta));
+  m_convergence.SetParameters(m_convergenceThreshold,m_convergenceRounds);
+  m_interferenceGraph.SetWeights(m_oneHopConflictWeight,m_twoHopConflictWeight,m_pathConflictWeight);
+  m_nb.SetLinkWindow(m_linkWindow);
  //send hello to inform neighbors
   CreateHello();
   NS_LOG_INFO("Sica node " << m_id <<" :"<<" Initialize:");
@@ -306,12 +695,13 @@ Sica::Initialize()
   NS_LOG_INFO("--Gamma " << m_gamma );
   NS_LOG_INFO("--Beta " << m_beta );
   NS_LOG_INFO("--Alpha " << m_alpha );
+  NS_LOG_INFO("--Channel selection strategy " << m_strategyTypeId.GetName() );
   NS_LOG_INFO ("--New Channel for R is " << m_rNewChannel << " time to switch " << m_switchTimer.GetDelayLeft().GetMilliSeconds());
   NS_LOG_INFO("--ChannelAssignmentInterval " << ChannelAssignmentInterval.GetMilliSeconds() );
   NS_LOG_INFO("--HelloInterval " << HelloInterval.GetMilliSeconds());
   NS_LOG_INFO("--NeighborExpireTime "<< NeighborExpireTime.GetMilliSeconds());
-  NS_LOG_INFO("--minSwitchDelay " << m_minSwitchDelay);
-  NS_LOG_INFO("--maxSwitchDelay " << m_maxSwitchDelay);
+  NS_LOG_INFO("--minSwitchDelay " << m_minSwitchDelay.GetMilliSeconds());
+  NS_LOG_INFO("--maxSwitchDelay " << m_maxSwitchDelay.GetMilliSeconds());
   NS_LOG_INFO("--TMAX is  " << TMax);
   NS_LOG_INFO("--SwitchingDelay " << SwitchingDelay.Time::ToDouble((Time::Unit)1));
 }
@@ -321,12 +711,24 @@ void
 Sica::InitializeQueues()
 {
   
+  m_channel.SetBxEstimatorParameters(m_bxEstimatorMode,m_bxEwmaWeight,m_bxWindowSize,m_bxNeighborWeight);
+  m_queue.SetTrafficClasses(m_trafficClasses,m_classScheduler);
+  std::istringstream weights(m_classWeights);
+  uint32_t weight;
+  for (uint32_t tc=0; tc < m_trafficClasses && weights >> weight; tc++)
+    m_queue.SetClassWeight(tc,weight);
+  m_classExpireTime.assign(m_trafficClasses,DataExpireTime);
+  std::istringstream expireTimes(m_classExpireTimes);
+  Time expire;
+  for (uint32_t tc=0; tc < m_trafficClasses && expireTimes >> expire; tc++)
+    m_classExpireTime[tc]=expire;
   for (uint32_t i=Min_CH; i<=Sica::Max_CH ; i++)
     {
       m_queue.CreatQueue (i);
-      m_channel.UpdateChannel(i,Max_BW,0,0,BxExpireTime);
+      m_channel.UpdateChannel(i,Max_BW,0,0,0,BxExpireTime);
       m_channel.SetChannelWeight(i,1);
     }
+  UpdateChannelSampler();
 }
 
 
@@ -348,6 +750,45 @@ NS_ASSERT_MSG(m_radio==2,"SiCA is designed only for 2 radio interfaces for each
  /// Initialize T-Interface
  m_tInterface=m_node->GetDevice(1);
  NS_LOG_DEBUG("Sica node " << m_id <<" :"<<" T_interface is   "<< m_tInterface->GetAddress() );
+ /// The MAC feedback of the data frames gives the link quality to the neighbors and triggers the retransmissions
+ for (uint32_t i = 0; i < 2; ++i)
+   {
+     Ptr<NetDevice> device=(i == 0) ? m_rInterface : m_tInterface;
+     Ptr <WifiNetDevice>wifiDevice= device->GetObject<WifiNetDevice>();
+     std::ostringstream context;
+     context << device->GetIfIndex();
+     wifiDevice->GetMac()->TraceConnect("TxOkHeader",context.str(),MakeCallback(&Sica::NotifyMacTxOk,this));
+     wifiDevice->GetMac()->TraceConnect("TxErrHeader",context.str(),MakeCallback(&Sica::NotifyMacTxErr,this));
+     wifiDevice->GetRemoteStationManager()->TraceConnectWithoutContext("MacTxDataFailed",MakeCallback(&Sica::NotifyMacTxFailed,this));
+     // the feedback of the MAC is matched to the data packets by the UID of the frame in transmission
+     wifiDevice->GetPhy()->TraceConnect("PhyTxBegin",context.str(),MakeCallback(&Sica::NotifyPhyTxBegin,this));
+     wifiDevice->GetMac()->TraceConnect("MacTxDrop",context.str(),MakeCallback(&Sica::NotifyMacTxDrop,this));
+     // the depth of the queue of the MAC gives the backpressure of the device
+     PointerValue txop;
+     PointerValue queue;
+     wifiDevice->GetMac()->GetAttributeFailSafe("DcaTxop",txop);
+     if (txop.Get<Object>())
+       txop.Get<Object>()->GetAttributeFailSafe("Queue",queue);
+     if (i == 0)
+       m_rMacQueue=queue.Get<WifiMacQueue>();
+     else
+       m_tMacQueue=queue.Get<WifiMacQueue>();
+     // a QoS MAC queues the data frames by access category (ClassAccessCategories)
+     const char *edcaTxops[4]={"VO_EdcaTxopN","VI_EdcaTxopN","BE_EdcaTxopN","BK_EdcaTxopN"};
+     std::vector<Ptr<WifiMacQueue> > &edcaQueues=(i == 0) ? m_rEdcaQueues : m_tEdcaQueues;
+     edcaQueues.clear();
+     for (uint32_t ac = 0; ac < 4; ++ac)
+       {
+	 PointerValue edcaTxop;
+	 PointerValue edcaQueue;
+	 if (wifiDevice->GetMac()->GetAttributeFailSafe(edcaTxops[ac],edcaTxop) && edcaTxop.Get<Object>())
+	   edcaTxop.Get<Object>()->GetAttributeFailSafe("Queue",edcaQueue);
+	 if (edcaQueue.Get<WifiMacQueue>())
+	   edcaQueues.push_back(edcaQueue.Get<WifiMacQueue>());
+       }
+     if (m_macBackpressure && m_classAccessCategories && edcaQueues.empty())
+       NS_LOG_WARN("Sica node " << m_id <<" :"<< "The MAC of device " << device->GetIfIndex() << " has no access category queue, the backpressure does not see the QoS frames");
+   }
 }
 
 //////////////////////InitializeChannel
@@ -359,14 +800,14 @@ Sica::InitializeChannel()
   //  WifiPhy::RxErrorCallback errorCallback = MakeCallback(&Sica::NotifyRxDropped, this);
    errorCallback = MakeCallback(&Sica::NotifyRxDropped, this);
    wifiphy->SetReceiveErrorCallback(errorCallback);
+   if (m_senseBackend != SENSE_EMULATOR && !m_rSensor.IsAttached())
+     m_rSensor.SetPhy(wifiphy);
+   if (m_backgroundScan && m_senseBackend != SENSE_EMULATOR && !m_tSensor.IsAttached())
+     m_tSensor.SetPhy(m_tInterface->GetObject<WifiNetDevice>()->GetPhy());
   //  wifiphy->SetReceiveErrorCallback(MakeCallback(&Sica::NotifyRxDropped, this));
   //  UniformVariable uniRnd(Min_CH,Max_CH);
-  //  Ptr<UniformRandomVariable> uniRnd = CreateObject<UniformRandomVariable> (Min_CH,Max_CH);
-   Ptr<UniformRandomVariable> uniRnd = CreateObject<UniformRandomVariable> ();
-   uniRnd->SetAttribute ("Min", DoubleValue (Min_CH));
-   uniRnd->SetAttribute ("Max", DoubleValue (Max_CH));
   //  m_rChannel= static_cast<uint32_t>(uniRnd.GetInteger(Min_CH,Max_CH));
-   m_rChannel= static_cast<uint32_t>(uniRnd->GetInteger(Min_CH,Max_CH));
+   m_rChannel= static_cast<uint32_t>(m_uniformRandom->GetInteger(Min_CH,Max_CH));
    wifiphy->SetChannelNumber(m_rChannel);
    // m_rChannel= wifiphy->GetChannelNumber();
    m_rNewChannel= m_rChannel;
@@ -383,7 +824,10 @@ Sica::InitializeTimers()
    ///hello  timer
    m_helloTimer.SetDelay(HelloInterval);
    m_helloTimer.SetFunction(&Sica::CreateHello,this);
-   m_helloTimer.Schedule (); 
+   if (m_controlChannel == 0)
+     m_helloTimer.Schedule (); 
+   else
+     InitializeRendezvous();
    ///sense timer 
    m_channelSenseTimer.SetDelay(ChannelSenseInterval);
    m_channelSenseTimer.SetFunction(&Sica::StartSenseCurrentChannel,this);
@@ -394,9 +838,13 @@ Sica::InitializeTimers()
   ///neighbor switch timer, It would be scheduled  when a node found switching information in hello messages
   m_niSwitchTimer.SetFunction(&Sica::HandleNeighborSwitchChannel,this);
   /// R interface switch timer
-  m_minSwitchDelay=2*HelloInterval.GetMilliSeconds();
-  m_maxSwitchDelay=3*HelloInterval.GetMilliSeconds();
+  if (m_minSwitchDelay.IsZero())
+    m_minSwitchDelay=MilliSeconds(2*HelloInterval.GetMilliSeconds());
+  if (m_maxSwitchDelay.IsZero())
+    m_maxSwitchDelay=MilliSeconds(3*HelloInterval.GetMilliSeconds());
+  m_maxSwitchDelay=std::max(m_maxSwitchDelay,m_minSwitchDelay);
   m_switchTimer.SetFunction(&Sica::SwitchRInterface,this);
+  m_switchAnnounceTimer.SetFunction(&Sica::SendSwitchAnnouncement,this);
   /// channel assignment timer
   m_CATimer.SetDelay(ChannelAssignmentInterval);
   m_CATimer.SetFunction(&Sica::GameChannelAssignment,this);
@@ -412,9 +860,29 @@ Sica::InitializeTimers()
   m_rInterfacePollTimer.SetDelay(QueuePollTime);
   m_rInterfacePollTimer.SetFunction(&Sica::RInterfaceCheckChannelQueue,this);
   m_rInterfacePollTimer.Schedule();
+  // background scan sampling timer, it would be scheduled when the T interface is parked on a channel
+  m_scanSampleTimer.SetDelay(ChannelSenseRate);
+  m_scanSampleTimer.SetFunction(&Sica::SampleScanChannel,this);
+  // data packets without feedback from the devices, it would be scheduled when a packet is handed to a device
+  m_inFlightTimer.SetFunction(&Sica::ExpireInFlight,this);
 
  }
 
+//////////////////////InitializeRendezvous
+void 
+Sica::InitializeRendezvous()
+{
+  NS_ASSERT_MSG(m_controlChannel >= Min_CH && m_controlChannel <= Max_CH,"Common control channel is out of range");
+  if (m_rendezvousPeriod.IsZero())
+    m_rendezvousPeriod=HelloInterval;
+  m_rendezvousWindow=std::min(m_rendezvousWindow,MilliSeconds(m_rendezvousPeriod.GetMilliSeconds()/2));
+  m_rendezvousTimer.SetFunction(&Sica::StartRendezvous,this);
+  m_rendezvousEndTimer.SetFunction(&Sica::EndRendezvous,this);
+  // the first windows are aligned on the simulation time, the hellos keep the neighbors aligned afterwards
+  int64_t period=m_rendezvousPeriod.GetMicroSeconds();
+  m_rendezvousTimer.Schedule(MicroSeconds(period-Simulator::Now().GetMicroSeconds()%period));
+}
+
 //////////////////////GetTChannel
 uint32_t 
 Sica::GetTChannel()
@@ -481,16 +949,15 @@ Sica::ChannelIsBusy(uint32_t chId )
  }
 }
 
-//////////////////////ModifySenseChannelFlag
-void
-Sica::ModifySenseChannelFlag(uint32_t c)
+//////////////////////GetChannelBusyFraction
+double 
+Sica::GetChannelBusyFraction(uint32_t chId )
 {
-  if (m_channel.IsBeingSensed(c))
-    m_channel.ResetChannelSenseFlag(c);
-  else 
-    m_channel.SetChannelSenseFlag(c);
-  return;
+  if (m_channelEmuObjects.GetN()==0)
+    return 0;
+  return m_channelEmuObjects.GetBusyFraction(chId);
 }
+
 //////////////////////StartSenseCurrentChannel
 void 
 Sica::StartSenseCurrentChannel()
@@ -505,11 +972,15 @@ Sica::StartSenseCurrentChannel()
   else {
     NS_LOG_INFO("Sica node " << m_id <<" :"<<"Sensing starts for channel "<< m_rChannel);
     m_channelSenseFlag=true;
-    ModifySenseChannelFlag(m_rChannel);
+    m_channel.AddSenseWindow(m_rChannel,Simulator::Now(),Simulator::Now()+ChannelSensePeriod);
     m_idleChTime=MilliSeconds(0);
     m_busyChTime=MilliSeconds(0);
+    m_senseStartTime=Simulator::Now();
+    if (m_rSensor.IsAttached())
+      m_phyBusyAtSenseStart=m_rSensor.GetBusyTime(m_rChannel);
     Simulator::Schedule(ChannelSensePeriod,&Sica::EndSenseCurrentChannel,this);
-    SenseCurrentChannel();
+    if (m_senseBackend != SENSE_PHY)
+      SenseCurrentChannel();
   }
   return;
 }
@@ -520,10 +991,11 @@ Sica::StartSenseCurrentChannel()
 void 
 Sica::SenseCurrentChannel()
 {
-  if(ChannelIsBusy(m_rChannel))
-    m_busyChTime+=ChannelSenseRate;
-  else 
-    m_idleChTime+=ChannelSenseRate; 
+  // busy time of adjacent channels partially raises the busy fraction of the current channel
+  double busy=GetChannelBusyFraction(m_rChannel);
+  Time busySample=NanoSeconds(static_cast<int64_t>(ChannelSenseRate.GetNanoSeconds()*busy));
+  m_busyChTime+=busySample;
+  m_idleChTime+=ChannelSenseRate-busySample; 
   
   m_channelSenseRateTimer.Cancel ();
   m_channelSenseRateTimer.Schedule();
@@ -535,18 +1007,173 @@ void
 Sica::EndSenseCurrentChannel()
 {
   m_channelSenseRateTimer.Cancel ();
-  ModifySenseChannelFlag(m_rChannel);
   m_channelSenseFlag=false;
   double bx;
+  double before=m_channel.GetChannelExtBandwidth(m_rChannel);
+  bx=ComputeSensedBusyFraction()*Max_BW;
+  m_channel.SetChannelExtBandwidth(m_rChannel,bx,BxExpireTime);
+  CheckInterferenceChange(m_rChannel,before);
+  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Sensing Finished, Bx= " << bx << " estimation is " << m_channel.GetChannelExtBandwidth(m_rChannel) );
+  return;
+}
+
+////////////////////// ComputeSensedBusyFraction
+double 
+Sica::ComputeSensedBusyFraction()
+{
+  double emuBusy=0;
+  double phyBusy=0;
   double tBusy=m_busyChTime.Time::ToDouble((Time::Unit)1);
   double tIdle=m_idleChTime.Time::ToDouble((Time::Unit)1);
-  bx=(tBusy/(tBusy+tIdle))*Max_BW;
-  m_channel.SetChannelExtBandwidth(m_rChannel,static_cast<uint32_t>(bx),BxExpireTime);
-  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Sensing Finished, T_busy= "<<tBusy << " T_idle= "<< tIdle << " Bx= " << static_cast<uint32_t>(bx) );
-  return;
+  if (tBusy+tIdle > 0)
+    emuBusy=tBusy/(tBusy+tIdle);
+  double tSense=(Simulator::Now()-m_senseStartTime).GetSeconds();
+  if (m_rSensor.IsAttached() && tSense > 0)
+    phyBusy=std::min((m_rSensor.GetBusyTime(m_rChannel)-m_phyBusyAtSenseStart).GetSeconds()/tSense,1.0);
+  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Sensed busy fraction, emulator= "<<emuBusy << " phy= "<< phyBusy );
+  return CombineBusyFraction(emuBusy,phyBusy);
+}
+
+////////////////////// CombineBusyFraction
+double 
+Sica::CombineBusyFraction(double emuBusy, double phyBusy)
+{
+  switch (m_senseBackend)
+    {
+    case SENSE_PHY:
+      return phyBusy;
+    case SENSE_COMBINED:
+      // the emulated interference is not seen by the phy, both are considered independent
+      return (1-(1-emuBusy)*(1-phyBusy));
+    default:
+      return emuBusy;
+    }
 }
 
 
+//////////////////////StartBackgroundScan
+bool 
+Sica::StartBackgroundScan()
+{
+  if (!m_backgroundScan || IsScanning())
+    return false;
+  // the T interface must be free for the next rendezvous
+  if (m_controlChannel > 0 && (m_inRendezvous || m_rendezvousTimer.GetDelayLeft() < SwitchingDelay+m_scanDwellTime))
+    return false;
+  // scanning must not delay any data or hello
+  for (uint32_t i=Min_CH; i<=Max_CH; i++)
+    if (m_queue.GetSize(i,SicaQueueEntry::Hello_Type) > 0 || m_queue.GetSize(i,SicaQueueEntry::Data_Type) > 0)
+      return false;
+  // the R channel is sensed by the R interface
+  int ch=m_channel.FindStaleChannel(m_scanStaleTime,m_rChannel);
+  if (ch == -1 || m_channel.IsBeingSensed(ch))
+    return false;
+  if (!SwitchTInterface(static_cast<uint32_t>(ch)))
+    return false;
+  m_scanChannel=static_cast<uint32_t>(ch);
+  m_scanBusyTime=MilliSeconds(0);
+  m_scanIdleTime=MilliSeconds(0);
+  m_scanStartTime=Simulator::Now()+SwitchingDelay;
+  if (m_tSensor.IsAttached())
+    m_tPhyBusyAtScanStart=m_tSensor.GetBusyTime(m_scanChannel);
+  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Background scan starts for channel "<< m_scanChannel << " last sensed "<< m_channel.GetChannelSenseAge(m_scanChannel) << " ago");
+  Simulator::Schedule(SwitchingDelay+m_scanDwellTime,&Sica::EndBackgroundScan,this);
+  if (m_senseBackend != SENSE_PHY)
+    {
+      m_scanSampleTimer.Cancel();
+      m_scanSampleTimer.Schedule(SwitchingDelay);
+    }
+  return true;
+}
+
+//////////////////////SampleScanChannel
+void 
+Sica::SampleScanChannel()
+{
+  double busy=GetChannelBusyFraction(m_scanChannel);
+  Time busySample=NanoSeconds(static_cast<int64_t>(ChannelSenseRate.GetNanoSeconds()*busy));
+  m_scanBusyTime+=busySample;
+  m_scanIdleTime+=ChannelSenseRate-busySample; 
+  m_scanSampleTimer.Cancel();
+  m_scanSampleTimer.Schedule(ChannelSenseRate);
+}
+
+//////////////////////EndBackgroundScan
+void 
+Sica::EndBackgroundScan()
+{
+  m_scanSampleTimer.Cancel();
+  double emuBusy=0;
+  double phyBusy=0;
+  double tBusy=m_scanBusyTime.Time::ToDouble((Time::Unit)1);
+  double tIdle=m_scanIdleTime.Time::ToDouble((Time::Unit)1);
+  if (tBusy+tIdle > 0)
+    emuBusy=tBusy/(tBusy+tIdle);
+  double tScan=(Simulator::Now()-m_scanStartTime).GetSeconds();
+  if (m_tSensor.IsAttached() && tScan > 0)
+    phyBusy=std::min((m_tSensor.GetBusyTime(m_scanChannel)-m_tPhyBusyAtScanStart).GetSeconds()/tScan,1.0);
+  double bx=CombineBusyFraction(emuBusy,phyBusy)*Max_BW;
+  double before=m_channel.GetChannelExtBandwidth(m_scanChannel);
+  m_channel.SetChannelExtBandwidth(m_scanChannel,bx,BxExpireTime);
+  CheckInterferenceChange(m_scanChannel,before);
+  m_sicaChannelScanned(m_id,m_scanChannel,bx,Simulator::Now());
+  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Background scan finished for channel "<< m_scanChannel << ", Bx= " << bx << " estimation is " << m_channel.GetChannelExtBandwidth(m_scanChannel) );
+  m_scanChannel=0;
+}
+
+//////////////////////StartRendezvous
+void 
+Sica::StartRendezvous()
+{
+  m_rendezvousTimer.Cancel();
+  m_rendezvousTimer.Schedule(m_rendezvousPeriod);
+  m_rendezvousEndTimer.Cancel();
+  m_rendezvousEndTimer.Schedule(m_rendezvousWindow);
+  m_inRendezvous=true;
+  // the R interface listens to the control channel during the window
+  Ptr<WifiPhy> wifiphy = m_rInterface->GetObject<WifiNetDevice>()->GetPhy();
+  wifiphy->SetChannelNumber(m_controlChannel);
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Rendezvous over channel " << m_controlChannel << " for " << m_rendezvousWindow.GetMilliSeconds() << "ms");
+  CreateHello();
+  if (!m_switchUnacked.empty() && !m_switchAnnounceTimer.IsRunning())
+    SendSwitchAnnouncement();
+  // the neighbors send their hellos at the same time, spread the transmissions over the first half of the window
+  uint32_t jitter=m_uniformRandom->GetInteger(0,m_rendezvousWindow.GetMicroSeconds()/2);
+  Simulator::Schedule(MicroSeconds(jitter),&Sica::TInterfaceStartSend,this,m_controlChannel);
+}
+
+//////////////////////EndRendezvous
+void 
+Sica::EndRendezvous()
+{
+  m_inRendezvous=false;
+  Ptr<WifiPhy> wifiphy = m_rInterface->GetObject<WifiNetDevice>()->GetPhy();
+  wifiphy->SetChannelNumber(m_rChannel);
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Rendezvous is over, R interface is back to channel " << m_rChannel);
+}
+
+//////////////////////AlignRendezvous
+void 
+Sica::AlignRendezvous(Time niRendezvous)
+{
+  // the earliest window wins, a small offset is absorbed by the window itself
+  if (!niRendezvous.IsStrictlyPositive() || niRendezvous+m_rendezvousWindow/2 >= m_rendezvousTimer.GetDelayLeft())
+    return;
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Next rendezvous is advanced by " << (m_rendezvousTimer.GetDelayLeft()-niRendezvous).GetMilliSeconds() << "ms");
+  m_rendezvousTimer.Cancel();
+  m_rendezvousTimer.Schedule(niRendezvous);
+}
+
+//////////////////////GetControlQueueSize
+uint32_t 
+Sica::GetControlQueueSize(uint32_t ch)
+{
+  // the control packets wait for the rendezvous over the control channel
+  if (m_controlChannel > 0 && (!m_inRendezvous || ch != m_controlChannel))
+    return 0;
+  return (m_queue.GetSize(ch,SicaQueueEntry::Hello_Type));
+}
+
 //////////////////////ReScheduleTimer
 void 
 Sica::ReScheduleTimer(Timer *t, Time minDelay )
@@ -573,11 +1200,30 @@ Sica::RecvPacket(Ptr<NetDevice> dstDevice,Ptr<const Packet> packet ,uint16_t pro
   if (protocolNumber== SICA_DATA_PORT)
     {
       NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<<"One data  packet received at rInterface  "<< dstDevice->GetAddress());
-      ProcessRcvData(packet->Copy());
+      ProcessRcvData(packet->Copy(),srcAddr);
       uint32_t rch=dstDevice->GetObject<WifiNetDevice>()->GetPhy()->GetChannelNumber();
+      if (!m_switchUnacked.empty() && rch == m_rChannel)
+	{
+	  // the neighbor reached us on our new channel
+	  int32_t niId=m_nb.FindDeviceAddr(srcAddr);
+	  if (niId >= 0)
+	    AckSwitchAnnouncement(niId);
+	}
       m_sicaRxDevReceived(packet->Copy(),m_id,rch);
 	return true;
     }
+  if (protocolNumber == SICA_SWITCH_PORT)
+    {
+      NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<<"One switch announcement received at rInterface  "<< dstDevice->GetAddress());
+      ProcessRcvSwitch(packet->Copy());
+      return true;
+    }
+  if (protocolNumber == SICA_HELLO_DELTA_PORT)
+    {
+      NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<<"One incremental Hello packet received at rInterface  "<< dstDevice->GetAddress());
+      ProcessRcvHelloDelta(packet->Copy(),srcAddr);
+      return true;
+    }
   if (protocolNumber == SICA_HELLO_PORT)
     {
     NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<<"One Hello packet received at rInterface  "<< dstDevice->GetAddress());
@@ -596,9 +1242,77 @@ void
 Sica::ProcessRcvHello(Ptr<Packet> p, Address srcAddr)
 {
   SicaHelloHeader sHeader;
-  Address niTAddr=srcAddr;
   p->RemoveHeader(sHeader);
+  // the base of the next incremental hellos of the neighbor, one part of the neighbors is not a full state
+  if (sHeader.IsValid() && sHeader.GetOrigin() != m_id)
+    {
+      if (sHeader.GetParts() > 1)
+	m_niHello.erase(sHeader.GetOrigin());
+      else
+	m_niHello[sHeader.GetOrigin()]=sHeader;
+    }
+  // each part is processed on its own, the 2-hop neighbors of the other parts are kept until they expire
+  HandleHello(sHeader,srcAddr);
+  if (sHeader.IsValid())
+    m_nb.RecordNiHello(sHeader.GetOrigin(),sHeader.GetSeqNo());
+}
+
+
+//////////////////////ProcessRcvHelloDelta
+void
+Sica::ProcessRcvHelloDelta(Ptr<Packet> p, Address srcAddr)
+{
+  SicaHelloDeltaHeader delta;
+  p->RemoveHeader(delta);
+  if (!delta.IsValid() || delta.GetOrigin() == m_id)
+    return;
+  m_nb.RecordNiHello(delta.GetOrigin(),delta.GetSeqNo());
+  std::map<uint32_t, SicaHelloHeader>::iterator i=m_niHello.find(delta.GetOrigin());
+  if (i == m_niHello.end())
+    {
+      NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Incremental hello from " << delta.GetOrigin() << " without full hello, ask for a full one");
+      m_helloSnapshotWanted=true;
+      return;
+    }
+  int16_t gap=static_cast<int16_t>(delta.GetVersion()-i->second.GetVersion());
+  if (gap <= 0)
+    return; // older than the state we have
+  if (gap > 1)
+    {
+      // the state is unknown until the next full hello of the neighbor
+      NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Missed " << gap-1 << " incremental hellos from " << delta.GetOrigin() << ", ask for a full one");
+      m_niHello.erase(i);
+      m_helloSnapshotWanted=true;
+      return;
+    }
+  delta.Apply(i->second);
+  HandleHello(i->second,srcAddr);
+}
+
+
+//////////////////////RmvExpiredNeighbors
+void
+Sica::RmvExpiredNeighbors()
+{
+  std::vector<uint32_t> removed;
+  m_nb.RmvExpiredNi(NeighborExpireTime,&removed);
+  // an expired neighbor must send a full hello again
+  for (uint32_t i=0; i<removed.size(); i++)
+    m_niHello.erase(removed[i]);
+}
+
+
+//////////////////////HandleHello
+void
+Sica::HandleHello(SicaHelloHeader sHeader, Address srcAddr)
+{
+  Address niTAddr=srcAddr;
   if (sHeader.IsValid()){
+    if (sHeader.GetFlags() & SicaHelloHeader::SNAPSHOT_REQUEST)
+      m_helloSnapshotRequested=true;
+    // in common control channel mode the neighbor advertises its next rendezvous, taken when the hello was created
+    if (m_controlChannel > 0)
+      AlignRendezvous(sHeader.GetHelloInterval()-(Simulator::Now()-sHeader.GetOriginTime()));
     NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Hello received from " << sHeader.GetOrigin()  << " SqNo "<< sHeader.GetSeqNo());
     //sHeader.Print(std::cout);
     // switch time of the neighbor to another channel
@@ -614,20 +1328,60 @@ Sica::ProcessRcvHello(Ptr<Packet> p, Address srcAddr)
       if (niSwitchTime.IsStrictlyPositive())
 	NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Neighbor switch after  " << niSwitchTime.GetMilliSeconds());
       ReScheduleTimer(&m_niSwitchTimer,niSwitchTime);
+      // the neighbor already knows our new channel
+      if (!m_switchUnacked.empty() && sHeader.GetNiRChannel(m_id) == static_cast<int32_t>(m_rChannel))
+	AckSwitchAnnouncement(sHeader.GetOrigin());
+      // the neighbor reports how many of our hellos it received
+      double fwdRatio=sHeader.GetNiQuality(m_id);
+      if (fwdRatio >= 0)
+	m_nb.SetNiForwardRatio(sHeader.GetOrigin(),fwdRatio);
     }// If update 
   }//if isvalid
   else  
   NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Got an invalid hello header");
   return;
-}//ProcessRcvHello
+}//HandleHello
+
+
+//////////////////////ProcessRcvSwitch
+void
+Sica::ProcessRcvSwitch(Ptr<Packet> p)
+{
+  SicaSwitchHeader sHeader;
+  p->RemoveHeader(sHeader);
+  uint32_t niId=sHeader.GetOrigin();
+  if (!sHeader.IsValid() || niId == m_id || !m_nb.FindNeighbor(niId))
+    return; // an unknown neighbor is learnt from its hello
+  uint32_t niNewCh=sHeader.GetRNewChannel();
+  if (niNewCh < Min_CH || niNewCh > Max_CH)
+    return;
+  Time niSwitchTime=sHeader.GetTimeToSwitch();
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Switch announcement " << sHeader.GetSeqNo() << " from " << niId << " to channel " << niNewCh << " after " << niSwitchTime.GetMicroSeconds() << "us");
+  m_nb.SetNiNewChannel(niId,niNewCh);
+  if (m_nb.GetNiChannel(niId) == static_cast<int32_t>(niNewCh))
+    return; // the switch is withdrawn or already known to be done
+  m_nb.SetNiSwitchTime(niId,niSwitchTime);
+  if (niSwitchTime.IsStrictlyPositive())
+    ReScheduleTimer(&m_niSwitchTimer,niSwitchTime);
+  else
+    HandleNeighborSwitchChannel();
+}
   
 
 //////////////////////ProcessRcvData
 void 
-Sica::ProcessRcvData(Ptr<Packet> p)
+Sica::ProcessRcvData(Ptr<Packet> p, Address srcAddr)
 {
   SicaHeader sHeader;
   p->PeekHeader(sHeader);
+  // the retransmissions are counted over each hop
+  SicaRetryTag retryTag;
+  p->RemovePacketTag(retryTag);
+  // the access category is chosen again by the next hop
+  QosTag qosTag;
+  p->RemovePacketTag(qosTag);
+  if (sHeader.HasStateTrailer())
+    HandleStateTrailer(sHeader,srcAddr);
   // if there is any bug related to packet tags uncomments these two lines
 // p->RemoveAllPacketTags ();
 //   p->RemoveAllByteTags ();
@@ -641,7 +1395,7 @@ Sica::ProcessRcvData(Ptr<Packet> p)
   else 
     {
        p->RemoveHeader(sHeader);
-      int nextHopId= AddDataHeaders(p,srcId,dstId,sHeader.GetOriginTime());
+      int nextHopId= AddDataHeaders(p,srcId,dstId,sHeader.GetOriginTime(),sHeader.GetTrafficClass());
       if (nextHopId != -1)
 	{
 	  uint32_t nextHopChannel= static_cast<uint32_t>(m_nb.GetNiChannel(nextHopId));
@@ -652,6 +1406,45 @@ Sica::ProcessRcvData(Ptr<Packet> p)
 
 
 
+//////////////////////HandleStateTrailer
+void 
+Sica::HandleStateTrailer(SicaHeader sHeader, Address srcAddr)
+{
+  // the trailer describes the transmitter, which is not the originator of a forwarded packet
+  int32_t niId=m_nb.FindDeviceAddr(srcAddr);
+  if (niId < 0 || !m_nb.IsDirectNeighbor(niId))
+    return; // an unknown neighbor is learnt from its hello
+  uint32_t rCh=sHeader.GetRChannel();
+  uint32_t rNewCh=sHeader.GetRNewChannel();
+  if (rCh > Max_CH || rCh < Min_CH || rNewCh > Max_CH || rNewCh < Min_CH)
+    return;
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "State trailer received from " << niId << " channel " << rCh);
+  // only the 1-hop state is refreshed, the neighbor entry keeps the time of the last hello
+  int32_t prevCh=m_nb.GetNiChannel(niId);
+  if (prevCh != static_cast<int32_t>(rCh))
+    {
+      if (prevCh >= 0)
+	ShuffleNeighborData(niId,static_cast<uint32_t>(prevCh),rCh);
+      m_nb.SetNiChannel(niId,rCh);
+      if (prevCh >= 0)
+	m_channel.SetChannelNeighbors(static_cast<uint32_t>(prevCh),m_nb.GetNiOnChannel(static_cast<uint32_t>(prevCh)));
+      m_channel.SetChannelNeighbors(rCh,m_nb.GetNiOnChannel(rCh));
+    }
+  m_nb.SetNiNewChannel(niId,rNewCh);
+  if (rNewCh != rCh)
+    {
+      Time niSwitchTime=sHeader.GetTimeToSwitch();
+      m_nb.SetNiSwitchTime(niId,niSwitchTime);
+      if (niSwitchTime.IsStrictlyPositive())
+	ReScheduleTimer(&m_niSwitchTimer,niSwitchTime);
+      else
+	HandleNeighborSwitchChannel();
+    }
+  double before=m_channel.GetChannelExtBandwidth(rCh);
+  m_channel.UpdateChannel(rCh,Max_BW,SicaBxEstimator::FromFixed(sHeader.GetExtBw()),sHeader.GetExtBwConfidence(),m_nb.GetNiOnChannel(rCh),BxExpireTime);
+  CheckInterferenceChange(rCh,before);
+}
+
 //////////////////////UpdateNeighborTable
 bool 
 Sica::UpdateNeighborTable(SicaHelloHeader sicaHelloHeader, Address srcAddr)
@@ -693,8 +1486,29 @@ Sica::UpdateNeighborTable(SicaHelloHeader sicaHelloHeader, Address srcAddr)
      NS_LOG_DEBUG("--neighbor R-channel "<< niRChannel);
      NS_LOG_DEBUG("--neighbor prev R-channel "<< niRPrevChannel);
      NS_LOG_DEBUG("--neighbor hopcounts "<< niHopCounts);
+     m_nb.SetNiLoad(niId,sicaHelloHeader.GetLoad());
+     // a neighbor with a long hello interval must not expire between two hellos
+     Time niLifetime=2*sicaHelloHeader.GetHelloInterval();
+     if (niLifetime.IsStrictlyPositive())
+       m_nb.SetNiLifetime(niId,niLifetime);
+     // a 2-hop neighbor is refreshed once every round of parts
+     Time niTwoHopLifetime=niLifetime;
+     if (sicaHelloHeader.GetParts() > 1)
+       {
+	 Time period=sicaHelloHeader.GetHelloInterval().IsStrictlyPositive() ? sicaHelloHeader.GetHelloInterval() : HelloInterval;
+	 niTwoHopLifetime=std::max(niLifetime,2*sicaHelloHeader.GetParts()*period);
+       }
      if (niRPrevChannel !=-1 && static_cast<uint32_t>(niRPrevChannel)!= niRChannel) // Information pushed into  neighbor table and  the  neighbor changes its channel immediately, check packet 
-       m_queue.ShuffleData(static_cast<uint32_t>(niRPrevChannel),niRChannel,niId);
+       ShuffleNeighborData(niId,static_cast<uint32_t>(niRPrevChannel),niRChannel);
+     if (m_switchCoordination && m_rNewChannel != m_rChannel)
+       {
+	 Time backoff=CoordinateSwitch();
+	 if (backoff.IsStrictlyPositive() && backoff < m_CATimer.GetDelayLeft())
+	   {
+	     m_CATimer.Cancel();
+	     m_CATimer.Schedule(backoff);
+	   }
+       }
     while (sicaHelloHeader.RemoveNiRChannel(niInf))
       {
 	niId= niInf.first;
@@ -711,10 +1525,12 @@ Sica::UpdateNeighborTable(SicaHelloHeader sicaHelloHeader, Address srcAddr)
 
 	  niSwitchTime=MilliSeconds(0);
 	  updateFlag2= m_nb.Update(niId,niHopCounts,niRadio,niRChannel,niRAddr ,niTAddr,helloTimestamp,niSwitchTime,niRNewChannel);
+	  if (updateFlag2 && m_nb.GetNiHops(niId) > 1)
+	    m_nb.SetNiLifetime(niId,niTwoHopLifetime);
 	  if (updateFlag2 && m_nb.GetNiHops(niId)==1 && niRPrevChannel !=-1 && static_cast<uint32_t>(niRPrevChannel)!= niRChannel){
 	    /// It means We have updated information for one-hop neighbor changes its channel immediately, check packet.
 	    /// Do packet exchange before update
-	    m_queue.ShuffleData(static_cast<uint32_t>(niRPrevChannel),niRChannel,niId);
+	    ShuffleNeighborData(niId,static_cast<uint32_t>(niRPrevChannel),niRChannel);
 	  }
 	 
 	  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"Neighbor information is updated for neighbor ID  "<<niInf.first);
@@ -734,13 +1550,16 @@ Sica::UpdateChannelTable(SicaHelloHeader sicaHelloHeader)
  //Current channel of neighbor who sent hello
   uint32_t niRChannel=sicaHelloHeader.GetRChannel();
   //Estimation external bandwidth by neighbor
-  uint32_t niEstimationBx=static_cast <uint32_t>(sicaHelloHeader.GetExtBw());
+  double niEstimationBx=SicaBxEstimator::FromFixed(sicaHelloHeader.GetExtBw());
+  double niBxConfidence=sicaHelloHeader.GetExtBwConfidence();
   // number of neighbors on channel
   uint32_t niOnChannel=m_nb.GetNiOnChannel(niRChannel);
   Time niSenseTime=sicaHelloHeader.GetSenseTime();
-  m_channel.UpdateChannel(niRChannel,Max_BW,niEstimationBx,niOnChannel,BxExpireTime);
+  double before=m_channel.GetChannelExtBandwidth(niRChannel);
+  m_channel.UpdateChannel(niRChannel,Max_BW,niEstimationBx,niBxConfidence,niOnChannel,BxExpireTime);
+  CheckInterferenceChange(niRChannel,before);
   NS_LOG_DEBUG( "Sica node " << m_id <<" :"<< "Channel Information is updated for channel  " << niRChannel );
-  NS_LOG_DEBUG("--Bx  " <<  niEstimationBx );
+  NS_LOG_DEBUG("--Bx  " <<  niEstimationBx << " confidence "<< niBxConfidence );
   NS_LOG_DEBUG("--Number of Ni on channel " << niOnChannel );
   NS_LOG_DEBUG("--Bandwidth information expired after "<< BxExpireTime.GetMilliSeconds());
 
@@ -748,10 +1567,9 @@ Sica::UpdateChannelTable(SicaHelloHeader sicaHelloHeader)
     {
       if( niRChannel != m_rChannel)
 	{
-	  // set the sense flag for the neighbor channel to stop sending on it
-	  Simulator::Schedule(niSenseTime,&Sica::ModifySenseChannelFlag,this, static_cast<uint32_t>(niRChannel));
-	  // reset the sense flag for the neighbor channel after sense period
-	  Simulator::Schedule(niSenseTime+ChannelSensePeriod,&Sica::ModifySenseChannelFlag,this,static_cast<uint32_t>(niRChannel));
+	  // stop sending over the neighbor channel during its sense period
+	  Time senseStart=Simulator::Now()+niSenseTime;
+	  m_channel.AddSenseWindow(niRChannel,senseStart,senseStart+ChannelSensePeriod);
 	}
       else if  (niRChannel == m_rChannel)// If we have the same channel, set the sense timer to the shortest time
 	ReScheduleTimer(&m_channelSenseTimer,niSenseTime);
@@ -769,14 +1587,121 @@ Sica::CreateHello()
 {
   if(m_helloTimer.IsRunning())
     m_helloTimer.Cancel ();
-  m_helloTimer.Schedule ();
+  // in common control channel mode the hellos are sent only at the rendezvous
+  if (m_controlChannel > 0 && !m_inRendezvous)
+    return;
   SicaHelloHeader sHeader=CreateHelloHeader();
-  Ptr<Packet> p= Create<Packet>(100);
+  if (m_controlChannel > 0)
+    sHeader.SetHelloInterval(m_rendezvousTimer.GetDelayLeft());
+  else
+    {
+      if (m_adaptiveHello)
+	AdaptHelloInterval(sHeader);
+      m_helloTimer.Schedule ();
+    }
+  m_hellosSent++;
+  m_lastHelloTime=Simulator::Now();
+  Ptr<Packet> p;
+  bool split=(sHeader.GetNiNo() > m_maxHelloNeighbors);
+  if (m_incrementalHello)
+    {
+      sHeader.SetVersion(++m_helloVersion);
+      if (m_helloSnapshotWanted)
+	sHeader.SetFlags(sHeader.GetFlags() | SicaHelloHeader::SNAPSHOT_REQUEST);
+      m_helloSnapshotWanted=false;
+      if (!split && m_hellosSinceSnapshot > 0 && m_hellosSinceSnapshot < m_helloSnapshotPeriod && !m_helloSnapshotRequested)
+	{
+	  // only the changes since the previous hello
+	  SicaHelloDeltaHeader delta=SicaHelloDeltaHeader::Diff(m_lastHello,sHeader);
+	  m_lastHello=sHeader;
+	  m_hellosSinceSnapshot++;
+	  p= Create<Packet>();
+	  p->AddHeader(delta);
+	  DistributeHello(p,SicaQueueEntry::HelloDelta_Type);
+	  return;
+	}
+      // the neighbors do not keep a part as the base of the incremental hellos
+      m_hellosSinceSnapshot=split ? 0 : 1;
+      m_helloSnapshotRequested=false;
+    }
+  m_lastHello=sHeader;
+  if (split)
+    SelectHelloPart(sHeader);
+  else
+    m_helloPart=0;
+  p= Create<Packet>(m_helloPaddingSize);
   p->AddHeader(sHeader);
   DistributeHello(p);
 }
 
 
+//////////////////////SelectHelloPart
+void 
+Sica::SelectHelloPart(SicaHelloHeader &sHeader)
+{
+  uint32_t niNo=sHeader.GetNiNo();
+  uint32_t parts=std::min((niNo+m_maxHelloNeighbors-1)/m_maxHelloNeighbors,255u);
+  uint32_t part=m_helloPart%parts;
+  // the parts have the same size, at most m_maxHelloNeighbors
+  uint32_t first=part*niNo/parts;
+  uint32_t last=(part+1)*niNo/parts;
+  sHeader.KeepNiRange(first,last-first);
+  sHeader.SetPart(part,parts);
+  m_helloPart=part+1;
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Hello carries part "<< part << " of "<< parts << " with "<< last-first << " of "<< niNo << " neighbors");
+}
+
+//////////////////////TriggerHello
+void 
+Sica::TriggerHello()
+{
+  // in common control channel mode the change goes out at the next rendezvous
+  if (!m_adaptiveHello || m_hellosSent == 0 || m_controlChannel > 0)
+    return;
+  Time since=Simulator::Now()-m_lastHelloTime;
+  if (since >= m_minHelloGap)
+    {
+      CreateHello();
+      return;
+    }
+  // rate limited, the changes go out together at the end of the gap
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Triggered hello is delayed by "<< (m_minHelloGap-since).GetMilliSeconds() << "ms");
+  ReScheduleTimer(&m_helloTimer,m_minHelloGap-since);
+}
+
+//////////////////////AdaptHelloInterval
+void 
+Sica::AdaptHelloInterval(SicaHelloHeader &sHeader)
+{
+  if (m_hellosSent > 0)
+    {
+      // the periodic hellos avoided since the previous hello
+      uint32_t periods=static_cast<uint32_t>((Simulator::Now()-m_lastHelloTime).GetSeconds()/HelloInterval.GetSeconds());
+      if (periods > 1)
+	NotifyHelloSuppressed(periods-1);
+    }
+  SicaHelloDeltaHeader delta=SicaHelloDeltaHeader::Diff(m_lastHello,sHeader);
+  // the backlog and the interval itself are not a change of the state
+  uint8_t stateFields=~(SicaHelloDeltaHeader::LOAD_FIELD|SicaHelloDeltaHeader::INTERVAL_FIELD);
+  bool changed=(m_hellosSent == 0 || delta.GetChangeNo() > 0 || (delta.GetFields() & stateFields));
+  Time interval=HelloInterval;
+  if (!changed)
+    interval=Seconds(std::min(m_helloTimer.GetDelay().GetSeconds()*m_helloBackoffFactor,m_maxHelloInterval.GetSeconds()));
+  interval=std::max(interval,HelloInterval);
+  m_helloTimer.SetDelay(interval);
+  // the neighbors keep our information for two intervals
+  sHeader.SetHelloInterval(interval);
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Next hello in "<< interval.GetSeconds() << "s, state changed " << changed);
+}
+
+//////////////////////NotifyHelloSuppressed
+void 
+Sica::NotifyHelloSuppressed(uint32_t count)
+{
+  m_hellosSuppressed+=count;
+  m_sicaHelloSuppressed(m_id,m_hellosSent,m_hellosSuppressed);
+}
+
 //////////////////////CreateHelloHeader
 SicaHelloHeader
 Sica::CreateHelloHeader()
@@ -785,18 +1710,24 @@ Sica::CreateHelloHeader()
   uint32_t niCh;
   uint32_t niId;
   Address rAddr= m_rInterface->GetAddress();
-  uint32_t bx= m_channel.GetChannelExtBandwidth(m_rChannel);
+  uint32_t bx= SicaBxEstimator::ToFixed(m_channel.GetChannelExtBandwidth(m_rChannel));
   Time switchTime= m_switchTimer.GetDelayLeft();
   Time  senseTime= m_channelSenseTimer.GetDelayLeft();
-  SicaHelloHeader sHeader(++m_sqNo,m_id,Simulator::Now(),m_radio,m_rChannel,bx,m_rNewChannel,rAddr,switchTime,senseTime);
+  SicaHelloHeader sHeader(++m_helloSqNo,m_id,Simulator::Now(),m_radio,m_rChannel,static_cast<uint16_t>(std::min(bx,65535u)),m_rNewChannel,rAddr,switchTime,senseTime);
+  sHeader.SetExtBwConfidence(m_channel.GetChannelExtBandwidthConfidence(m_rChannel));
+  sHeader.SetLoad(static_cast<uint16_t>(std::min(GetDataBacklog(),65535u)));
+  if (m_compactHello)
+    sHeader.SetFormat(SicaHelloHeader::COMPACT_FORMAT);
   
-  m_nb.RmvExpiredNi(NeighborExpireTime);
+  RmvExpiredNeighbors();
   for (uint32_t i = 1; i <= m_nb.GetNiNo(); i++)
     {
       if (m_nb.IsDirectNeighborByIndex(i)){
   	niId = m_nb.GetNeighborIdByIndex(i);
   	niCh = static_cast<uint32_t>(m_nb.GetNiChannelByIndex(i));
   	sHeader.AddNiRChannel(niId,niCh);
+	if (m_linkQualityHello && m_nb.GetNiReverseRatio(niId) >= 0)
+	  sHeader.SetNiQuality(niId,m_nb.GetNiReverseRatio(niId));
       }
     }
   NS_LOG_DEBUG( "Sica node " << m_id <<" :"<< "One Hello is created with source Mac addr   " << rAddr<< "  and sequence number "<<sHeader.GetSeqNo());
@@ -806,15 +1737,22 @@ Sica::CreateHelloHeader()
 
 //////////////////////DistributeHello
 void 
-Sica::DistributeHello(Ptr<Packet> p)
+Sica::DistributeHello(Ptr<Packet> p, SicaQueueEntry::PacketType ptype)
 {
   uint32_t niChannel[Max_CH]; // number of direct neighbors on available  channels
    for (uint32_t j=Min_CH;j<=Max_CH;j++)
      niChannel[j]=0;
  // Create queue entry with packet and Hello_type
-  SicaQueueEntry::PacketType ptype=SicaQueueEntry::Hello_Type;
   SicaQueueEntry *ent = new SicaQueueEntry(p,ptype);
   ent->SetExpireTime(Sica::HelloExpireTime);
+  if (m_controlChannel > 0)
+    {
+      // a hello which misses its window is outdated at the next one
+      ent->SetExpireTime(m_rendezvousWindow);
+      m_queue.Enqueue(m_controlChannel,ent);
+      delete ent;
+      return;
+    }
   // Push packet into queue where there is a neighbor
   NS_LOG_DEBUG( "Sica node " << m_id <<" :"<< "Hello will be send over channel   ");
   if (m_nb.GetNiNo())
@@ -845,12 +1783,12 @@ Sica::DistributeHello(Ptr<Packet> p)
 
 //////////////////////CreateData
 void 
-Sica::CreateData(uint32_t dstId, uint32_t pSize)
+Sica::CreateData(uint32_t dstId, uint32_t pSize, uint8_t trafficClass)
 {
   Ptr<Packet> p= Create<Packet>(pSize);
   DelayJitterEstimation destim;
   /// Find next hop to the destination
-  int nextHopId= AddDataHeaders(p,m_id,dstId,Simulator::Now());
+  int nextHopId= AddDataHeaders(p,m_id,dstId,Simulator::Now(),trafficClass);
   if (nextHopId != -1){
     destim.PrepareTx(p);
     NotifyTxSent (p->Copy());
@@ -864,10 +1802,12 @@ Sica::CreateData(uint32_t dstId, uint32_t pSize)
 
 //////////////////////AddDataHeaders
 int 
-Sica::AddDataHeaders(Ptr<Packet> p,uint32_t srcId, uint32_t dstId, Time originTime)
+Sica::AddDataHeaders(Ptr<Packet> p,uint32_t srcId, uint32_t dstId, Time originTime, uint8_t trafficClass)
  {
-   uint32_t nextHopId=GetObject<Node> ()->GetObject<RTable> ()->FindNextHop(m_id,dstId);
+  Ptr<RTable> rTable=GetObject<Node> ()->GetObject<RTable> ();
+  uint32_t nextHopId=m_etxRouting ? rTable->FindNextHop(m_id,dstId,MakeCallback(&Sica::GetLinkCost,this)) : rTable->FindNextHop(m_id,dstId);
   SicaHeader sHeader(++m_sqNo,srcId,dstId,nextHopId,originTime);
+  sHeader.SetTrafficClass(trafficClass);
   p->AddHeader(sHeader);
   if (m_nb.GetNiRAddress(nextHopId).IsInvalid())
     {
@@ -878,13 +1818,194 @@ Sica::AddDataHeaders(Ptr<Packet> p,uint32_t srcId, uint32_t dstId, Time originTi
  }
 
 
+//////////////////////GetLinkCost
+double 
+Sica::GetLinkCost(uint32_t niId)
+{
+  if (!m_nb.IsDirectNeighbor(niId) || m_nb.GetNiRAddress(niId).IsInvalid())
+    return (-1);
+  return (m_nb.GetNiEtx(niId));
+}
+
+//////////////////////NotifyMacTxOk
+void 
+Sica::NotifyMacTxOk(std::string context, const WifiMacHeader &hdr)
+{
+  uint32_t ifIndex=static_cast<uint32_t>(std::atoi(context.c_str()));
+  std::map<uint32_t, uint64_t>::iterator tx=m_deviceTxUid.find(ifIndex);
+  if (tx != m_deviceTxUid.end())
+    {
+      // the packet kept for the frame is not needed anymore
+      TakeInFlight(ifIndex,tx->second);
+      m_deviceTxUid.erase(tx);
+    }
+  NotifyDeviceTxEnd(ifIndex);
+  if (!hdr.IsData() || hdr.GetAddr1().IsGroup())
+    return;
+  RecordDeviceTxResult(ifIndex,true);
+  int32_t niId=m_nb.FindDeviceAddr(hdr.GetAddr1());
+  if (niId >= 0)
+    m_nb.RecordNiTx(niId,true);
+}
+
+//////////////////////NotifyMacTxErr
+void 
+Sica::NotifyMacTxErr(std::string context, const WifiMacHeader &hdr)
+{
+  uint32_t ifIndex=static_cast<uint32_t>(std::atoi(context.c_str()));
+  std::map<uint32_t, uint64_t>::iterator tx=m_deviceTxUid.find(ifIndex);
+  Ptr<Packet> p;
+  if (tx != m_deviceTxUid.end())
+    {
+      p=TakeInFlight(ifIndex,tx->second);
+      m_deviceTxUid.erase(tx);
+    }
+  NotifyDeviceTxEnd(ifIndex);
+  if (!hdr.IsData() || hdr.GetAddr1().IsGroup())
+    return;
+  RecordDeviceTxResult(ifIndex,false);
+  if (p)
+    RetransmitData(p);
+}
+
+//////////////////////RecordDeviceTxResult
+void 
+Sica::RecordDeviceTxResult(uint32_t ifIndex, bool ok)
+{
+  Ptr<NetDevice> device=(ifIndex == m_rInterface->GetIfIndex()) ? m_rInterface : m_tInterface;
+  // the frame ends on the channel the device is tuned to
+  m_channel.RecordTxResult(device->GetObject<WifiNetDevice>()->GetPhy()->GetChannelNumber(),ok);
+}
+
+//////////////////////NotifyPhyTxBegin
+void 
+Sica::NotifyPhyTxBegin(std::string context, Ptr<const Packet> p)
+{
+  WifiMacHeader hdr;
+  p->PeekHeader(hdr);
+  // the control frames and the acknowledgments do not get feedback from the MAC
+  if (hdr.IsData())
+    m_deviceTxUid[static_cast<uint32_t>(std::atoi(context.c_str()))]=p->GetUid();
+}
+
+//////////////////////NotifyMacTxDrop
+void 
+Sica::NotifyMacTxDrop(std::string context, Ptr<const Packet> p)
+{
+  uint32_t ifIndex=static_cast<uint32_t>(std::atoi(context.c_str()));
+  std::map<uint32_t, uint64_t>::iterator tx=m_deviceTxUid.find(ifIndex);
+  if (tx != m_deviceTxUid.end() && tx->second == p->GetUid())
+    m_deviceTxUid.erase(tx);
+  Ptr<Packet> sent=TakeInFlight(ifIndex,p->GetUid());
+  if (sent)
+    RetransmitData(sent);
+}
+
+//////////////////////TakeInFlight
+Ptr<Packet> 
+Sica::TakeInFlight(uint32_t ifIndex, uint64_t uid)
+{
+  InFlightPackets::iterator i=m_inFlight.find(std::make_pair(ifIndex,uid));
+  if (i == m_inFlight.end())
+    return 0;
+  Ptr<Packet> p=i->second.second;
+  m_inFlight.erase(i);
+  return p;
+}
+
+//////////////////////ExpireInFlight
+void 
+Sica::ExpireInFlight()
+{
+  // the MAC drops without feedback the frames which wait too long in its queue
+  std::vector<Ptr<Packet> > expired;
+  Time oldest=Simulator::Now();
+  InFlightPackets::iterator i=m_inFlight.begin();
+  while (i != m_inFlight.end())
+    {
+      if (Simulator::Now()-i->second.first >= m_txFeedbackTimeout)
+        {
+          NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "No feedback from the device for the data packet " << i->first.second);
+          expired.push_back(i->second.second);
+          m_inFlight.erase(i++);
+        }
+      else
+        {
+          oldest=std::min(oldest,i->second.first);
+          ++i;
+        }
+    }
+  if (!m_inFlight.empty())
+    m_inFlightTimer.Schedule(oldest+m_txFeedbackTimeout-Simulator::Now());
+  for (uint32_t k = 0; k < expired.size(); ++k)
+    RetransmitData(expired[k]);
+}
+
+//////////////////////RetransmitData
+void 
+Sica::RetransmitData(Ptr<Packet> p)
+{
+  SicaHeader sHeader;
+  p->RemoveHeader(sHeader);
+  uint32_t niId=sHeader.GetNextHop();
+  SicaRetryTag tag;
+  p->RemovePacketTag(tag);
+  int nextHopId=-1;
+  if (tag.GetRetries() < m_maxRetries)
+    {
+      // the next hop is chosen again and the packet goes to the queue of its current channel
+      tag.SetRetries(tag.GetRetries()+1);
+      p->AddPacketTag(tag);
+      nextHopId=AddDataHeaders(p,sHeader.GetOrigin(),sHeader.GetDest(),sHeader.GetOriginTime(),sHeader.GetTrafficClass());
+    }
+  if (nextHopId == -1)
+    {
+      NS_LOG_INFO("Sica node " << m_id <<" :"<< "Data packet to " << sHeader.GetDest() << " is dropped after " << static_cast<uint32_t>(tag.GetRetries()) << " retransmissions to " << niId);
+      m_txDrops[niId]++;
+      m_sicaTxRetry(m_id,niId,tag.GetRetries(),true);
+      return;
+    }
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Data packet to " << sHeader.GetDest() << " is retransmitted through " << nextHopId << " retry " << static_cast<uint32_t>(tag.GetRetries()));
+  m_txRetries[niId]++;
+  m_sicaTxRetry(m_id,niId,tag.GetRetries(),false);
+  DistributeDataPacket(p,static_cast<uint32_t>(m_nb.GetNiChannel(nextHopId)));
+}
+
+//////////////////////GetTxRetries
+uint32_t 
+Sica::GetTxRetries(uint32_t niId)
+{
+  std::map<uint32_t, uint32_t>::iterator i=m_txRetries.find(niId);
+  return (i == m_txRetries.end() ? 0 : i->second);
+}
+
+//////////////////////GetTxDrops
+uint32_t 
+Sica::GetTxDrops(uint32_t niId)
+{
+  std::map<uint32_t, uint32_t>::iterator i=m_txDrops.find(niId);
+  return (i == m_txDrops.end() ? 0 : i->second);
+}
+
+//////////////////////NotifyMacTxFailed
+void 
+Sica::NotifyMacTxFailed(Mac48Address addr)
+{
+  if (addr.IsGroup())
+    return;
+  int32_t niId=m_nb.FindDeviceAddr(addr);
+  if (niId >= 0)
+    m_nb.RecordNiTx(niId,false);
+}
+
 //////////////////////DistributeDataPacket
  void 
  Sica::DistributeDataPacket(Ptr<Packet> p,uint32_t nextHopChannel)
  {
    SicaQueueEntry::PacketType ptype=SicaQueueEntry::Data_Type;
    SicaQueueEntry *qEntry = new SicaQueueEntry(p,ptype);
-   qEntry->SetExpireTime(Sica::DataExpireTime);
+   uint32_t tc=m_queue.GetEntryClass(*qEntry);
+   qEntry->SetExpireTime(tc < m_classExpireTime.size() ? m_classExpireTime[tc] : Sica::DataExpireTime);
    m_queue.Enqueue(nextHopChannel,*(&qEntry));
    NS_LOG_INFO( "Sica node " << m_id <<" :"<< "Data sent to queue with size "<< p->GetSize()<< " over channel "<< nextHopChannel );
   return;
@@ -896,17 +2017,13 @@ Sica::SendPacket(Ptr<Packet> packet,Ptr <NetDevice> device , uint32_t protocolNu
 {
  
   //// broadcast hello with a random delay to avoid collision in a tight synchronized network
-  if (protocolNumber==SICA_HELLO_PORT)
+  if (protocolNumber != SICA_DATA_PORT)
     {
       // UniformVariable uniRnd(0,m_bcastSendDelay.Time::ToDouble((Time::Unit)3));
-      // Ptr<UniformRandomVariable> uniRnd = CreateObject<UniformRandomVariable> (0,m_bcastSendDelay.Time::ToDouble((Time::Unit)3));
-      Ptr<UniformRandomVariable> uniRnd = CreateObject<UniformRandomVariable> ();
-      uniRnd->SetAttribute ("Min", DoubleValue (0));
-      uniRnd->SetAttribute ("Max", DoubleValue (m_bcastSendDelay.Time::ToDouble((Time::Unit)3)));
       // uint64_t delaySend=  static_cast<uint64_t>(uniRnd.GetValue());
-      uint64_t delaySend=  static_cast<uint64_t>(uniRnd->GetValue());
+      uint64_t delaySend=  static_cast<uint64_t>(m_uniformRandom->GetValue(0,m_bcastSendDelay.Time::ToDouble((Time::Unit)3)));
       NS_LOG_INFO( "Sica node " << m_id <<" :"<< " hello will be  sent after  "<< delaySend << " ns " );
-      Simulator::Schedule(NanoSeconds(delaySend), &Sica::DeviceSend ,this , device , packet,device->GetBroadcast(),SICA_HELLO_PORT);
+      Simulator::Schedule(NanoSeconds(delaySend), &Sica::DeviceSend ,this , device , packet,device->GetBroadcast(),protocolNumber);
       return;
     }
   else {
@@ -916,12 +2033,52 @@ Sica::SendPacket(Ptr<Packet> packet,Ptr <NetDevice> device , uint32_t protocolNu
   // extract destination address
     uint32_t nextHopId= sHeader.GetNextHop();
     Address nextHopAddr=m_nb.GetNiRAddress(nextHopId);
+    Ptr<WifiPhy> wifiphy=device->GetObject<WifiNetDevice>()->GetPhy();
+    if (m_stateTrailer)
+      {
+	// piggyback our current state, the next hop learns it without waiting for a hello
+	packet->RemoveHeader(sHeader);
+	uint32_t bx= SicaBxEstimator::ToFixed(m_channel.GetChannelExtBandwidth(m_rChannel));
+	sHeader.SetStateTrailer(m_rChannel,m_rNewChannel,m_switchTimer.GetDelayLeft(),static_cast<uint16_t>(std::min(bx,65535u)),
+			       m_channel.GetChannelExtBandwidthConfidence(m_rChannel));
+	packet->AddHeader(sHeader);
+      }
+    // the MAC of a QoS device queues the frame by the user priority of the tag
+    if (m_classAccessCategories)
+      {
+	QosTag qosTag(SicaQueue::GetClassUserPriority(sHeader.GetTrafficClass(),m_queue.GetTrafficClasses()));
+	packet->ReplacePacketTag(qosTag);
+      }
+    // the neighbor leaves the channel before the end of the frame
+    if (m_nb.GetNiNewChannel(nextHopId) != m_nb.GetNiChannel(nextHopId)
+	&& m_nb.GetNiSwitchTime(nextHopId) <= EstimateTxDuration(packet->GetSize(),wifiphy))
+      {
+	m_switchStale++;
+	m_sicaSwitchImpact(m_id,nextHopId,0,1);
+      }
     DeviceSend(device,packet,nextHopAddr,SICA_DATA_PORT);
-    uint32_t m_ch=device->GetObject<WifiNetDevice>()->GetPhy()->GetChannelNumber();
+    uint32_t m_ch=wifiphy->GetChannelNumber();
     m_sicaTxDeviceSent(packet->Copy(),m_id,nextHopId,m_ch,Simulator::Now());
     }
 }
 
+//////////////////////GetControlPort
+uint32_t 
+Sica::GetControlPort(SicaQueueEntry::PacketType ptype)
+{
+  switch (ptype)
+    {
+    case SicaQueueEntry::Switch_Type:
+      return SICA_SWITCH_PORT;
+    case SicaQueueEntry::HelloDelta_Type:
+      return SICA_HELLO_DELTA_PORT;
+    case SicaQueueEntry::Data_Type:
+      return SICA_DATA_PORT;
+    default:
+      return SICA_HELLO_PORT;
+    }
+}
+
 //////////////////////EstimateTxDuration
 Time 
 Sica::EstimateTxDuration(uint32_t pSize,Ptr<WifiPhy> wifiphy)
@@ -940,12 +2097,25 @@ Sica::EstimateTxDuration(uint32_t pSize,Ptr<WifiPhy> wifiphy)
 void 
 Sica::DeviceSend(Ptr<NetDevice> device, Ptr<Packet> packet,Address dstAddr,uint32_t protocolNumber)
 {
- device->Send(packet,dstAddr,protocolNumber);
+ Ptr<Packet> sentCopy;
+ // the device adds its own headers to the packet
+ if (protocolNumber== SICA_DATA_PORT && m_maxRetries > 0)
+   sentCopy=packet->Copy();
+ bool sent=device->Send(packet,dstAddr,protocolNumber);
+ if (sentCopy && !sent)
+   RetransmitData(sentCopy);
+ else if (sentCopy)
+   {
+     // kept until the MAC reports the end of the transmission, the copy keeps the UID of the frame
+     m_inFlight[std::make_pair(device->GetIfIndex(),sentCopy->GetUid())]=std::make_pair(Simulator::Now(),sentCopy);
+     if (!m_inFlightTimer.IsRunning())
+       m_inFlightTimer.Schedule(m_txFeedbackTimeout);
+   }
  // if (protocolNumber== SICA_DATA_PORT )
  //   {
  //   m_sicaTxDeviceSent(packet->Copy(),m_id,Simulator::Now());
  //   }
- if (protocolNumber== SICA_HELLO_PORT ) 
+ if (protocolNumber== SICA_HELLO_PORT || protocolNumber== SICA_HELLO_DELTA_PORT) 
    {
      NotifyHelloSent (packet->Copy());
    }
@@ -964,7 +2134,7 @@ Sica::HandleNeighborSwitchChannel()
   uint32_t niCurrCh;// neighbor current channel, before switch
   Time niSwTime;
   Time minSwTime=MilliSeconds(0);
-  m_nb.RmvExpiredNi(NeighborExpireTime);
+  RmvExpiredNeighbors();
   for (uint32_t i=1; i<=m_nb.GetNiNo(); i++){
     niId=m_nb.GetNeighborIdByIndex(i);
     niSwTime=m_nb.GetNiSwitchTime(niId);
@@ -976,7 +2146,7 @@ Sica::HandleNeighborSwitchChannel()
 	{
 	  NS_LOG_DEBUG( "Sica node " << m_id <<" :"<<"One neighbor has switched\n --"<<niId<< "\n --Previous channel " <<niCurrCh << "\n --Current channel "<< niNewCh);
 	  /// ShuffleData packets 
-	  m_queue.ShuffleData(niCurrCh,niNewCh,niId);
+	  ShuffleNeighborData(niId,niCurrCh,niNewCh);
 	  m_channel.IncChannelNeighbors(niNewCh);
 	  m_channel.DecChannelNeighbors(niCurrCh);
 	  /// Neighbor information updates
@@ -1007,12 +2177,14 @@ Sica::ScheduleSwitchRInterface()
     NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<< "Phy is busy to switch it would be idel after " <<delayToIdle.GetMicroSeconds() );
   }
   // UniformVariable uniRnd;
-  Ptr<UniformRandomVariable> uniRnd = CreateObject<UniformRandomVariable> ();
   // uint32_t rndDelay=  uniRnd.GetInteger(m_minSwitchDelay,m_maxSwitchDelay);
-  uint32_t rndDelay=  uniRnd->GetInteger(m_minSwitchDelay,m_maxSwitchDelay);
-  Time switchDelay=MilliSeconds(rndDelay)+delayToIdle;
+  // drawn in microseconds over 64 bits, the delays can be longer than the 4295s of a 32 bit count
+  int64_t rndDelay=static_cast<int64_t>(m_uniformRandom->GetValue(m_minSwitchDelay.GetMicroSeconds(),m_maxSwitchDelay.GetMicroSeconds()+1));
+  Time switchDelay=MicroSeconds(std::min(rndDelay,m_maxSwitchDelay.GetMicroSeconds()))+delayToIdle;
   NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<< "R interface will switch to channel "<< m_rNewChannel << " after " <<switchDelay.GetMilliSeconds() );
   ReScheduleTimer(&m_switchTimer,switchDelay); 
+  AnnounceSwitch();
+  TriggerHello();
 }
 
 
@@ -1023,12 +2195,236 @@ Sica::SwitchRInterface()
   m_switchTimer.Cancel();
   Ptr <WifiNetDevice>rInterface= m_rInterface->GetObject<WifiNetDevice>();
   Ptr<WifiPhy> wifiphy = rInterface->GetPhy();
-  wifiphy->SetChannelNumber(m_rNewChannel);
+  // during a rendezvous the R interface goes to the new channel at the end of the window
+  if (!m_inRendezvous)
+    wifiphy->SetChannelNumber(m_rNewChannel);
   //wifiphy->SetChannel(m_channelObjects[m_rNewChannel]);
   NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<< "Switch R interface  from " << m_rChannel <<" to channel  " << m_rNewChannel);
   m_rChannel=m_rNewChannel;
+  m_lastSwitchTime=Simulator::Now();
+  m_switchCount++;
   return;
 }
+//////////////////////ForceRChannel
+void 
+Sica::ForceRChannel(uint32_t ch, bool warmStart)
+{
+  NS_ASSERT_MSG(ch >= Min_CH && ch <= Max_CH,"Forced channel is out of range");
+  if (warmStart)
+    {
+      // one round of the game where every other channel has the maximum loss
+      std::vector<double> loss(Max_CH-Min_CH+1,1);
+      loss[ch-Min_CH]=0;
+      m_channel.UpdateChannelWeights(std::log(m_beta),loss,Min_CH);
+      UpdateChannelSampler();
+    }
+  NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<< "R interface is forced to channel " << ch);
+  m_rNewChannel=ch;
+  if (m_rNewChannel == m_rChannel)
+    {
+      m_switchTimer.Cancel();
+      return;
+    }
+  ScheduleSwitchRInterface();
+  // announce the switch before it happens, the adaptive scheduler is triggered by the switch
+  if (!m_adaptiveHello)
+    CreateHello();
+}
+
+//////////////////////CoordinateSwitch
+Time 
+Sica::CoordinateSwitch()
+{
+  if (!m_switchCoordination || m_rNewChannel == m_rChannel)
+    return Seconds(0);
+  Time niSwitch=Seconds(0);
+  int32_t winner=-1;
+  for (uint32_t i=1; i<=m_nb.GetNiNo(); i++)
+    {
+      uint32_t niId=m_nb.GetNeighborIdByIndex(i);
+      if (niId >= m_id || !m_nb.IsDirectNeighbor(niId))
+	continue; // the neighbor with the lower Id keeps its switch
+      int32_t niCh=m_nb.GetNiChannel(niId);
+      int32_t niNewCh=m_nb.GetNiNewChannel(niId);
+      Time left=m_nb.GetNiSwitchTime(niId);
+      if (niNewCh == niCh || !left.IsStrictlyPositive())
+	continue; // no pending switch
+      // both switches change the occupancy of a channel we leave or join
+      if (static_cast<uint32_t>(niNewCh) == m_rNewChannel || static_cast<uint32_t>(niNewCh) == m_rChannel
+	  || static_cast<uint32_t>(niCh) == m_rNewChannel)
+	{
+	  winner=niId;
+	  niSwitch=std::max(niSwitch,left);
+	}
+    }
+  if (winner < 0)
+    return Seconds(0);
+  NS_LOG_DEBUG ( "Sica node " << m_id <<" :"<< "Switch to channel " << m_rNewChannel << " is withdrawn, neighbor "<< winner << " switches in " << niSwitch.GetMilliSeconds() << "ms");
+  // the switch is announced once it is scheduled
+  bool announced=m_switchTimer.IsRunning();
+  m_rNewChannel=m_rChannel;
+  m_switchTimer.Cancel();
+  m_switchDeferrals++;
+  if (announced)
+    {
+      // the neighbors which already know the switch must forget it
+      AnnounceSwitch();
+      if (m_adaptiveHello)
+	TriggerHello();
+      else
+	CreateHello();
+    }
+  return (niSwitch+Seconds(m_uniformRandom->GetValue(0,m_switchBackoff.GetSeconds())));
+}
+
+//////////////////////AnnounceSwitch
+void 
+Sica::AnnounceSwitch()
+{
+  if (!m_switchAnnouncement)
+    return;
+  m_switchAnnounceTimer.Cancel();
+  m_switchUnacked.clear();
+  for (uint32_t i=1; i<=m_nb.GetNiNo(); i++)
+    if (m_nb.IsDirectNeighborByIndex(i))
+      m_switchUnacked.insert(m_nb.GetNeighborIdByIndex(i));
+  m_switchSqNo++;
+  m_switchAnnounceTries=0;
+  SendSwitchAnnouncement();
+}
+
+//////////////////////SendSwitchAnnouncement
+void 
+Sica::SendSwitchAnnouncement()
+{
+  if (m_switchUnacked.empty() || m_switchAnnounceTries > m_switchAnnounceRetries)
+    {
+      if (!m_switchUnacked.empty())
+	NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Switch announcement " << m_switchSqNo << " is not acknowledged by " << m_switchUnacked.size() << " neighbors");
+      m_switchUnacked.clear();
+      return;
+    }
+  // in common control channel mode the announcement is sent at the next rendezvous
+  if (m_controlChannel > 0 && !m_inRendezvous)
+    return;
+  m_switchAnnounceTries++;
+  SicaSwitchHeader sHeader(m_switchSqNo,m_id,m_rChannel,m_rNewChannel,m_switchTimer.GetDelayLeft());
+  Ptr<Packet> p= Create<Packet>();
+  p->AddHeader(sHeader);
+  SicaQueueEntry ent(p,SicaQueueEntry::Switch_Type);
+  // an announcement which waits longer than the retry interval carries a wrong time to switch
+  ent.SetExpireTime(m_switchAnnounceInterval);
+  std::set<uint32_t> channels;
+  for (std::set<uint32_t>::iterator i=m_switchUnacked.begin(); i!=m_switchUnacked.end(); ++i)
+    {
+      int32_t niCh=m_nb.GetNiChannel(*i);
+      if (niCh >= static_cast<int32_t>(Min_CH) && niCh <= static_cast<int32_t>(Max_CH))
+	channels.insert(niCh);
+    }
+  if (m_controlChannel > 0)
+    {
+      channels.clear();
+      channels.insert(m_controlChannel);
+    }
+  for (std::set<uint32_t>::iterator j=channels.begin(); j!=channels.end(); ++j)
+    m_queue.Enqueue(*j,&ent);
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Switch to channel " << m_rNewChannel << " announced over " << channels.size() << " channels, attempt " << m_switchAnnounceTries);
+  m_sicaSwitchAnnounced(m_id,m_rNewChannel,m_switchAnnounceTries,m_switchUnacked.size());
+  // the neighbors acknowledge only once we are on the new channel, the repetitions start after the switch
+  Time retry=m_switchAnnounceInterval;
+  if (m_switchTimer.IsRunning())
+    retry+=m_switchTimer.GetDelayLeft();
+  m_switchAnnounceTimer.Schedule(retry);
+}
+
+//////////////////////AckSwitchAnnouncement
+void 
+Sica::AckSwitchAnnouncement(uint32_t niId)
+{
+  // before the switch the neighbor can still reach us over the old channel
+  if (m_switchTimer.IsRunning() || m_switchUnacked.erase(niId) == 0)
+    return;
+  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Neighbor " << niId << " acknowledged the switch announcement " << m_switchSqNo);
+  if (m_switchUnacked.empty())
+    m_switchAnnounceTimer.Cancel();
+}
+
+//////////////////////InSwitchHoldDown
+bool 
+Sica::InSwitchHoldDown()
+{
+  return (m_switchHoldDown.IsStrictlyPositive() && m_switchCount > 0 && Simulator::Now()-m_lastSwitchTime < m_switchHoldDown);
+}
+
+//////////////////////ShuffleNeighborData
+void 
+Sica::ShuffleNeighborData(uint32_t niId, uint32_t from, uint32_t to)
+{
+  uint32_t moved=m_queue.ShuffleData(from,to,niId);
+  if (moved > 0)
+    {
+      m_switchDelayed+=moved;
+      m_sicaSwitchImpact(m_id,niId,moved,0);
+    }
+}
+
+//////////////////////GetNeighborHoldStart
+bool 
+Sica::GetNeighborHoldStart(uint32_t niId, uint32_t ch, Time &start)
+{
+  int32_t niCurrCh=m_nb.GetNiChannel(niId);
+  int32_t niNewCh=m_nb.GetNiNewChannel(niId);
+  if (niCurrCh < 0 || niNewCh == niCurrCh || niNewCh < static_cast<int32_t>(Min_CH) || niNewCh > static_cast<int32_t>(Max_CH))
+    return false; // no switch pending
+  Time niSwTime=m_nb.GetNiSwitchTime(niId);
+  // the neighbor leaves the channel, the frames which end after its switch are held
+  if (niCurrCh == static_cast<int32_t>(ch))
+    {
+      start=niSwTime;
+      return true;
+    }
+  // the neighbor is not yet listening to the channel
+  if (niNewCh == static_cast<int32_t>(ch) && (niSwTime+SwitchingDelay).IsStrictlyPositive())
+    {
+      start=Seconds(0);
+      return true;
+    }
+  return false;
+}
+
+//////////////////////GetHoldSchedule
+Sica::HoldSchedule 
+Sica::GetHoldSchedule(uint32_t ch)
+{
+  HoldSchedule schedule;
+  Time start;
+  for (uint32_t i=1; i<=m_nb.GetNiNo(); i++)
+    {
+      uint32_t niId=m_nb.GetNeighborIdByIndex(i);
+      if (GetNeighborHoldStart(niId,ch,start))
+	schedule.insert(std::make_pair(start,niId));
+    }
+  return schedule;
+}
+
+//////////////////////HoldNeighbors
+void 
+Sica::HoldNeighbors(HoldSchedule &schedule, uint32_t ch, Time horizon, std::set<uint32_t> &held)
+{
+  while (!schedule.empty() && schedule.begin()->first <= horizon)
+    {
+      uint32_t niId=schedule.begin()->second;
+      schedule.erase(schedule.begin());
+      held.insert(niId);
+      if (m_nb.GetNiChannel(niId) == static_cast<int32_t>(ch))
+	{
+	  // pre-stage the packets so that they are sent right after the switch
+	  ShuffleNeighborData(niId,ch,static_cast<uint32_t>(m_nb.GetNiNewChannel(niId)));
+	  NS_LOG_DEBUG("Sica node " << m_id <<" :"<< "Transmissions to neighbor " << niId << " are held on channel " << ch);
+	}
+    }
+}
+
 //////////////////////SwitchTInterface
 bool 
 Sica::SwitchTInterface(uint32_t c)
@@ -1051,13 +2447,29 @@ void
 Sica::TInterfaceStartSend(uint32_t ch)
 {
   m_TInterfaceSendTimer.Cancel();
+  m_tBackpressureChannel=0;
   m_TInterfaceSendTimer.SetDelay(TMax);
+  if (m_inRendezvous)
+    {
+      // the T interface stays on the control channel until the end of the window
+      if (SwitchTInterface(m_controlChannel))
+	Simulator::Schedule(SwitchingDelay+m_TInterfaceSendDelay,&Sica::TInterfaceSend,this,m_controlChannel);
+      m_TInterfaceSendTimer.SetArguments(m_controlChannel);
+      m_TInterfaceSendTimer.Schedule();
+      return;
+    }
+  if (IsScanning())
+    {
+      // the T interface is parked on a channel until the end of the scan
+      m_TInterfaceSendTimer.SetArguments(Min_CH);
+      m_TInterfaceSendTimer.Schedule();
+      return;
+    }
   bool datatosend=false;
   SicaQueueEntry::PacketType dataType=SicaQueueEntry::Data_Type;
-  SicaQueueEntry::PacketType helloType=SicaQueueEntry::Hello_Type;
   while (ch <=  Max_CH && datatosend==false)
     {
-      if (m_queue.GetSize(ch,helloType) > 0 || m_queue.GetSize(ch,dataType) > 0)
+      if (GetControlQueueSize(ch) > 0 || m_queue.GetSize(ch,dataType) > 0)
       {
         if (SwitchTInterface(ch))
           {
@@ -1073,7 +2485,10 @@ Sica::TInterfaceStartSend(uint32_t ch)
         ch++;
       }
     }//while
-  if (ch >= Max_CH)
+  // Nothing to send, use the idle T interface to refresh the information of other channels
+  if (!datatosend && StartBackgroundScan())
+    m_TInterfaceSendTimer.SetDelay(SwitchingDelay+m_scanDwellTime);
+  if (ch >= Max_CH || IsScanning())
     m_TInterfaceSendTimer.SetArguments(Min_CH);
   else{
     m_TInterfaceSendTimer.SetArguments(++ch);
@@ -1100,7 +2515,7 @@ Sica::TInterfaceSend(uint32_t ch)
   SicaQueueEntry::PacketType ptype;
   uint32_t protocolNumber;
   uint32_t dataQueueSize=m_queue.GetSize(ch,SicaQueueEntry::Data_Type);
-  uint32_t helloQueueSize=m_queue.GetSize(ch,SicaQueueEntry::Hello_Type);
+  uint32_t helloQueueSize=GetControlQueueSize(ch);
   Ptr <WifiNetDevice>tInterface= m_tInterface->GetObject<WifiNetDevice>();
   Ptr<WifiPhy> wifiphy = tInterface->GetPhy();
   uint32_t sentCount=0;
@@ -1108,8 +2523,20 @@ Sica::TInterfaceSend(uint32_t ch)
     txEstimation=EstimateTxDuration(200,wifiphy);
   else 
     txEstimation=EstimateTxDuration(maxPacketSize,wifiphy);
+  m_tBackpressureChannel=0;
+  // the neighbors which switch are gathered once for the burst
+  HoldSchedule holdSchedule;
+  std::set<uint32_t> held;
+  if (m_switchTransmitHold)
+    holdSchedule=GetHoldSchedule(ch);
   while ((helloQueueSize>0 || dataQueueSize>0 )&& TInterfaceReadyToSend(ch,txEstimation))
     {
+      if (m_macBackpressure && !TInterfaceAcceptsFrame(ch,txEstimation))
+	{
+	  // the rest waits until the device ends the frames it holds (Sica::NotifyDeviceTxEnd)
+	  m_tBackpressureChannel=ch;
+	  break;
+	}
       sentCount++;
 
       if (helloQueueSize>0)
@@ -1124,14 +2551,32 @@ Sica::TInterfaceSend(uint32_t ch)
 	    protocolNumber=SICA_DATA_PORT;
 	    endSendTime+=txEstimation;
 	    }
-	  qEntry= m_queue.Dequeue(ch,ptype);
-	  if ( qEntry)
+	  if (ptype == SicaQueueEntry::Data_Type && m_switchTransmitHold)
 	    {
+	      HoldNeighbors(holdSchedule,ch,endSendTime,held);
+	      qEntry= m_queue.DequeueSkipping(ch,held);
+	      if (!qEntry)
+		{
+		  // only packets to switching neighbors are left
+		  sentCount--;
+		  endSendTime-=txEstimation;
+		  break;
+		}
 	      SendPacket(qEntry->GetPacket()->Copy(),m_tInterface,protocolNumber);
-	      m_queue.EraseFront(ch,ptype);
+	      delete qEntry;
+	    }
+	  else 
+	    {
+	      qEntry= m_queue.Dequeue(ch,ptype);
+	      if ( qEntry)
+		{
+		  protocolNumber=GetControlPort(qEntry->GetPacketType());
+		  SendPacket(qEntry->GetPacket()->Copy(),m_tInterface,protocolNumber);
+		  m_queue.EraseFront(ch,ptype);
+		}
 	    }
 	  /// I need to update it because of some expired packets
-	  helloQueueSize=m_queue.GetSize(ch,SicaQueueEntry::Hello_Type);
+	  helloQueueSize=GetControlQueueSize(ch);
 	  dataQueueSize=m_queue.GetSize(ch,SicaQueueEntry::Data_Type);
 	  if (helloQueueSize>0)
  	    txEstimation=EstimateTxDuration(200,wifiphy);
@@ -1143,6 +2588,13 @@ Sica::TInterfaceSend(uint32_t ch)
   //   Simulator::Schedule(MilliSeconds(1),&Urbanx::TInterfaceSend,this,ch);
   if (sentCount)
   NS_LOG_DEBUG(  "Sica node " << m_id  <<" :"<< sentCount << " packets sent to device for  channel "<< ch);
+  if (m_macBackpressure)
+    {
+      // the T interface stays until the device ends the frames it holds
+      if (m_tBackpressureChannel)
+	return;
+      endSendTime=std::max(endSendTime,GetDeviceBacklogTime(m_tInterface,GetDeviceBacklog(m_tInterface)));
+    }
   ReScheduleTimer(&m_TInterfaceSendTimer,endSendTime);
   return;
 }
@@ -1155,10 +2607,13 @@ Sica::TInterfaceReadyToSend(uint32_t ch,Time txEstimation)
  Time timeToEndDuration=m_TInterfaceSendTimer.GetDelayLeft();
  Ptr <WifiNetDevice>tInterface= m_tInterface->GetObject<WifiNetDevice>();
  Ptr<WifiPhy> wifiphy = tInterface->GetPhy();
+ if (IsScanning())  return false;
  if (m_channel.IsBeingSensed(ch))  return false;
  if ( ChannelIsBusy(ch))  return false;
  if (wifiphy->IsStateSwitching())  return false;
  if (txEstimation > timeToEndDuration) return false;
+ // the data channels are left to the neighbors during a rendezvous, and the transmission must end before it
+ if (m_controlChannel > 0 && ch != m_controlChannel && (m_inRendezvous || txEstimation > m_rendezvousTimer.GetDelayLeft())) return false;
  return true;
 }
 
@@ -1172,20 +2627,29 @@ Sica::RInterfaceCheckChannelQueue()
    Time txEstimation;
    uint32_t maxPacketSize= 1054;
    uint32_t sentCount=0;
+   Time endSendTime=Seconds(0);
    SicaQueueEntry::PacketType ptype;
    SicaQueueEntry* qEntry;
    uint32_t protocolNumber;
    uint32_t dataQueueSize=m_queue.GetSize(m_rChannel,SicaQueueEntry::Data_Type);
-   uint32_t helloQueueSize=m_queue.GetSize(m_rChannel,SicaQueueEntry::Hello_Type);
+   uint32_t helloQueueSize=GetControlQueueSize(m_rChannel);
    Ptr <WifiNetDevice>rInterface= m_rInterface->GetObject<WifiNetDevice>();
    Ptr<WifiPhy> wifiphy = rInterface->GetPhy();
    if (helloQueueSize>0)
      txEstimation=EstimateTxDuration(200,wifiphy);
    else 
      txEstimation=EstimateTxDuration(maxPacketSize,wifiphy);
+   // the neighbors which switch are gathered once for the burst
+   HoldSchedule holdSchedule;
+   std::set<uint32_t> held;
+   if (m_switchTransmitHold)
+     holdSchedule=GetHoldSchedule(m_rChannel);
    // The transmission will start if there is no switching timer nor sense timer is set or we have enough time to any of these event
    while ((helloQueueSize>0 || dataQueueSize>0) && RInterfaceReadyToSend(txEstimation))  
      {
+       // the rest waits for the next poll of the queue
+       if (m_macBackpressure && !RInterfaceAcceptsFrame(txEstimation))
+	 break;
        sentCount++;
        if (helloQueueSize>0)
 	 {
@@ -1197,11 +2661,29 @@ Sica::RInterfaceCheckChannelQueue()
 	   ptype=SicaQueueEntry::Data_Type;
 	   protocolNumber=SICA_DATA_PORT;
 	 }
-       qEntry= m_queue.Dequeue(m_rChannel,ptype);
-       SendPacket(qEntry->GetPacket()->Copy(),m_rInterface,protocolNumber );
-       m_queue.EraseFront(m_rChannel,ptype);
+       endSendTime+=txEstimation;
+       if (ptype == SicaQueueEntry::Data_Type && m_switchTransmitHold)
+	 {
+	   HoldNeighbors(holdSchedule,m_rChannel,endSendTime,held);
+	   qEntry= m_queue.DequeueSkipping(m_rChannel,held);
+	   if (!qEntry)
+	     {
+	       // only packets to switching neighbors are left
+	       sentCount--;
+	       break;
+	     }
+	   SendPacket(qEntry->GetPacket()->Copy(),m_rInterface,protocolNumber );
+	   delete qEntry;
+	 }
+       else 
+	 {
+	   qEntry= m_queue.Dequeue(m_rChannel,ptype);
+	   protocolNumber=GetControlPort(qEntry->GetPacketType());
+	   SendPacket(qEntry->GetPacket()->Copy(),m_rInterface,protocolNumber );
+	   m_queue.EraseFront(m_rChannel,ptype);
+	 }
        dataQueueSize=m_queue.GetSize(m_rChannel,SicaQueueEntry::Data_Type);
-       helloQueueSize=m_queue.GetSize(m_rChannel,SicaQueueEntry::Hello_Type);
+       helloQueueSize=GetControlQueueSize(m_rChannel);
        if (helloQueueSize>0)
 	 txEstimation=EstimateTxDuration(200,wifiphy);
        else 
@@ -1225,6 +2707,9 @@ Sica::RInterfaceReadyToSend(Time txEstimation)
     return false;
   if  (m_channelSenseTimer.IsRunning() && txEstimation > m_channelSenseTimer.GetDelayLeft())
     return false;
+  // the R interface is on the control channel during a rendezvous
+  if (m_controlChannel > 0 && m_rChannel != m_controlChannel && (m_inRendezvous || txEstimation > m_rendezvousTimer.GetDelayLeft()))
+    return false;
   Ptr <WifiNetDevice>rInterface= m_rInterface->GetObject<WifiNetDevice>();
   Ptr<WifiPhy> wifiphy = rInterface->GetPhy();
   if (wifiphy->IsStateSwitching())
@@ -1232,6 +2717,68 @@ Sica::RInterfaceReadyToSend(Time txEstimation)
   return true;
 }
 
+//////////////////////GetDeviceBacklog
+uint32_t 
+Sica::GetDeviceBacklog(Ptr<NetDevice> device)
+{
+  Ptr<WifiMacQueue> macQueue=(device == m_rInterface) ? m_rMacQueue : m_tMacQueue;
+  uint32_t backlog=macQueue ? macQueue->GetSize() : 0;
+  std::vector<Ptr<WifiMacQueue> > &edcaQueues=(device == m_rInterface) ? m_rEdcaQueues : m_tEdcaQueues;
+  for (uint32_t ac = 0; ac < edcaQueues.size(); ++ac)
+    backlog+=edcaQueues[ac]->GetSize();
+  // the frame in transmission has left the queue of the MAC until its feedback
+  if (m_deviceTxUid.find(device->GetIfIndex()) != m_deviceTxUid.end())
+    backlog++;
+  return backlog;
+}
+
+//////////////////////GetDeviceBacklogTime
+Time 
+Sica::GetDeviceBacklogTime(Ptr<NetDevice> device, uint32_t backlog)
+{
+  uint32_t maxPacketSize= 1054;
+  Ptr<WifiPhy> wifiphy=device->GetObject<WifiNetDevice>()->GetPhy();
+  return (NanoSeconds(EstimateTxDuration(maxPacketSize,wifiphy).GetNanoSeconds()*backlog));
+}
+
+//////////////////////TInterfaceAcceptsFrame
+bool 
+Sica::TInterfaceAcceptsFrame(uint32_t ch, Time txEstimation)
+{
+  uint32_t backlog=GetDeviceBacklog(m_tInterface);
+  if (backlog >= m_maxDeviceBacklog)
+    return false;
+  // a frame which ends after the T interface left the channel is sent on the wrong channel
+  return (TInterfaceReadyToSend(ch,GetDeviceBacklogTime(m_tInterface,backlog)+txEstimation));
+}
+
+//////////////////////RInterfaceAcceptsFrame
+bool 
+Sica::RInterfaceAcceptsFrame(Time txEstimation)
+{
+  uint32_t backlog=GetDeviceBacklog(m_rInterface);
+  if (backlog >= m_maxDeviceBacklog)
+    return false;
+  return (RInterfaceReadyToSend(GetDeviceBacklogTime(m_rInterface,backlog)+txEstimation));
+}
+
+//////////////////////NotifyDeviceTxEnd
+void 
+Sica::NotifyDeviceTxEnd(uint32_t ifIndex)
+{
+  if (!m_macBackpressure || !m_tBackpressureChannel || ifIndex != m_tInterface->GetIfIndex())
+    return;
+  Ptr<WifiPhy> wifiphy = m_tInterface->GetObject<WifiNetDevice>()->GetPhy();
+  if (wifiphy->GetChannelNumber() != m_tBackpressureChannel)
+    {
+      m_tBackpressureChannel=0;
+      return;
+    }
+  // out of the MAC event which reports the end of the frame, only once for the frames which end together
+  Simulator::ScheduleNow(&Sica::TInterfaceSend,this,m_tBackpressureChannel);
+  m_tBackpressureChannel=0;
+}
+
 /************************************************************/
 
 //////////////////////GameChannelAssignment
@@ -1239,6 +2786,7 @@ Sica::RInterfaceReadyToSend(Time txEstimation)
 Sica::GameChannelAssignment()
  {
    m_CATimer.Cancel();
+   Time backoff=Seconds(0);
    /// Allotted function 
    if (m_rNewChannel != m_rChannel)
      NS_LOG_DEBUG (  "Sica node " << m_id <<" :"<< "Already has a channel switching attempt. Finished!");
@@ -1247,20 +2795,105 @@ Sica::GameChannelAssignment()
      UpdateLossMatrix();
      // NS_LOG_INFO (  "Sica node " << m_id <<" :"<< "Game CA: Loss function is  ");
      // copy(m_loss.begin(), m_loss.end(), std::ostream_iterator<double>(std::cout, "\n"));
-     UpdateChannelWeight();
+     m_strategy->Update(GetChannelObservation(),m_channel);
+     UpdateChannelSampler();
      m_rNewChannel=SelectRandomChannel();
      NS_ASSERT_MSG(m_rNewChannel >= Min_CH,"Selected channel is less than Min_CH");
      NS_ASSERT_MSG(m_rNewChannel<= Max_CH,"Selected channel is bigger  than Max_CH");
      NS_LOG_DEBUG (  "Sica node " << m_id <<" :"<< "Game CA: New Channel for R would be  " << m_rNewChannel);
+     if (m_rNewChannel != m_rChannel && InSwitchHoldDown())
+       {
+	 NS_LOG_DEBUG (  "Sica node " << m_id <<" :"<< "Game CA: switch is held down until " << (m_lastSwitchTime+m_switchHoldDown).GetSeconds());
+	 m_rNewChannel=m_rChannel;
+       }
+     backoff=CoordinateSwitch();
      if (m_rNewChannel != m_rChannel)
        ScheduleSwitchRInterface();
+     if (m_convergence.Update(m_channelProb,m_rNewChannel != m_rChannel))
+       {
+	 NS_LOG_DEBUG (  "Sica node " << m_id <<" :"<< "Game CA: converged state is now " << m_convergence.IsConverged());
+	 m_sicaConverged(m_id,m_convergence.IsConverged(),Simulator::Now());
+       }
+     AdaptIntervals();
    }
    // PrintNeighborTable(std::cout);
    // PrintChannelTable(std::cout);
-   m_CATimer.Schedule();
+   if (backoff.IsStrictlyPositive() && backoff < m_CATimer.GetDelay())
+     m_CATimer.Schedule(backoff);
+   else
+     m_CATimer.Schedule();
  }
 
 
+//////////////////////AdaptIntervals
+void 
+Sica::AdaptIntervals()
+{
+  if (!m_adaptiveIntervals)
+    return;
+  double ca=m_CATimer.GetDelay().GetSeconds();
+  double hello=m_helloTimer.GetDelay().GetSeconds();
+  // the neighbors must receive at least two hellos before the information expires
+  double maxHello=std::max(std::min(m_maxHelloInterval.GetSeconds(),NeighborExpireTime.GetSeconds()/2),HelloInterval.GetSeconds());
+  if (m_convergence.IsConverged())
+    {
+      ca=std::min(ca*m_intervalScale,std::max(m_maxCAInterval,ChannelAssignmentInterval).GetSeconds());
+      hello=std::min(hello*m_intervalScale,maxHello);
+    }
+  else if (!m_convergence.IsStable())
+    {
+      // the interval comes back to the configured one, never below
+      ca=std::max(ca/m_intervalScale,ChannelAssignmentInterval.GetSeconds());
+      hello=HelloInterval.GetSeconds();
+    }
+  m_CATimer.SetDelay(Seconds(ca));
+  // the adaptive hello scheduler owns the hello interval
+  if (!m_adaptiveHello && Seconds(hello) != m_helloTimer.GetDelay())
+    {
+      m_helloTimer.SetDelay(Seconds(hello));
+      // a shorter interval must be effective now
+      ReScheduleTimer(&m_helloTimer,Seconds(hello));
+    }
+  NS_LOG_DEBUG (  "Sica node " << m_id <<" :"<< "Channel assignment interval is " << ca << "s, hello interval is " << hello << "s");
+}
+
+//////////////////////CheckInterferenceChange
+void 
+Sica::CheckInterferenceChange(uint32_t c, double before)
+{
+  if (std::fabs(m_channel.GetChannelExtBandwidth(c)-before) >= m_bxChangeThreshold)
+    NotifyInterferenceChange(c);
+}
+
+//////////////////////NotifyInterferenceChange
+void 
+Sica::NotifyInterferenceChange(uint32_t c)
+{
+  bool wasConverged=m_convergence.IsConverged();
+  m_convergence.Reset();
+  if (wasConverged)
+    {
+      NS_LOG_DEBUG (  "Sica node " << m_id <<" :"<< "Interference changed on channel " << c << ", convergence restarts");
+      m_sicaConverged(m_id,false,Simulator::Now());
+    }
+  // our hello carries the interference of the R channel only
+  if (c == m_rChannel)
+    TriggerHello();
+  if (!m_adaptiveIntervals)
+    return;
+  // react to the change at the base pace
+  if (m_CATimer.GetDelay() > ChannelAssignmentInterval)
+    {
+      m_CATimer.SetDelay(ChannelAssignmentInterval);
+      ReScheduleTimer(&m_CATimer,ChannelAssignmentInterval);
+    }
+  if (!m_adaptiveHello && m_helloTimer.GetDelay() > HelloInterval)
+    {
+      m_helloTimer.SetDelay(HelloInterval);
+      ReScheduleTimer(&m_helloTimer,HelloInterval);
+    }
+}
+
 //////////////////////UpdateLossValues
 void 
 Sica::UpdateLossMatrix()
@@ -1268,8 +2901,15 @@ Sica::UpdateLossMatrix()
  // std::ostream &os=std::cout;
   std::vector<double> payoff;
 // copy(m_loss.begin(), m_loss.end(), std::ostream_iterator<double>(os, " , "));
+ if (m_useInterferenceGraph)
+   {
+     RmvExpiredNeighbors();
+     m_interferenceGraph.Build(m_nb,GetForwardingNeighbors());
+   }
  for (uint32_t i=Min_CH; i<=Max_CH; i++)
        {
+	 // data packets which expired in the queue were never delivered
+	 m_channel.RecordTxResult(i,false,m_queue.TakeExpiredData(i));
 	 m_loss[i-Min_CH]= ComputeStageLoss(i);
        }
  // copy(m_loss.begin(), m_loss.end(), std::ostream_iterator<double>(os, " , "));
@@ -1280,13 +2920,13 @@ Sica::UpdateLossMatrix()
 double 
 Sica::ComputeStageLoss(uint32_t c)
 {
-  double bx=static_cast<double>(m_channel.GetChannelExtBandwidth(c));
+  double bx=m_channel.GetChannelExtBandwidth(c);
   double b= static_cast<double>(Max_BW);
   double rNiC=static_cast<double>(m_channel.GetChannelNeighbors(c));
   double rNi=static_cast<double>(m_nb.GetNiNo());
   double TH=HelloInterval.Time::ToDouble(Time::S);
   double Ds;
-  double Loss;
+  double Loss=0;
   double ML;
  if (m_rChannel == c)
     Ds=0;
@@ -1294,101 +2934,121 @@ Sica::ComputeStageLoss(uint32_t c)
    Ds=SwitchingDelay.Time::ToDouble(Time::S);
        if (rNi!=0 && b!=0 && TH!=0)
 	 {
-	   ML= m_alpha*(bx/b) + (1-m_alpha)*(rNiC/rNi);
+	   if (m_useInterferenceGraph)
+	     ML= m_alpha*(bx/b) + (1-m_alpha)*m_interferenceGraph.GetConflictFraction(c);
+	   else
+	     ML= m_alpha*(bx/b) + (1-m_alpha)*(rNiC/rNi);
 	   Loss= m_gamma * ML + (1-m_gamma)* (Ds/TH);
+	   if (m_adjLossWeight > 0)
+	     Loss+= m_adjLossWeight*ComputeAdjacentChannelLeakage(c);
 	 } 
+ // load terms, they are measured even when the neighbor table is empty
+ uint32_t backlog=GetDataBacklog();
+ uint32_t niLoad=m_nb.GetNiLoadTotal();
+ double queueTerm= backlog > 0 ? static_cast<double>(m_queue.GetSize(c,SicaQueueEntry::Data_Type))/backlog : 0;
+ double txFailTerm= m_channel.GetTxFailureRatio(c);
+ double niLoadTerm= niLoad > 0 ? static_cast<double>(m_nb.GetNiLoadOnChannel(c))/niLoad : 0;
+ Loss+= m_queueLossWeight*queueTerm + m_txFailLossWeight*txFailTerm + m_niLoadLossWeight*niLoadTerm;
+ if (m_linkLossWeight > 0)
+   Loss+= m_linkLossWeight*m_nb.GetNiLinkLossOnChannel(c);
+ m_sicaLossTerms(m_id,c,queueTerm,txFailTerm,niLoadTerm,Loss);
  NS_LOG_INFO("Sica node " << m_id <<" :"<< "Loss for channel "<< c << " computed from formula "<< LossFormulaNum << " is  "<< Loss << " bx " << bx << " b " << b << " neighbor on ch " <<rNiC << " ni "<< rNi<< " Ds " << Ds << " TH " <<TH << " Alpha is "<< m_alpha);
  return Loss;
 }
 
  
 
-//////////////////////UpdateChannelWeight
-void 
-Sica::UpdateChannelWeight()
+//////////////////////GetDataBacklog
+uint32_t 
+Sica::GetDataBacklog()
 {
-  double wT1;
-  double wT;
+  uint32_t backlog=0;
   for (uint32_t i=Min_CH; i<=Max_CH; i++)
+    backlog+=m_queue.GetSize(i,SicaQueueEntry::Data_Type);
+  return (backlog);
+}
+
+//////////////////////GetForwardingNeighbors
+std::set<uint32_t> 
+Sica::GetForwardingNeighbors()
+{
+  std::set<uint32_t> pathNodes;
+  Ptr<RTable> rTable=GetObject<Node> ()->GetObject<RTable> ();
+  if (rTable)
     {
-      wT= m_channel.GetChannelWeight(i);
-      wT1= wT * pow(m_beta,(m_loss[i-Min_CH]));
-      m_channel.SetChannelWeight(i,wT1);
-      NS_LOG_INFO("Sica node " << m_id <<" :"<<"weight for channel "<< i << " is  "<< wT1 << " loss is  " << m_loss[i-Min_CH] <<" b^loss is  " <<pow(m_beta,(m_loss[i-Min_CH]))<< " wT-1 was "<< wT);
+      std::vector<uint32_t> hops=rTable->GetNextHops(m_id);
+      pathNodes.insert(hops.begin(),hops.end());
+      hops=rTable->GetPreviousHops(m_id);
+      pathNodes.insert(hops.begin(),hops.end());
     }
+  return (pathNodes);
 }
 
-//////////////////////SelectRandomChannel
+//////////////////////ComputeAdjacentChannelLeakage
+double 
+Sica::ComputeAdjacentChannelLeakage(uint32_t c)
+{
+  const AdjacentChannelMatrix &adj=m_channelEmuObjects.GetAdjacentChannelMatrix();
+  double leak=0;
+  uint32_t niCh;
+  if (adj.IsOrthogonal() || m_nb.GetNiNo()==0)
+    return 0;
+  for (uint32_t i = 1; i <= m_nb.GetNiNo(); i++)
+    {
+      niCh=static_cast<uint32_t>(m_nb.GetNiChannelByIndex(i));
+      if (niCh != c)
+	leak+=adj.GetCoupling(c,niCh);
+    }
+  return (leak/m_nb.GetNiNo());
+}
 
-uint32_t 
-Sica::SelectRandomChannel()
+//////////////////////GetChannelObservation
+SicaChannelObservation
+Sica::GetChannelObservation()
+{
+  SicaChannelObservation obs;
+  obs.totalNeighbors=m_nb.GetNiNo();
+  obs.current=m_rChannel;
+  for (uint32_t i=Min_CH; i<=Max_CH; i++)
+    {
+      obs.channels.push_back(i);
+      obs.loss.push_back(m_loss[i-Min_CH]);
+      obs.bx.push_back(m_channel.GetChannelExtBandwidth(i));
+      obs.neighbors.push_back(m_channel.GetChannelNeighbors(i));
+    }
+  return obs;
+}
+
+//////////////////////UpdateChannelSampler
+
+void 
+Sica::UpdateChannelSampler()
 {
   std::vector<uint32_t> channels;
   std::vector<double> prob;
-  std::vector<double> weight;
-  std::vector<double> cProb;
-  // EmpiricalVariable  emRnd;
-  Ptr<EmpiricalRandomVariable> emRnd = CreateObject<EmpiricalRandomVariable> ();
   double totalWeight=0;
-  double tempW;
   // read the weights of channels
   for (uint32_t i=Min_CH; i<=Max_CH; i++)
     {
       channels.push_back(i);
-      tempW=m_channel.GetChannelWeight(i);
-      weight.push_back(tempW);
-      totalWeight+=tempW;
+      prob.push_back(m_channel.GetChannelWeight(i));
+      totalWeight+=prob.back();
     }
-  
-  for (uint32_t i=0; i<weight.size(); i++)
-    prob.push_back(weight[i]/totalWeight);
+  for (uint32_t i=0; i<prob.size(); i++)
+    prob[i]/=totalWeight;
   NotifyChannelProbability (prob);
-  sort(channels.begin(),channels.end(),CompareChannelsWeight(*this));
-  sort(prob.begin(),prob.end());
-  cProb=ComputeCumulativeProbability(prob);
-  for (uint32_t i=0; i< cProb.size(); i++){
-    // emRnd.CDF(i,cProb[i]);
-    emRnd->CDF(i,cProb[i]);
-  }
-    
-
-  //PrintGameData(std::cout ,channels, prob, weight,cProb );
-
-  // return  channels[emRnd.GetInteger()];
-  return  channels[emRnd->GetInteger()];
+  m_channelProb=prob;
+  // channels[i] keeps its own probability prob[i] in the alias table
+  m_channelSampler.Build(channels,prob);
 }
 
+//////////////////////SelectRandomChannel
 
-
-//////////////////////ComputeCumulativeProbability
-std::vector<double> 
-Sica::ComputeCumulativeProbability(std::vector<double> p)
+uint32_t 
+Sica::SelectRandomChannel()
 {
-  std::vector<double> c;
-  c.push_back(0);
-  NS_LOG_DEBUG("Sica Node "<< m_id <<":" << "comulative probability is >>");
-  for (uint32_t i=1; i<= p.size(); i++)
-    {
-    c.push_back(c[i-1]+p[i-1]);
-    NS_LOG_DEBUG("----- "<< i-1 <<" prob -> " <<p[i-1] << " cptob -> "<< c[i]);
-    }
-
-  return c;
-}
-
-//////////////////////PrintGameData
-void 
-Sica::PrintGameData(std::ostream &os ,std::vector<uint32_t> channels,std::vector<double> prob,std::vector<double> weight,std::vector<double> cProb )
-{
-  os << "\n";
-  copy(weight.begin(), weight.end(), std::ostream_iterator<double>(os, "--"));
-  os << "\n";
-  copy(channels.begin(), channels.end(), std::ostream_iterator<uint32_t>(os, "--"));
-  os << "\n";
-  copy(prob.begin(), prob.end(), std::ostream_iterator<double>(os, "--"));
-  os << "\n";
-  copy(cProb.begin(), cProb.end(), std::ostream_iterator<double>(os, "--"));
-  os << "\n";
+  NS_ASSERT_MSG(!m_channelSampler.IsEmpty(),"Channel sampler is not built");
+  return m_channelSampler.Sample(m_uniformRandom);
 }
 
 
@@ -17,6 +17,8 @@
  * \defgroup sica Sica
  */
 
+#include <set>
+#include <map>
 #include "ns3/simulator.h"
 #include "ns3/timer.h"
 #include "ns3/object.h"
@@ -32,8 +34,16 @@
 #include "ns3/sica-channel.h"
 #include "ns3/channel-emulation.h"
 #include "ns3/sica-rtable.h"
+#include "ns3/sica-phy-sensor.h"
+#include "ns3/sica-channel-sampler.h"
+#include "ns3/sica-channel-strategy.h"
+#include "ns3/sica-convergence.h"
+#include "ns3/sica-interference-graph.h"
+#include "ns3/type-id.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/integer.h"
+#include "ns3/uinteger.h"
 #include "ns3/simulator.h"
 #include "ns3/ipv4.h"
 #include "ns3/channel.h"
@@ -44,7 +54,12 @@
 #include "ns3/inet-socket-address.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/wifi-net-device.h"
+#include "ns3/wifi-remote-station-manager.h"
 #include "ns3/adhoc-wifi-mac.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/pointer.h"
+#include "ns3/qos-tag.h"
+#include "ns3/string.h"
 #include "ns3/yans-wifi-channel.h"
 #include "ns3/yans-wifi-phy.h"
 #include "ns3/wifi-phy.h"
@@ -53,12 +68,19 @@
 #include "ns3/delay-jitter-estimation.h"
 // #include "ns3/matrix.h"
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <vector>
 #include <iostream> 
 #include <ostream>
 #include <iterator>
 
+class SicaSwitchCoordinationTestCase;
+class SicaSwitchRetryTestCase;
+class SicaHelloBackoffTestCase;
+class SicaRetransmitTestCase;
+class SicaBackpressureTestCase;
+class SicaRendezvousTestCase;
 
 namespace ns3 {
 
@@ -79,35 +101,41 @@ namespace ns3 {
  */
 class Sica : public Object
 {
+  /// the test case sets the channels and the switch state of the node
+  friend class ::SicaSwitchCoordinationTestCase;
+  /// the test case drives the switch timer instead of the R interface
+  friend class ::SicaSwitchRetryTestCase;
+  /// the test case gives the hellos sent by the node
+  friend class ::SicaHelloBackoffTestCase;
+  /// the test case gives the packets in flight and the feedback of the MAC
+  friend class ::SicaRetransmitTestCase;
+  /// the test case gives the devices and the frames they hold
+  friend class ::SicaBackpressureTestCase;
+  /// the test case drives the rendezvous timer without the control channel traffic
+  friend class ::SicaRendezvousTestCase;
  public: 
-  /**
-     *\brief Compare two channels based on the weights assigned to them, used to sort the list of channels based on their weight
-     *
-     */
-  class  CompareChannelsWeight{
-     Sica& that;
-  public:
-    ///c-tor
-    CompareChannelsWeight(Sica &s) : that(s) {}
-    /**
-     * \brief Get two channels id and compare them  based on the weighs assigned to each channel
-     *\param i  channel ID
-     *\param j  channel ID
-     *\return true  if the weight of first channel is less than the weight of the second channel. the channel with the bigger weight is more suitable for data transmission
-     */
-    bool operator()(uint32_t i, uint32_t j) const {
-      return (that.m_channel.GetChannelWeight(i)< that.m_channel.GetChannelWeight(j));
-    }
+  ///\enum SenseBackend the source of the channel occupancy used to estimate the external bandwidth
+  enum SenseBackend {
+    SENSE_EMULATOR = 0,///< sample the channel emulators (ChannelEmu)
+    SENSE_PHY      = 1,///< measure the busy airtime seen by the WifiPhy of the R interface
+    SENSE_COMBINED = 2,///< combine the emulated and the measured occupancy
   };
   ///c-tor
   Sica();
   ///d-tor
   virtual ~Sica();
-  //virtual void DoDispose ();
+  /// Release the listeners registered to the physical layers of the interfaces
+  virtual void DoDispose ();
   /**
    *  \brief Makes it possible for user to change protocol parameters through calling SetAttribute
    */
  static TypeId GetTypeId (void);
+  /**
+   * \brief Assign a fixed random variable stream number to the random variables used by this object
+   *\param stream first stream index to use
+   *\return the number of stream indices assigned by this object
+   */
+  int64_t AssignStreams (int64_t stream);
 /** 
    * 
    * \brief Public method used to fire a data-received  trace for a data packet being received. 
@@ -236,10 +264,17 @@ void  NotifyRxDropped (Ptr<Packet> packet, double snr);
    * \brief Check whether the channel associated to the net device is busy or not
    */
   bool ChannelIsBusy(uint32_t chId);
-  /**
-   *\brief Set the Sense channel flag to prevent other functions from sending data during the sensing period 
+ /**
+   * 
+   * \brief Return the busy fraction of the channel seen by the emulators, including the leakage of busy adjacent channels
    */
-  void ModifySenseChannelFlag(uint32_t c);
+  double GetChannelBusyFraction(uint32_t chId);
+ /**
+   * 
+   * \brief Return the adjacent channel leakage from the R channels of the neighbors to the given channel, normalized by the number of neighbors
+   *\param c the id of the channel
+   */
+  double ComputeAdjacentChannelLeakage(uint32_t c);
   /**
    *\brief Senses the current channel of receiving interface and estimate the external bandwidth
    */
@@ -253,6 +288,33 @@ void  NotifyRxDropped (Ptr<Packet> packet, double snr);
    *\brief Estimate the channel busy time at the end of the sensing period and write it in the channel table is called by  Sica::StartSenseCurrentChannel 
    */
   void EndSenseCurrentChannel();
+  /**
+   *\brief Return the busy fraction of the current R channel measured during the sensing period according to Sica::m_senseBackend
+   */
+  double ComputeSensedBusyFraction();
+  /**
+   *\brief Combine the busy fractions measured by the emulators and the phy according to Sica::m_senseBackend
+   *\param emuBusy the busy fraction seen by the channel emulators
+   *\param phyBusy the busy fraction measured by the phy
+   */
+  double CombineBusyFraction(double emuBusy, double phyBusy);
+  /**
+   *\brief Park the idle T interface on the stalest channel to measure its occupancy, called by Sica::TInterfaceStartSend when there is no backlog
+   *\return true if a scan is started
+   */
+  bool StartBackgroundScan();
+  /**
+   *\brief Sample the emulated occupancy of the scanned channel every Sica::ChannelSenseRate
+   */
+  void SampleScanChannel();
+  /**
+   *\brief Estimate the external bandwidth of the scanned channel at the end of the dwell time and write it in the channel table
+   */
+  void EndBackgroundScan();
+  /**
+   *\brief Return true if the T interface is parked on a channel for background scanning
+   */
+  bool IsScanning(){return (m_scanChannel != 0);}
  /**
    * 
    * \brief Re-schedule timer with minDelay if  minDelay is less than the delay left for timer t 
@@ -281,12 +343,45 @@ void  NotifyRxDropped (Ptr<Packet> packet, double snr);
    */
 
   void ProcessRcvHello(Ptr<Packet> p,Address srcAddr );
+/**
+   * 
+   * \brief Apply a received incremental hello to the last hello state of the neighbor and call Sica::HandleHello, ask for a full hello if the state is missing or a version was missed. After a missed version the state of the neighbor is dropped until its next full hello
+   *\param p received packet
+   *\param srcAddr the address of the sender
+   */
+  void ProcessRcvHelloDelta(Ptr<Packet> p,Address srcAddr );
+/**
+   * 
+   * \brief Remove the expired neighbors from the neighbor table and forget their last hello state
+   */
+  void RmvExpiredNeighbors();
+/**
+   * 
+   * \brief Update the neighbor and channel tables with the hello state of a neighbor
+   *\param sHeader the full hello state of the neighbor
+   *\param srcAddr the address of the sender
+   */
+  void HandleHello(SicaHelloHeader sHeader,Address srcAddr );
+/**
+   * 
+   * \brief Apply the switch announced by a neighbor to the neighbor table and schedule Sica::HandleNeighborSwitchChannel
+   *\param p received packet
+   */
+  void ProcessRcvSwitch(Ptr<Packet> p);
 /**
    * 
    * \brief Evaluate the  received  data packet, send it to Sica::NotifyRxReceived if the node is the destination of the packet or call Sica:: DistributeDataPacket to send it to the receiving channel of the next hop node.
    *\param p received packet
+   *\param srcAddr the address of the transmitter
+   */
+ void ProcessRcvData(Ptr<Packet> p, Address srcAddr);
+/**
+   * 
+   * \brief Update the channel, the pending switch and the external bandwidth of the transmitter of a data packet from the state it piggybacked, the rest of the neighbor entry is left to its hellos
+   *\param sHeader the header of the data packet
+   *\param srcAddr the address of the transmitter
    */
- void ProcessRcvData(Ptr<Packet> p);
+  void HandleStateTrailer(SicaHeader sHeader, Address srcAddr);
 
   /**
    * 
@@ -315,21 +410,75 @@ void  NotifyRxDropped (Ptr<Packet> packet, double snr);
    * 
    */
   SicaHelloHeader CreateHelloHeader();
+  /**
+   * 
+   * \brief Send a hello now because the state changed, the hello is delayed if the previous one is more recent than Sica::m_minHelloGap. It is done only if Sica::m_adaptiveHello is set
+   */
+  void TriggerHello();
+  /**
+   * 
+   * \brief Set the interval until the next hello, the base interval if the state changed since the previous hello, the previous interval multiplied by Sica::m_helloBackoffFactor otherwise
+   *\param sHeader the hello which is being sent, it advertises the interval
+   */
+  void AdaptHelloInterval(SicaHelloHeader &sHeader);
+  /**
+   * 
+   * \brief Account hellos avoided by the adaptive hello scheduler
+   *\param count the number of hellos avoided
+   */
+  void NotifyHelloSuppressed(uint32_t count);
+  /**
+   * 
+   * \brief Keep in the hello only the next part of the neighbors, the parts rotate over the successive hellos
+   *\param sHeader the hello which carries all the neighbors
+   */
+  void SelectHelloPart(SicaHelloHeader &sHeader);
+  /// Schedule the first rendezvous over the common control channel
+  void InitializeRendezvous();
+  /// Start a rendezvous window: the R interface listens to the control channel and the hello is sent over it
+  void StartRendezvous();
+  /// End a rendezvous window: the R interface goes back to its channel
+  void EndRendezvous();
+  /**
+   * 
+   * \brief Advance the next rendezvous to the one of a neighbor if it is earlier
+   *\param niRendezvous the time to the next rendezvous of the neighbor
+   */
+  void AlignRendezvous(Time niRendezvous);
+  /**
+   * 
+   * \brief Return the number of control packets which can be sent over a channel, none outside the rendezvous in common control channel mode
+   *\param ch the channel
+   */
+  uint32_t GetControlQueueSize(uint32_t ch);
+  /// Return true during a rendezvous window over the common control channel
+  bool InRendezvous(){return m_inRendezvous;}
+  /// Return the number of hellos sent
+  uint32_t GetHellosSent(){return m_hellosSent;}
+  /// Return the number of hellos avoided by the adaptive hello scheduler
+  uint32_t GetHellosSuppressed(){return m_hellosSuppressed;}
  
   /**
    * 
    * \brief  distribute hello message to all channels over which the node  has a neighbor
    *\param p hello packet
+   *\param ptype the type of the hello, full or incremental
    */
-  void DistributeHello(Ptr<Packet> p);
+  void DistributeHello(Ptr<Packet> p, SicaQueueEntry::PacketType ptype=SicaQueueEntry::Hello_Type);
+  /**
+   *\brief Return the protocol number used to send a queued packet
+   *\param ptype the type of the queue entry
+   */
+  uint32_t GetControlPort(SicaQueueEntry::PacketType ptype);
 
     /**
    * 
    * \brief Produces uni-cast data packet with given packet size and destination address  and push it to neighbor channel
    * \param dstId the id of the destination node
    *\param pSize the size of the data packet 
+   *\param trafficClass the traffic class of the packet (SicaHeader::SetTrafficClass)
    */
-  void CreateData(uint32_t  dstId, uint32_t pSize);
+  void CreateData(uint32_t  dstId, uint32_t pSize, uint8_t trafficClass=0);
 
  /**
    * 
@@ -338,12 +487,87 @@ void  NotifyRxDropped (Ptr<Packet> packet, double snr);
    * \param dstId the id of the destination node 
    * \param srcId the id of the source node
    *\param originTime the time of origination packet
+   *\param trafficClass the traffic class of the packet
+   */
+  int AddDataHeaders(Ptr<Packet> p,uint32_t srcId, uint32_t dstId, Time originTime, uint8_t trafficClass=0);
+  /**
+   * 
+   * \brief Return the cost of the link to a next hop for the routing table, the ETX of the link
+   *\param niId the id of the next hop
+   *\return a negative value if the next hop is not a direct neighbor
+   */
+  double GetLinkCost(uint32_t niId);
+  /**
+   * 
+   * \brief Count an acknowledged data transmission in the link quality of the receiver and release the packet kept for retransmission
+   *\param context the index of the device
+   *\param hdr the header of the transmitted frame
+   */
+  void NotifyMacTxOk(std::string context, const WifiMacHeader &hdr);
+  /**
+   * 
+   * \brief The MAC gave up a data frame, retransmit the packet kept for it by Sica::RetransmitData
+   *\param context the index of the device
+   *\param hdr the header of the frame
+   */
+  void NotifyMacTxErr(std::string context, const WifiMacHeader &hdr);
+  /**
+   * 
+   * \brief Count the result reported by the MAC for a data frame in the transmission history of the channel of the device
+   *\param ifIndex the index of the device
+   *\param ok true if the frame was acknowledged
+   */
+  void RecordDeviceTxResult(uint32_t ifIndex, bool ok);
+  /**
+   * 
+   * \brief Count a failed data transmission attempt in the link quality of the receiver
+   *\param addr the address of the receiver
+   */
+  void NotifyMacTxFailed(Mac48Address addr);
+  /**
+   * 
+   * \brief Remember the UID of the data frame the device starts to transmit, the feedback of the MAC is given for this frame
+   *\param context the index of the device
+   *\param p the frame with its MAC header
+   */
+  void NotifyPhyTxBegin(std::string context, Ptr<const Packet> p);
+  /**
+   * 
+   * \brief The MAC dropped a packet before its transmission, retransmit the data packet kept for it by Sica::RetransmitData
+   *\param context the index of the device
+   *\param p the dropped packet
+   */
+  void NotifyMacTxDrop(std::string context, Ptr<const Packet> p);
+  /// data packets handed to a device and waiting for the feedback of the MAC: sending time and packet, per device index and packet UID
+  typedef std::map<std::pair<uint32_t, uint64_t>, std::pair<Time, Ptr<Packet> > > InFlightPackets;
+  /**
+   * 
+   * \brief Take the data packet handed to a device with the given UID
+   *\param ifIndex the index of the device
+   *\param uid the UID of the packet
+   *\return 0 if there is no such packet
+   */
+  Ptr<Packet> TakeInFlight(uint32_t ifIndex, uint64_t uid);
+  /**
+   * 
+   * \brief Retransmit the packets which got no feedback from the devices during Sica::m_txFeedbackTimeout, they were dropped silently by the MAC.
+   * Run by Sica::m_inFlightTimer as long as packets wait for their feedback
    */
-  int AddDataHeaders(Ptr<Packet> p,uint32_t srcId, uint32_t dstId, Time originTime);
+  void ExpireInFlight();
+  /**
+   * 
+   * \brief Send again a data packet lost by the device, the next hop is chosen again and the packet follows its current channel. The packet is dropped after Sica::m_maxRetries retransmissions over the hop (SicaRetryTag)
+   *\param p the packet with its Sica header
+   */
+  void RetransmitData(Ptr<Packet> p);
+  /// Return the number of data packets retransmitted to a neighbor
+  uint32_t GetTxRetries(uint32_t niId);
+  /// Return the number of data packets to a neighbor dropped after the retransmissions
+  uint32_t GetTxDrops(uint32_t niId);
  
 /**
    * 
-   * \brief  Distribute the  data  message to the appropriate  channel 
+   * \brief  Distribute the  data  message to the appropriate  channel, the packet expires after the DataExpireTime of its traffic class
    *\param p  The packet produced by create Sica::CreateData
    * \param nextHopChannel The id of the channel where the data must be sent
    */
@@ -393,6 +617,74 @@ void  NotifyRxDropped (Ptr<Packet> packet, double snr);
    * 
    */ 
  void SwitchRInterface();
+  /** 
+   * \brief Impose a channel to the R interface from outside the game (e.g. SicaChannelOracle), the switch is announced by a hello and scheduled as a switch decided by the game
+   * \param ch the channel to which the R interface will switch
+   * \param warmStart if true the weight of the channel becomes the biggest one so that the game starts from it
+   */ 
+  void ForceRChannel(uint32_t ch, bool warmStart);
+  /** 
+   * \brief Withdraw our pending switch if a direct neighbor with a lower Id announced a conflicting switch, the channel assignment is then run again after the neighbor switch and a random backoff. The neighbors are told about the withdrawal of a switch already announced
+   * \return the time until the new channel assignment, zero if our switch is kept
+   */ 
+  Time CoordinateSwitch();
+  /** 
+   * \brief Return true if the R interface switched less than Sica::m_switchHoldDown ago
+   */ 
+  bool InSwitchHoldDown();
+  /** 
+   * \brief Move the packets of a neighbor to the queue of its new channel and account them as delayed by the switch
+   * \param niId the Id of the neighbor
+   * \param from the previous channel of the neighbor
+   * \param to the new channel of the neighbor
+   */ 
+  void ShuffleNeighborData(uint32_t niId, uint32_t from, uint32_t to);
+  /** 
+   * \brief Find from which time to the end of a frame sent over the channel now the neighbor must not receive it, because it leaves the channel before the end of the frame or it is not yet listening to the channel
+   * \param niId the Id of the neighbor
+   * \param ch the channel of the transmission
+   * \param start the time to the end of the frame from which the frames to the neighbor are held
+   * \return false if the frames to the neighbor are never held
+   */ 
+  bool GetNeighborHoldStart(uint32_t niId, uint32_t ch, Time &start);
+  /// The neighbors to hold in a send burst, keyed by the time to the end of the frame from which they are held
+  typedef std::multimap<Time, uint32_t> HoldSchedule;
+  /** 
+   * \brief Gather the neighbors to hold over the channel, it is called once at the start of a send burst
+   * \param ch the channel of the transmission
+   */ 
+  HoldSchedule GetHoldSchedule(uint32_t ch);
+  /** 
+   * \brief Move to the held set the neighbors of the schedule which are held within the horizon, the packets of the neighbors which leave the channel are moved to the queue of their new channel
+   * \param schedule the schedule of the burst given by Sica::GetHoldSchedule
+   * \param ch the channel of the transmission
+   * \param horizon the time until the end of the frame
+   * \param held the neighbors to which no frame must be sent
+   */ 
+  void HoldNeighbors(HoldSchedule &schedule, uint32_t ch, Time horizon, std::set<uint32_t> &held);
+  /// Return the number of data packets moved to another channel queue because a neighbor switched
+  uint32_t GetSwitchDelayedPackets(){return m_switchDelayed;}
+  /// Return the number of data packets sent to a neighbor which had switched or was switching before the end of the frame
+  uint32_t GetSwitchStalePackets(){return m_switchStale;}
+  /// Return the number of switches of the R interface withdrawn by the coordination
+  uint32_t GetSwitchDeferrals(){return m_switchDeferrals;}
+  /// Return the number of switches of the R interface
+  uint32_t GetSwitchCount(){return m_switchCount;}
+  /** 
+   * \brief Start announcing the pending switch (or its withdrawal) of the R interface to all the direct neighbors, it is done only if Sica::m_switchAnnouncement is set
+   */ 
+  void AnnounceSwitch();
+  /** 
+   * \brief Queue a switch announcement on the channels of the neighbors which have not acknowledged it yet and schedule the next retry, the retries of a pending switch start after the switch
+   */ 
+  void SendSwitchAnnouncement();
+  /** 
+   * \brief Mark the switch announcement as acknowledged by a neighbor, a data packet or a hello of the neighbor which reaches us on our new channel is an implicit acknowledgement
+   * \param niId the Id of the neighbor
+   */ 
+  void AckSwitchAnnouncement(uint32_t niId);
+  /// Return the number of direct neighbors which have not acknowledged the last switch announcement
+  uint32_t GetSwitchUnacked(){return m_switchUnacked.size();}
   /**
    *\brief Switch the T interface to a channel for sending data
    *\param c The channel to which the T interface will switch
@@ -431,6 +723,38 @@ bool SwitchTInterface(uint32_t c);
    *\return true if the R interface is ready to send, false otherwise
    */
   bool RInterfaceReadyToSend(Time txEstimation);
+  /**
+   * 
+   * \brief Return the number of frames handed to a device which did not end yet: the frames in the queues of the MAC, with the access category queues of a QoS MAC, and the data frame in transmission
+   *\param device the interface
+   */
+  uint32_t GetDeviceBacklog(Ptr<NetDevice> device);
+  /**
+   * 
+   * \brief Return the time a device needs to send the frames it already holds, each frame is supposed of maximum size
+   *\param device the interface
+   *\param backlog the number of frames in the device (Sica::GetDeviceBacklog)
+   */
+  Time GetDeviceBacklogTime(Ptr<NetDevice> device, uint32_t backlog);
+  /**
+   * 
+   * \brief Check the backpressure of the T interface: one more frame is handed to the device only if it holds less than Sica::m_maxDeviceBacklog frames and the new frame ends after them before the T interface leaves the channel
+   *\param ch the channel of the T interface
+   *\param txEstimation the time estimation for sending the new frame
+   */
+  bool TInterfaceAcceptsFrame(uint32_t ch, Time txEstimation);
+  /**
+   * 
+   * \brief Check the backpressure of the R interface: one more frame is handed to the device only if it holds less than Sica::m_maxDeviceBacklog frames and the new frame ends after them before the next switch of the R interface
+   *\param txEstimation the time estimation for sending the new frame
+   */
+  bool RInterfaceAcceptsFrame(Time txEstimation);
+  /**
+   * 
+   * \brief Resume the transmission of the T interface stopped by the backpressure when the device ends a frame
+   *\param ifIndex the index of the device
+   */
+  void NotifyDeviceTxEnd(uint32_t ifIndex);
   
   //\}
  ///\name Sica Channel Decision making mechanisms
@@ -451,41 +775,72 @@ bool SwitchTInterface(uint32_t c);
    */ 
   double ComputeStageLoss(uint32_t c);
 /** 
-   * \brief Compute the new  weight for all available channels based on their previous weight and the given loss vector
+   * \brief Return the number of data packets queued for all the channels
    */ 
-  void UpdateChannelWeight();
+  uint32_t GetDataBacklog();
 /** 
-   * \brief select a random channel based on the probability assigned to each channel
-   * \return the random channel
+   * \brief Return the Ids of the next and previous hops of the routes crossing the node, empty if the node has no routing table
    */ 
-  uint32_t SelectRandomChannel();
+  std::set<uint32_t> GetForwardingNeighbors();
 /** 
-   * \brief compute the cumulative probability of channels
-   * \param p the probability vector  assigned to all channels
-   *\return The cumulative probability 
+   * \brief Return the interference graph built at the last channel assignment
    */ 
-  std::vector<double> ComputeCumulativeProbability(std::vector<double> p);
+  const SicaInterferenceGraph & GetInterferenceGraph() const {return m_interferenceGraph;}
 /** 
-   * \brief Print game information, it is called by Sica::GameChannelAssignment this function must be called by Sica::GameChannelAssignment
-   * \param os the output media
-   *\param channels the id of channels
-   *\param prob the probability vector assigned to channels
-   *\param weight the weight assigned to channels
-   *\param cProb the cumulative probability
-   */ 
-  void PrintGameData(std::ostream &os ,std::vector<uint32_t> channels,std::vector<double> prob,std::vector<double> weight,std::vector<double> cProb );
+   * \brief Lengthen the channel assignment and hello intervals when the node has converged, shorten them when it has not, within the configured bounds
+   */ 
+  void AdaptIntervals();
+/** 
+   * \brief Compare the external bandwidth of a channel with its value before an update and call Sica::NotifyInterferenceChange if it has changed significantly
+   * \param c the id of the channel
+   * \param before the estimated external bandwidth before the update
+   */ 
+  void CheckInterferenceChange(uint32_t c, double before);
+/** 
+   * \brief Restart the convergence detection and restore the base intervals after a change of the interference
+   * \param c the id of the channel whose interference changed
+   */ 
+  void NotifyInterferenceChange(uint32_t c);
+/** 
+   * \brief Return the convergence monitor of the channel assignment
+   */ 
+  const SicaConvergenceMonitor & GetConvergenceMonitor() const {return m_convergence;}
+/** 
+   * \brief Gather the per-channel observations given to the channel selection strategy
+   */ 
+  SicaChannelObservation GetChannelObservation();
+/** 
+   * \brief Return the channel selection strategy, it is created by Sica::Initialize
+   */ 
+  Ptr<SicaChannelSelectionStrategy> GetChannelSelectionStrategy(){return m_strategy;}
+/** 
+   * \brief compute the probability of each channel from its weight and rebuild the alias table Sica::m_channelSampler, it must be called whenever the weights of channels change
+   */ 
+  void UpdateChannelSampler();
+/** 
+   * \brief select a random channel based on the probability assigned to each channel, the draw uses the alias table built by Sica::UpdateChannelSampler
+   * \return the random channel
+   */ 
+  uint32_t SelectRandomChannel();
  //\}
 ///\name Sica Parameters
   //\{
   uint32_t LossFormulaNum;
   uint32_t SICA_DATA_PORT; ///< protocol id used to send sica data packets (Default=550)
   uint32_t SICA_HELLO_PORT; ///< protocol id used to send sica broadcast packets (Default=551)
+  uint32_t SICA_SWITCH_PORT; ///< protocol id used to send sica switch announcements (Default=552)
+  uint32_t SICA_HELLO_DELTA_PORT; ///< protocol id used to send sica incremental hellos (Default=553)
   uint32_t Max_CH; ///< Maximum Number of available channels (Default=8)
   uint32_t Min_CH; ///< The first Index of the available channels (Default=1)
   uint32_t Max_BW; ///< Maximum available bandwidth of each channel
   double m_gamma;///< Gamma parameter for channel decision
   double m_beta;///< Beta parameter for calculating the channel weights in decision game
   double m_alpha;///< Alpha parameter for calculating the loss in decision game
+  double m_adjLossWeight;///< Weight of the adjacent channel leakage term in the loss, 0 disables it
+  double m_queueLossWeight;///< Weight of the share of our data backlog queued for the channel in the loss, 0 disables it
+  double m_txFailLossWeight;///< Weight of the failure ratio of our transmissions over the channel in the loss, 0 disables it
+  double m_niLoadLossWeight;///< Weight of the share of the neighbors backlog advertised on the channel in the loss, 0 disables it
+  double m_linkLossWeight;///< Weight of the delivery failure of the links to the neighbors on the channel in the loss, 0 disables it
  /// Hello message interval 
   Time HelloInterval;
   /// The maximum period of time that Sica is allowed to buffer a data packet for 2000 seconds.
@@ -545,17 +900,96 @@ private:
    * \see class CallBackTraceSource
    */
   TracedCallback< uint32_t ,std::vector<double> , Time > m_sicaChannelProb;
+/**
+   * The trace source fired when the background scan of a channel finishes, gives node id, channel and the measured bx
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,uint32_t ,double , Time > m_sicaChannelScanned;
+/**
+   * The trace source fired when the channel assignment of the node converges or leaves the converged state
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,bool , Time > m_sicaConverged;
+/**
+   * The trace source fired when the loss of a channel is computed, gives node id, channel, the queue backlog, TX failure and neighbor load terms and the total loss
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,uint32_t ,double ,double ,double ,double > m_sicaLossTerms;
+/**
+   * The trace source fired when data packets are affected by the switch of a neighbor, gives node id, neighbor id, the number of packets delayed (moved to the queue of the new channel) and the number of packets sent to a stale channel
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,uint32_t ,uint32_t ,uint32_t > m_sicaSwitchImpact;
+/**
+   * The trace source fired when a switch announcement is queued, gives node id, the new channel, the number of the attempt and the number of neighbors which have not acknowledged the announcement
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,uint32_t ,uint32_t ,uint32_t > m_sicaSwitchAnnounced;
+/**
+   * The trace source fired when hellos are avoided by the adaptive hello scheduler, gives node id, the number of hellos sent and the number of hellos suppressed so far
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,uint32_t ,uint32_t > m_sicaHelloSuppressed;
+/**
+   * The trace source fired when a data packet lost by the device is retransmitted or dropped, gives node id, neighbor id, the number of retransmissions of the packet and whether it is dropped
+   * 
+   * \see class CallBackTraceSource
+   */
+  TracedCallback< uint32_t ,uint32_t ,uint32_t ,bool > m_sicaTxRetry;
   ///used to keep busy duration of current receiving channel during channel sensing period
   Time m_busyChTime;
   ///used to keep idle duration of current receiving channel during channel sensing period 
   Time m_idleChTime;
+  /// the start of the current sensing period
+  Time m_senseStartTime;
+  /// busy airtime measured by the R interface phy at the start of the sensing period
+  Time m_phyBusyAtSenseStart;
+  /// the source of the channel occupancy for sensing
+  SenseBackend m_senseBackend;
+  /// measure the channel occupancy from the phy of the R interface
+  SicaPhySensor m_rSensor;
+  /// smoothing of the external bandwidth estimation
+  SicaBxEstimator::Mode m_bxEstimatorMode;
+  /// weight of a new sample in EWMA external bandwidth estimation
+  double m_bxEwmaWeight;
+  /// number of samples in the sliding window external bandwidth estimation
+  uint32_t m_bxWindowSize;
+  /// minimum weight of a neighbor report in the external bandwidth estimation
+  double m_bxNeighborWeight;
+  /// scan other channels with the T interface when it has nothing to send
+  bool m_backgroundScan;
+  /// the time the T interface stays over a scanned channel
+  Time m_scanDwellTime;
+  /// a channel whose last local sensing is older than this time is scanned again
+  Time m_scanStaleTime;
+  /// the channel being scanned by the T interface, 0 if there is no scan
+  uint32_t m_scanChannel;
+  /// the start of the current scan, after the switching delay
+  Time m_scanStartTime;
+  ///busy duration of the scanned channel seen by the emulators
+  Time m_scanBusyTime;
+  ///idle duration of the scanned channel seen by the emulators
+  Time m_scanIdleTime;
+  /// busy airtime measured by the T interface phy at the start of the scan
+  Time m_tPhyBusyAtScanStart;
+  /// measure the channel occupancy from the phy of the T interface
+  SicaPhySensor m_tSensor;
+  /// Timer to sample the scanned channel
+  Timer m_scanSampleTimer;
   //// used to control the delay before broadcasting
   Time m_bcastSendDelay;
  //// used to control the delay before start sending after switching to a channel
   Time m_TInterfaceSendDelay;
   ///\name Sica local variables
   //\{
-  uint32_t m_sqNo;///<sequence number for data and hello messages
+  uint32_t m_sqNo;///<sequence number for data messages
+  uint32_t m_helloSqNo;///<sequence number for hello messages, the receivers count the gaps
   uint32_t m_id; ///< node's unique ID
   uint32_t m_radio; ///< number of radio interface
   uint32_t m_rChannel;///< The current channel of receiving interface
@@ -576,10 +1010,10 @@ private:
   Timer m_TInterfaceSendTimer;
   /// Check the channel queue attached to the receiving channel for sending data
   Timer m_rInterfacePollTimer;
-  /// minimum delay time before switching R interface to a new channel
-  uint64_t m_minSwitchDelay;
-  /// maximum delay time before switching R interface to a new channel
-  uint64_t  m_maxSwitchDelay;
+  /// minimum delay time before switching R interface to a new channel, 0 means two hello intervals
+  Time m_minSwitchDelay;
+  /// maximum delay time before switching R interface to a new channel, 0 means three hello intervals
+  Time  m_maxSwitchDelay;
   /// channel on which t interface will send data 
   std::vector<uint32_t> channelsToPoll;
   /// loss matrix for each channel a node keep a loss value
@@ -593,6 +1027,170 @@ private:
   SicaChannels m_channel; ///< Channels' information
   ChannelEmuContainer m_channelEmuObjects;//< Channels emulation objects
   WifiPhy::RxErrorCallback errorCallback;
+  /// Random variable of the node used for the channel selection, the initial channel and the random delays
+  Ptr<UniformRandomVariable> m_uniformRandom;
+  /// Alias table of the channel probabilities
+  SicaChannelSampler m_channelSampler;
+  /// TypeId of the channel selection strategy
+  TypeId m_strategyTypeId;
+  /// The decision algorithm which computes the weights of the channels
+  Ptr<SicaChannelSelectionStrategy> m_strategy;
+  /// The probability of the channels computed at the last channel assignment
+  std::vector<double> m_channelProb;
+  /// Detect the convergence of the channel assignment
+  SicaConvergenceMonitor m_convergence;
+  /// adapt the channel assignment and hello intervals to the convergence
+  bool m_adaptiveIntervals;
+  /// maximum L1 change of the channel probabilities of a stable round
+  double m_convergenceThreshold;
+  /// number of stable rounds to be converged
+  uint32_t m_convergenceRounds;
+  /// factor by which the intervals are lengthened or shortened
+  double m_intervalScale;
+  /// upper bound of the adaptive channel assignment interval
+  Time m_maxCAInterval;
+  /// upper bound of the adaptive hello interval, it never exceeds NeighborExpireTime/2
+  Time m_maxHelloInterval;
+  /// change of the external bandwidth of a channel (Mbps) which restarts the convergence
+  double m_bxChangeThreshold;
+  /// use the interference graph instead of the plain fraction of neighbors in the loss
+  bool m_useInterferenceGraph;
+  /// weight of a conflict with a 1-hop neighbor
+  double m_oneHopConflictWeight;
+  /// weight of a conflict with a 2-hop neighbor
+  double m_twoHopConflictWeight;
+  /// factor of a conflict with a neighbor on a forwarding path
+  double m_pathConflictWeight;
+  /// conflicts of the node with its neighbors within two hops
+  SicaInterferenceGraph m_interferenceGraph;
+  /// withdraw our switch when a neighbor with a lower Id announces a conflicting one
+  bool m_switchCoordination;
+  /// maximum random backoff of the channel assignment after a withdrawn switch
+  Time m_switchBackoff;
+  /// minimum time between two switches of the R interface, 0 disables the hold-down
+  Time m_switchHoldDown;
+  /// time of the last switch of the R interface
+  Time m_lastSwitchTime;
+  /// number of switches of the R interface
+  uint32_t m_switchCount;
+  /// number of switches withdrawn by the coordination
+  uint32_t m_switchDeferrals;
+  /// number of data packets moved to another queue because a neighbor switched
+  uint32_t m_switchDelayed;
+  /// number of data packets sent to a neighbor which was no longer on the channel at the end of the frame
+  uint32_t m_switchStale;
+  /// hold the packets of a neighbor which switches before the end of the frame
+  bool m_switchTransmitHold;
+  /// announce the switches of the R interface with switch frames
+  bool m_switchAnnouncement;
+  /// maximum number of repetitions of a switch announcement
+  uint32_t m_switchAnnounceRetries;
+  /// time between two repetitions of a switch announcement
+  Time m_switchAnnounceInterval;
+  /// timer of the repetitions of the switch announcement
+  Timer m_switchAnnounceTimer;
+  /// number of times the current switch announcement has been queued
+  uint32_t m_switchAnnounceTries;
+  /// sequence number of the switch announcements
+  uint32_t m_switchSqNo;
+  /// direct neighbors which have not acknowledged the current switch announcement
+  std::set<uint32_t> m_switchUnacked;
+  /// send incremental hellos between the full ones
+  bool m_incrementalHello;
+  /// number of hellos between two full hellos
+  uint32_t m_helloSnapshotPeriod;
+  /// size of the payload of the full hellos
+  uint32_t m_helloPaddingSize;
+  /// version of our hello state
+  uint16_t m_helloVersion;
+  /// number of hellos sent since the last full hello
+  uint32_t m_hellosSinceSnapshot;
+  /// a neighbor asked for a full hello
+  bool m_helloSnapshotRequested;
+  /// we missed an incremental hello of a neighbor and ask for a full one
+  bool m_helloSnapshotWanted;
+  /// the last hello state we sent, the base of our next incremental hello
+  SicaHelloHeader m_lastHello;
+  /// the last hello state of each neighbor, the base of its next incremental hello
+  std::map<uint32_t, SicaHelloHeader> m_niHello;
+  /// send hellos on state changes and back off the periodic hellos
+  bool m_adaptiveHello;
+  /// minimum time between two triggered hellos
+  Time m_minHelloGap;
+  /// growth factor of the hello interval while the state does not change
+  double m_helloBackoffFactor;
+  /// time of the last hello
+  Time m_lastHelloTime;
+  /// number of hellos sent
+  uint32_t m_hellosSent;
+  /// number of hellos avoided by the adaptive hello scheduler
+  uint32_t m_hellosSuppressed;
+  /// send the hellos in the compact format
+  bool m_compactHello;
+  /// maximum number of neighbors carried by one hello
+  uint32_t m_maxHelloNeighbors;
+  /// next part of the neighbors sent in a hello
+  uint32_t m_helloPart;
+  /// common control channel, 0 if the control packets are sent over the channels of the neighbors
+  uint32_t m_controlChannel;
+  /// period of the rendezvous over the control channel
+  Time m_rendezvousPeriod;
+  /// duration of a rendezvous window
+  Time m_rendezvousWindow;
+  /// Timer to start the next rendezvous window
+  Timer m_rendezvousTimer;
+  /// Timer to end the current rendezvous window
+  Timer m_rendezvousEndTimer;
+  /// true during a rendezvous window
+  bool m_inRendezvous;
+  /// piggyback our state on the unicast data packets
+  bool m_stateTrailer;
+  /// number of hello sequence numbers used to compute the delivery ratio of the hellos of a neighbor
+  uint32_t m_linkWindow;
+  /// carry the delivery ratio of the hellos of the neighbors in our hellos
+  bool m_linkQualityHello;
+  /// choose the next hop among the alternative routes by the ETX of the link
+  bool m_etxRouting;
+  /// maximum number of retransmissions of a data packet over one hop, 0 disables the retransmissions
+  uint32_t m_maxRetries;
+  /// a data packet without feedback from the device after this time was dropped by the MAC
+  Time m_txFeedbackTimeout;
+  /// data packets waiting for the feedback of the devices
+  InFlightPackets m_inFlight;
+  /// timer of the packets without feedback (Sica::ExpireInFlight)
+  Timer m_inFlightTimer;
+  /// UID of the data frame in transmission per device index, until the feedback of the MAC
+  std::map<uint32_t, uint64_t> m_deviceTxUid;
+  /// number of data packets retransmitted per neighbor
+  std::map<uint32_t, uint32_t> m_txRetries;
+  /// number of data packets dropped after the retransmissions per neighbor
+  std::map<uint32_t, uint32_t> m_txDrops;
+  /// hand the devices only the frames which end before the interface leaves the channel
+  bool m_macBackpressure;
+  /// maximum number of frames waiting in a device with the backpressure
+  uint32_t m_maxDeviceBacklog;
+  /// channel on which the T interface waits for the device to end its frames, 0 if it does not wait
+  uint32_t m_tBackpressureChannel;
+  /// queue of the MAC of the R interface
+  Ptr<WifiMacQueue> m_rMacQueue;
+  /// queue of the MAC of the T interface
+  Ptr<WifiMacQueue> m_tMacQueue;
+  /// queues of the access categories of the MAC of the R interface
+  std::vector<Ptr<WifiMacQueue> > m_rEdcaQueues;
+  /// queues of the access categories of the MAC of the T interface
+  std::vector<Ptr<WifiMacQueue> > m_tEdcaQueues;
+  /// number of traffic classes of the data queues
+  uint32_t m_trafficClasses;
+  /// scheduling of the traffic classes
+  SicaQueue::Scheduler m_classScheduler;
+  /// weights of the traffic classes in the weighted scheduling, separated by spaces
+  std::string m_classWeights;
+  /// DataExpireTime of the traffic classes, separated by spaces
+  std::string m_classExpireTimes;
+  /// map the traffic classes to the 802.11e access categories of the devices
+  bool m_classAccessCategories;
+  /// DataExpireTime of each traffic class
+  std::vector<Time> m_classExpireTime;
   //\}
   
 };
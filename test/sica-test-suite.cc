@@ -2,6 +2,7 @@
 
 // Include a header file from your module to test.
 #include "ns3/sica.h"
+#include "ns3/sica-channel-oracle.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -46,6 +47,1865 @@ SicaTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Check the leakage between adjacent channels of the emulation layer
+class SicaAdjacentChannelTestCase : public TestCase
+{
+public:
+  SicaAdjacentChannelTestCase ();
+  virtual ~SicaAdjacentChannelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaAdjacentChannelTestCase::SicaAdjacentChannelTestCase ()
+  : TestCase ("Sica adjacent channel interference matrix")
+{
+}
+
+SicaAdjacentChannelTestCase::~SicaAdjacentChannelTestCase ()
+{
+}
+
+void
+SicaAdjacentChannelTestCase::DoRun (void)
+{
+  AdjacentChannelMatrix adj;
+  NS_TEST_ASSERT_MSG_EQ (adj.IsOrthogonal (), true, "An empty matrix must describe orthogonal channels");
+  NS_TEST_ASSERT_MSG_EQ_TOL (adj.GetCoupling (3, 3), 1, 1e-9, "A channel must fully see its own busy time");
+  NS_TEST_ASSERT_MSG_EQ_TOL (adj.GetCoupling (3, 4), 0, 1e-9, "Orthogonal channels must not leak");
+  adj.SetCoupling (1, 0.5);
+  adj.SetCoupling (2, 0.2);
+  NS_TEST_ASSERT_MSG_EQ (adj.GetMaxDistance (), 2, "Wrong maximum coupling distance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (adj.GetCoupling (3, 4), 0.5, 1e-9, "Wrong coupling for c+1");
+  NS_TEST_ASSERT_MSG_EQ_TOL (adj.GetCoupling (3, 1), 0.2, 1e-9, "Wrong coupling for c-2");
+  NS_TEST_ASSERT_MSG_EQ_TOL (adj.GetCoupling (1, 4), 0, 1e-9, "Channels three apart must not leak");
+}
+
+// Check the smoothing and the merge of the external bandwidth estimation
+class SicaBxEstimatorTestCase : public TestCase
+{
+public:
+  SicaBxEstimatorTestCase ();
+  virtual ~SicaBxEstimatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaBxEstimatorTestCase::SicaBxEstimatorTestCase ()
+  : TestCase ("Sica external bandwidth estimator")
+{
+}
+
+SicaBxEstimatorTestCase::~SicaBxEstimatorTestCase ()
+{
+}
+
+void
+SicaBxEstimatorTestCase::DoRun (void)
+{
+  SicaBxEstimator est;
+  est.SetParameters (SicaBxEstimator::EWMA_MODE, 0.5, 4, 0.3);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est.GetConfidence (), 0, 1e-9, "An empty estimator must have no confidence");
+  est.AddLocalSample (10, Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ_TOL (est.GetEstimate (), 10, 1e-2, "The first sample must initialize the estimate");
+  est.AddLocalSample (20, Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ_TOL (est.GetEstimate (), 15, 1e-2, "Wrong EWMA estimate");
+  double conf = est.GetConfidence ();
+  NS_TEST_ASSERT_MSG_GT (conf, 0, "A fresh estimate must have a confidence");
+  est.MergeNeighborReport (50, 0, Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ_TOL (est.GetEstimate (), 15, 1e-2, "A report without confidence must be ignored");
+  est.MergeNeighborReport (15 + 10, 1, Seconds (10));
+  double w = 0.3 + 0.7 * (1 - conf);
+  NS_TEST_ASSERT_MSG_EQ_TOL (est.GetEstimate (), 15 + 10 * w, 1e-2, "Wrong weight of the neighbor report");
+  NS_TEST_ASSERT_MSG_EQ (SicaBxEstimator::ToFixed (1.5), 384, "Wrong fixed point conversion");
+
+  SicaBxEstimator win;
+  win.SetParameters (SicaBxEstimator::WINDOW_MODE, 0.5, 2, 0.3);
+  win.AddLocalSample (10, Seconds (10));
+  win.AddLocalSample (20, Seconds (10));
+  win.AddLocalSample (40, Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ_TOL (win.GetEstimate (), 30, 1e-2, "The window must only keep the last samples");
+  win.Reset ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (win.GetEstimate (), 0, 1e-9, "A reset estimator must be empty");
+}
+
+// Check the selection of the channel to be scanned in background
+class SicaStaleChannelTestCase : public TestCase
+{
+public:
+  SicaStaleChannelTestCase ();
+  virtual ~SicaStaleChannelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaStaleChannelTestCase::SicaStaleChannelTestCase ()
+  : TestCase ("Sica selection of stale channels for background scanning")
+{
+}
+
+SicaStaleChannelTestCase::~SicaStaleChannelTestCase ()
+{
+}
+
+void
+SicaStaleChannelTestCase::DoRun (void)
+{
+  SicaChannels channels;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      channels.UpdateChannel (i, 11, 0, 0, 0, Seconds (400));
+    }
+  NS_TEST_ASSERT_MSG_EQ (channels.GetChannelSenseCount (1), 0, "A new channel must not be sensed");
+  NS_TEST_ASSERT_MSG_EQ (channels.GetChannelSenseAge (1), Time::Max (), "A channel never sensed must be the oldest");
+  channels.SetChannelExtBandwidth (1, 2, Seconds (400));
+  NS_TEST_ASSERT_MSG_EQ (channels.GetChannelSenseCount (1), 1, "The local sensing must be counted");
+  NS_TEST_ASSERT_MSG_EQ (channels.FindStaleChannel (Seconds (10), 0), 2, "The first channel never sensed must be selected");
+  NS_TEST_ASSERT_MSG_EQ (channels.FindStaleChannel (Seconds (10), 2), 3, "The excluded channel must not be selected");
+  channels.SetChannelExtBandwidth (2, 2, Seconds (400));
+  channels.SetChannelExtBandwidth (3, 2, Seconds (400));
+  NS_TEST_ASSERT_MSG_EQ (channels.FindStaleChannel (Seconds (10), 0), -1, "Fresh channels must not be scanned");
+}
+
+// Check that overlapping sense periods of several neighbors are merged
+class SicaSenseWindowTestCase : public TestCase
+{
+public:
+  SicaSenseWindowTestCase ();
+  virtual ~SicaSenseWindowTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaSenseWindowTestCase::SicaSenseWindowTestCase ()
+  : TestCase ("Sica sense windows of channels")
+{
+}
+
+SicaSenseWindowTestCase::~SicaSenseWindowTestCase ()
+{
+}
+
+void
+SicaSenseWindowTestCase::DoRun (void)
+{
+  SicaChannels channels;
+  channels.UpdateChannel (1, 11, 0, 0, 0, Seconds (400));
+  NS_TEST_ASSERT_MSG_EQ (channels.IsBeingSensed (1), false, "A new channel must not be sensed");
+  channels.AddSenseWindow (1, Seconds (0), Seconds (2));
+  NS_TEST_ASSERT_MSG_EQ (channels.IsBeingSensed (1), true, "The channel must be sensed inside a window");
+  // two neighbors announce overlapping windows, a third one a disjoint window
+  channels.AddSenseWindow (1, Seconds (5), Seconds (7));
+  channels.AddSenseWindow (1, Seconds (6), Seconds (8));
+  channels.AddSenseWindow (1, Seconds (10), Seconds (11));
+  NS_TEST_ASSERT_MSG_EQ (channels.GetSenseWindowCount (1), 3, "Overlapping windows must be merged");
+  channels.AddSenseWindow (1, Seconds (1), Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ (channels.GetSenseWindowCount (1), 1, "A window covering the others must merge all of them");
+  NS_TEST_ASSERT_MSG_EQ (channels.IsBeingSensed (1), true, "Merging must not remove the current window");
+  NS_TEST_ASSERT_MSG_EQ (channels.IsBeingSensed (2), false, "An unknown channel must not be sensed");
+}
+
+// Check that the channel weights stay normalized after many rounds of the game
+class SicaChannelWeightTestCase : public TestCase
+{
+public:
+  SicaChannelWeightTestCase ();
+  virtual ~SicaChannelWeightTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaChannelWeightTestCase::SicaChannelWeightTestCase ()
+  : TestCase ("Sica log-domain channel weights")
+{
+}
+
+SicaChannelWeightTestCase::~SicaChannelWeightTestCase ()
+{
+}
+
+void
+SicaChannelWeightTestCase::DoRun (void)
+{
+  SicaChannels channels;
+  std::vector<double> loss;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      channels.UpdateChannel (i, 11, 0, 0, 0, Seconds (400));
+      channels.SetChannelWeight (i, 1);
+      loss.push_back (0.5 + 0.1 * i);
+    }
+  channels.UpdateChannelWeights (std::log (0.7), loss, 1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (channels.GetChannelWeight (1), 1, 1e-9, "The channel with the lowest loss must have the biggest weight");
+  NS_TEST_ASSERT_MSG_EQ_TOL (channels.GetChannelWeight (2), std::pow (0.7, 0.1), 1e-9, "Wrong relative weight");
+  // the multiplicative update would underflow to 0 after so many rounds
+  for (uint32_t r = 0; r < 100000; r++)
+    {
+      channels.UpdateChannelWeights (std::log (0.7), loss, 1);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (channels.GetChannelWeight (1), 1, 1e-9, "The biggest weight must be normalized to 1");
+  NS_TEST_ASSERT_MSG_EQ (channels.GetChannelWeight (3) > 0, true, "A weight must never underflow to 0");
+  NS_TEST_ASSERT_MSG_EQ (channels.FindMaxWeightChannel (0), 1, "Wrong channel with the biggest weight");
+}
+
+// Check the alias table used to draw the channel of the decision game
+class SicaChannelSamplerTestCase : public TestCase
+{
+public:
+  SicaChannelSamplerTestCase ();
+  virtual ~SicaChannelSamplerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaChannelSamplerTestCase::SicaChannelSamplerTestCase ()
+  : TestCase ("Sica alias table channel sampler")
+{
+}
+
+SicaChannelSamplerTestCase::~SicaChannelSamplerTestCase ()
+{
+}
+
+void
+SicaChannelSamplerTestCase::DoRun (void)
+{
+  std::vector<uint32_t> channels;
+  std::vector<double> prob;
+  channels.push_back (3);
+  prob.push_back (0.5);
+  channels.push_back (1);
+  prob.push_back (0.25);
+  channels.push_back (2);
+  prob.push_back (0.25);
+  channels.push_back (4);
+  prob.push_back (0);
+  SicaChannelSampler sampler;
+  sampler.Build (channels, prob);
+  NS_TEST_ASSERT_MSG_EQ (sampler.GetN (), 4, "Wrong size of the alias table");
+  // the frequency of each channel over a fine grid of uniform numbers is its probability
+  std::map<uint32_t, uint32_t> count;
+  const uint32_t n = 10000;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      count[sampler.Sample ((i + 0.5) / n)]++;
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (count[3] / static_cast<double> (n), 0.5, 1e-3, "Wrong probability of channel 3");
+  NS_TEST_ASSERT_MSG_EQ_TOL (count[1] / static_cast<double> (n), 0.25, 1e-3, "Wrong probability of channel 1");
+  NS_TEST_ASSERT_MSG_EQ_TOL (count[2] / static_cast<double> (n), 0.25, 1e-3, "Wrong probability of channel 2");
+  NS_TEST_ASSERT_MSG_EQ (count[4], 0, "A channel with probability 0 must never be drawn");
+
+  // the same stream gives the same draws
+  Ptr<UniformRandomVariable> rng1 = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> rng2 = CreateObject<UniformRandomVariable> ();
+  rng1->SetStream (7);
+  rng2->SetStream (7);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (sampler.Sample (rng1), sampler.Sample (rng2), "Draws must be reproducible with a fixed stream");
+    }
+}
+
+// Check that every channel selection strategy favors the channel with the lowest loss
+class SicaChannelStrategyTestCase : public TestCase
+{
+public:
+  SicaChannelStrategyTestCase ();
+  virtual ~SicaChannelStrategyTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Run a few rounds of a strategy and return the weight of each channel
+  std::vector<double> RunStrategy (Ptr<SicaChannelSelectionStrategy> strategy, uint32_t current);
+};
+
+SicaChannelStrategyTestCase::SicaChannelStrategyTestCase ()
+  : TestCase ("Sica channel selection strategies")
+{
+}
+
+SicaChannelStrategyTestCase::~SicaChannelStrategyTestCase ()
+{
+}
+
+std::vector<double>
+SicaChannelStrategyTestCase::RunStrategy (Ptr<SicaChannelSelectionStrategy> strategy, uint32_t current)
+{
+  SicaChannels table;
+  SicaChannelObservation obs;
+  obs.totalNeighbors = 0;
+  obs.current = current;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      table.UpdateChannel (i, 11, 0, 0, 0, Seconds (400));
+      table.SetChannelWeight (i, 1);
+      obs.channels.push_back (i);
+      obs.loss.push_back (i == 2 ? 0.1 : 0.8);
+      obs.bx.push_back (0);
+      obs.neighbors.push_back (0);
+    }
+  for (uint32_t r = 0; r < 50; r++)
+    {
+      strategy->Update (obs, table);
+    }
+  std::vector<double> w;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      w.push_back (table.GetChannelWeight (i));
+    }
+  return w;
+}
+
+void
+SicaChannelStrategyTestCase::DoRun (void)
+{
+  std::vector<double> w = RunStrategy (CreateObject<SicaMultiplicativeWeightsStrategy> (), 1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (w[1], 1, 1e-9, "The game must give the biggest weight to the lowest loss");
+  NS_TEST_ASSERT_MSG_EQ_TOL (w[0], std::pow (0.7, 50 * 0.7), 1e-9, "Wrong weight of the game");
+
+  w = RunStrategy (CreateObject<SicaLeastLoadedStrategy> (), 1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (w[1], 1, 1e-9, "The greedy baseline must select the lowest loss");
+  NS_TEST_ASSERT_MSG_LT (w[0], 1e-100, "The greedy baseline must not select another channel");
+
+  w = RunStrategy (CreateObject<SicaRegretMatchingStrategy> (), 1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (w[1], 1, 1e-9, "Regret matching must move to the channel with a positive regret");
+  NS_TEST_ASSERT_MSG_LT (w[2], 1e-100, "A channel with a negative regret must not be selected");
+
+  // a bandit only learns the loss of the channel it plays
+  w = RunStrategy (CreateObject<SicaExp3Strategy> (), 1);
+  NS_TEST_ASSERT_MSG_LT (w[0], w[1], "EXP3 must decrease the weight of a channel with a high loss");
+  NS_TEST_ASSERT_MSG_EQ_TOL (w[1], w[2], 1e-9, "EXP3 must not change the weights of the channels not played");
+}
+
+// Check the convergence detection of the channel assignment
+class SicaConvergenceTestCase : public TestCase
+{
+public:
+  SicaConvergenceTestCase ();
+  virtual ~SicaConvergenceTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaConvergenceTestCase::SicaConvergenceTestCase ()
+  : TestCase ("Sica convergence monitor")
+{
+}
+
+SicaConvergenceTestCase::~SicaConvergenceTestCase ()
+{
+}
+
+void
+SicaConvergenceTestCase::DoRun (void)
+{
+  SicaConvergenceMonitor monitor;
+  monitor.SetParameters (0.05, 2);
+  std::vector<double> prob (2, 0.5);
+  NS_TEST_ASSERT_MSG_EQ (monitor.Update (prob, false), false, "The first round must not converge");
+  prob[0] = 0.51;
+  prob[1] = 0.49;
+  NS_TEST_ASSERT_MSG_EQ (monitor.Update (prob, false), false, "One stable round is not enough");
+  NS_TEST_ASSERT_MSG_EQ_TOL (monitor.GetLastChange (), 0.02, 1e-9, "Wrong L1 change");
+  NS_TEST_ASSERT_MSG_EQ (monitor.Update (prob, false), true, "Two stable rounds must converge");
+  NS_TEST_ASSERT_MSG_EQ (monitor.IsConverged (), true, "The monitor must be converged");
+  NS_TEST_ASSERT_MSG_EQ (monitor.Update (prob, true), true, "A switch must leave the converged state");
+  NS_TEST_ASSERT_MSG_GT (monitor.GetSwitchRate (), 0, "The switch must be counted");
+  monitor.Update (prob, false);
+  monitor.Update (prob, false);
+  NS_TEST_ASSERT_MSG_EQ (monitor.IsConverged (), true, "The monitor must converge again");
+  // a node which switches every third round oscillates
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      monitor.Update (prob, true);
+      monitor.Update (prob, false);
+      monitor.Update (prob, false);
+    }
+  NS_TEST_ASSERT_MSG_EQ (monitor.GetStableRounds (), 2, "The last rounds are stable");
+  NS_TEST_ASSERT_MSG_EQ (monitor.IsConverged (), false, "An oscillating node must not be converged");
+  monitor.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (monitor.IsConverged (), false, "A reset must restart the detection");
+}
+
+// Check the measurements feeding the load terms of the loss
+class SicaLoadTermsTestCase : public TestCase
+{
+public:
+  SicaLoadTermsTestCase ();
+  virtual ~SicaLoadTermsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaLoadTermsTestCase::SicaLoadTermsTestCase ()
+  : TestCase ("Sica load terms of the loss")
+{
+}
+
+SicaLoadTermsTestCase::~SicaLoadTermsTestCase ()
+{
+}
+
+void
+SicaLoadTermsTestCase::DoRun (void)
+{
+  SicaChannels channels;
+  channels.UpdateChannel (1, 11, 0, 0, 0, Seconds (400));
+  NS_TEST_ASSERT_MSG_EQ_TOL (channels.GetTxFailureRatio (1), 0, 1e-9, "A channel without transmission must not fail");
+  channels.RecordTxResult (1, true, 3);
+  channels.RecordTxResult (1, false);
+  NS_TEST_ASSERT_MSG_EQ_TOL (channels.GetTxFailureRatio (1), 0.25, 1e-9, "Wrong failure ratio");
+  channels.RecordTxResult (1, true, 200);
+  NS_TEST_ASSERT_MSG_LT (channels.GetTxFailureRatio (1), 0.01, "Old failures must fade out");
+
+  SicaNeighbors nb;
+  nb.Update (2, 1, 2, 1, Address (), Address (), Seconds (0), Seconds (0), 1);
+  nb.Update (3, 1, 2, 1, Address (), Address (), Seconds (0), Seconds (0), 1);
+  nb.Update (4, 1, 2, 2, Address (), Address (), Seconds (0), Seconds (0), 2);
+  nb.Update (5, 2, 1, 2, Address (), Address (), Seconds (0), Seconds (0), 2);
+  nb.SetNiLoad (2, 10);
+  nb.SetNiLoad (4, 30);
+  nb.SetNiLoad (5, 50);
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiLoadOnChannel (1), 10, "Wrong load on channel 1");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiLoadOnChannel (2), 30, "The load of a 2-hop neighbor must not be counted");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiLoadTotal (), 40, "Wrong total load");
+
+  SicaHelloHeader hello (1, 7, Seconds (0), 2, 3, 0, 3, Mac48Address ("00:00:00:00:00:07"));
+  hello.SetLoad (1234);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (hello);
+  SicaHelloHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetLoad (), 1234, "The load must be carried by the hello");
+}
+
+// Check the weights of the conflicts in the interference graph
+class SicaInterferenceGraphTestCase : public TestCase
+{
+public:
+  SicaInterferenceGraphTestCase ();
+  virtual ~SicaInterferenceGraphTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaInterferenceGraphTestCase::SicaInterferenceGraphTestCase ()
+  : TestCase ("Sica interference graph")
+{
+}
+
+SicaInterferenceGraphTestCase::~SicaInterferenceGraphTestCase ()
+{
+}
+
+void
+SicaInterferenceGraphTestCase::DoRun (void)
+{
+  SicaNeighbors nb;
+  nb.Update (2, 1, 2, 1, Address (), Address (), Seconds (0), Seconds (0), 1);
+  nb.Update (3, 1, 2, 2, Address (), Address (), Seconds (0), Seconds (0), 2);
+  nb.Update (4, 2, 1, 1, Address (), Address (), Seconds (0), Seconds (0), 1);
+  nb.Update (5, 2, 1, 2, Address (), Address (), Seconds (0), Seconds (0), 2);
+  std::set<uint32_t> path;
+  SicaInterferenceGraph graph;
+  graph.Build (nb, path);
+  NS_TEST_ASSERT_MSG_EQ (graph.GetVertexNo (), 4, "Every neighbor within two hops must be a vertex");
+  NS_TEST_ASSERT_MSG_EQ_TOL (graph.GetConflictFraction (1), 0.5, 1e-9, "Unit weights must give the fraction of neighbors");
+
+  graph.SetWeights (1, 0.5, 2);
+  path.insert (3);
+  graph.Build (nb, path);
+  NS_TEST_ASSERT_MSG_EQ_TOL (graph.GetConflictWeight (1), 1.5, 1e-9, "Wrong weight of the 1-hop and 2-hop conflicts");
+  NS_TEST_ASSERT_MSG_EQ_TOL (graph.GetConflictWeight (2), 2.5, 1e-9, "A neighbor on the path must weigh more");
+  NS_TEST_ASSERT_MSG_EQ_TOL (graph.GetConflictFraction (3), 0, 1e-9, "A free channel must not conflict");
+
+  Ptr<RTable> rTable = CreateObject<RTable> ();
+  rTable->MakeRoute (1, 9, 3, 1);
+  rTable->MakeRoute (1, 8, 3, 1);
+  rTable->MakeRoute (4, 9, 1, 1);
+  NS_TEST_ASSERT_MSG_EQ (rTable->GetNextHops (1).size (), 1, "Next hops must not be duplicated");
+  NS_TEST_ASSERT_MSG_EQ (rTable->GetPreviousHops (1).size (), 1, "Wrong previous hops");
+  NS_TEST_ASSERT_MSG_EQ (rTable->GetPreviousHops (1)[0], 4, "Wrong previous hop");
+}
+
+// Check that the oracle separates conflicting nodes and reports the gap with the game
+class SicaChannelOracleTestCase : public TestCase
+{
+public:
+  SicaChannelOracleTestCase ();
+  virtual ~SicaChannelOracleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaChannelOracleTestCase::SicaChannelOracleTestCase ()
+  : TestCase ("Sica centralized channel oracle")
+{
+}
+
+SicaChannelOracleTestCase::~SicaChannelOracleTestCase ()
+{
+}
+
+void
+SicaChannelOracleTestCase::DoRun (void)
+{
+  SicaChannelOracle oracle;
+  oracle.SetLossParameters (1, 3, 11, 0.5);
+  oracle.SetSearchParameters (4, 200, 2);
+  oracle.SetStream (1);
+  std::vector<double> bx (3, 0);
+  // a triangle of nodes all on channel 1, channel 3 is jammed for node 3
+  oracle.AddNode (1, 1, bx, 0);
+  oracle.AddNode (2, 1, bx, 0);
+  bx[2] = 11;
+  oracle.AddNode (3, 1, bx, 0);
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      for (uint32_t j = 1; j <= 3; j++)
+        {
+          oracle.AddConflict (i, j, 1);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (oracle.GetGameObjective (), 1.5, 1e-9, "Wrong objective of the game");
+  NS_TEST_ASSERT_MSG_EQ_TOL (oracle.Solve (), 0, 1e-9, "The oracle must find a conflict free assignment");
+  NS_TEST_ASSERT_MSG_NE (oracle.GetChannel (1), oracle.GetChannel (2), "Conflicting nodes must be separated");
+  NS_TEST_ASSERT_MSG_NE (oracle.GetChannel (3), 3, "The jammed channel must be avoided");
+  NS_TEST_ASSERT_MSG_EQ_TOL (oracle.GetGap (), 1, 1e-9, "Wrong gap");
+  NS_TEST_ASSERT_MSG_EQ (oracle.GetChannel (7), 0, "An unknown node has no channel");
+}
+
+// Check that the packets of a switching neighbor are moved to the queue of its new channel
+class SicaShuffleDataTestCase : public TestCase
+{
+public:
+  SicaShuffleDataTestCase ();
+  virtual ~SicaShuffleDataTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaShuffleDataTestCase::SicaShuffleDataTestCase ()
+  : TestCase ("Sica data shuffling after a neighbor switch")
+{
+}
+
+SicaShuffleDataTestCase::~SicaShuffleDataTestCase ()
+{
+}
+
+void
+SicaShuffleDataTestCase::DoRun (void)
+{
+  SicaQueue queue;
+  uint32_t dst[3] = {5, 6, 5};
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (10);
+      p->AddHeader (SicaHeader (i + 1, 1, dst[i], dst[i], Seconds (0)));
+      SicaQueueEntry ent (p, SicaQueueEntry::Data_Type);
+      ent.SetExpireTime (Seconds (10));
+      queue.Enqueue (1, &ent);
+    }
+  // the queue of channel 3 does not exist yet
+  NS_TEST_ASSERT_MSG_EQ (queue.ShuffleData (1, 3, 5), 2, "Both packets of the neighbor must be moved");
+  NS_TEST_ASSERT_MSG_EQ (queue.GetSize (3, SicaQueueEntry::Data_Type), 2, "The moved packets must be in the new queue");
+  NS_TEST_ASSERT_MSG_EQ (queue.GetSize (1, SicaQueueEntry::Data_Type), 1, "The packet of the other neighbor must stay");
+  NS_TEST_ASSERT_MSG_EQ (queue.ShuffleData (1, 3, 5), 0, "Nothing is left to move");
+}
+
+class SicaTransmitHoldTestCase : public TestCase
+{
+public:
+  SicaTransmitHoldTestCase ();
+  virtual ~SicaTransmitHoldTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaTransmitHoldTestCase::SicaTransmitHoldTestCase ()
+  : TestCase ("Sica transmit hold for switching next hops")
+{
+}
+
+SicaTransmitHoldTestCase::~SicaTransmitHoldTestCase ()
+{
+}
+
+void
+SicaTransmitHoldTestCase::DoRun (void)
+{
+  SicaQueue queue;
+  // packets to the destinations 8 and 9 relayed by the next hops 5 and 6
+  uint32_t dst[3] = {8, 9, 8};
+  uint32_t nextHop[3] = {5, 6, 6};
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (10);
+      p->AddHeader (SicaHeader (i + 1, 1, dst[i], nextHop[i], Seconds (0)));
+      SicaQueueEntry ent (p, SicaQueueEntry::Data_Type);
+      ent.SetExpireTime (Seconds (10));
+      queue.Enqueue (1, &ent);
+    }
+  SicaHeader sHeader;
+  queue.FindQueueEntryForNextHop (1, 6)->GetPacket ()->PeekHeader (sHeader);
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetDest (), 9, "The earliest packet relayed by node 6 must be found");
+  std::set<uint32_t> held;
+  held.insert (5);
+  SicaQueueEntry *ent = queue.DequeueSkipping (1, held);
+  NS_TEST_ASSERT_MSG_NE (ent, 0, "The packets of the other next hop must be sent");
+  ent->GetPacket ()->PeekHeader (sHeader);
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetNextHop (), 6, "The packet of the held next hop must be skipped");
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetSeqNo (), 2, "The earliest sendable packet must be sent first");
+  delete ent;
+  NS_TEST_ASSERT_MSG_EQ (queue.GetSize (1, SicaQueueEntry::Data_Type), 2, "The sent packet must leave the queue");
+  held.insert (6);
+  NS_TEST_ASSERT_MSG_EQ (queue.DequeueSkipping (1, held), 0, "Nothing must be sent when every next hop is held");
+  // the packets follow the next hop, not the final destination
+  NS_TEST_ASSERT_MSG_EQ (queue.ShuffleData (1, 2, 8), 0, "The destination must not be used to shuffle");
+  NS_TEST_ASSERT_MSG_EQ (queue.ShuffleData (1, 2, 5), 1, "The packet relayed by the switching next hop must be moved");
+  NS_TEST_ASSERT_MSG_EQ (queue.GetSize (1, SicaQueueEntry::Data_Type), 1, "The packet of the other next hop must stay");
+}
+
+class SicaSwitchAnnouncementTestCase : public TestCase
+{
+public:
+  SicaSwitchAnnouncementTestCase ();
+  virtual ~SicaSwitchAnnouncementTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaSwitchAnnouncementTestCase::SicaSwitchAnnouncementTestCase ()
+  : TestCase ("Sica switch announcement frame")
+{
+}
+
+SicaSwitchAnnouncementTestCase::~SicaSwitchAnnouncementTestCase ()
+{
+}
+
+void
+SicaSwitchAnnouncementTestCase::DoRun (void)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (SicaSwitchHeader (7, 3, 2, 5, MicroSeconds (1500)));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 14, "The switch announcement must be compact");
+  SicaQueue queue;
+  SicaQueueEntry ent (p, SicaQueueEntry::Switch_Type);
+  ent.SetExpireTime (Seconds (1));
+  queue.Enqueue (2, &ent);
+  NS_TEST_ASSERT_MSG_EQ (queue.GetSize (2, SicaQueueEntry::Hello_Type), 1, "The announcement must share the queue of the hello messages");
+  NS_TEST_ASSERT_MSG_EQ (queue.GetSize (2, SicaQueueEntry::Data_Type), 0, "The announcement must not be queued as data");
+  SicaQueueEntry *qEntry = queue.Dequeue (2, SicaQueueEntry::Hello_Type);
+  NS_TEST_ASSERT_MSG_EQ (qEntry->GetPacketType (), SicaQueueEntry::Switch_Type, "The type of the announcement must be kept in the queue");
+  SicaSwitchHeader sHeader;
+  qEntry->GetPacket ()->RemoveHeader (sHeader);
+  delete qEntry;
+  NS_TEST_ASSERT_MSG_EQ (sHeader.IsValid (), true, "The announcement must be valid");
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetSeqNo (), 7, "Wrong sequence number");
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetOrigin (), 3, "Wrong originator");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (sHeader.GetRChannel ()), 2, "Wrong current channel");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (sHeader.GetRNewChannel ()), 5, "Wrong new channel");
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetTimeToSwitch (), MicroSeconds (1500), "The time to switch must keep a microsecond resolution");
+}
+
+class SicaHelloDeltaTestCase : public TestCase
+{
+public:
+  SicaHelloDeltaTestCase ();
+  virtual ~SicaHelloDeltaTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaHelloDeltaTestCase::SicaHelloDeltaTestCase ()
+  : TestCase ("Sica incremental hello")
+{
+}
+
+SicaHelloDeltaTestCase::~SicaHelloDeltaTestCase ()
+{
+}
+
+void
+SicaHelloDeltaTestCase::DoRun (void)
+{
+  SicaHelloHeader prev (1, 7, MilliSeconds (1000), 2, 3, 512, 3, Mac48Address ("00:00:00:00:00:07"), MilliSeconds (500), MilliSeconds (0));
+  prev.SetVersion (4);
+  prev.SetLoad (10);
+  prev.AddNiRChannel (2, 1);
+  prev.AddNiRChannel (3, 1);
+  prev.AddNiRChannel (4, 2);
+  // 100ms later: neighbor 3 moved, neighbor 4 left, neighbor 5 arrived, the switch timer only ran
+  SicaHelloHeader cur (2, 7, MilliSeconds (1100), 2, 3, 512, 3, Mac48Address ("00:00:00:00:00:07"), MilliSeconds (400), MilliSeconds (0));
+  cur.SetVersion (5);
+  cur.SetLoad (10);
+  cur.AddNiRChannel (2, 1);
+  cur.AddNiRChannel (3, 5);
+  cur.AddNiRChannel (5, 4);
+  SicaHelloDeltaHeader delta = SicaHelloDeltaHeader::Diff (prev, cur);
+  NS_TEST_ASSERT_MSG_EQ (delta.GetFields (), 0, "Nothing but the neighbors changed");
+  NS_TEST_ASSERT_MSG_EQ (delta.GetChangeNo (), 3, "Only the changed neighbors must be carried");
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (delta);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 17 + 3 * 5, "Wrong size of the incremental hello");
+  NS_TEST_ASSERT_MSG_LT (p->GetSize (), cur.GetSerializedSize (), "The incremental hello must be smaller than the full one");
+  SicaHelloDeltaHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetVersion (), 5, "Wrong version");
+  received.Apply (prev);
+  NS_TEST_ASSERT_MSG_EQ (prev.GetSeqNo (), 2, "Wrong sequence number");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetVersion (), 5, "The state must take the new version");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetNiNo (), 3, "Wrong number of neighbors");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetNiRChannel (3), 5, "The moved neighbor must be updated");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetNiRChannel (4), -1, "The removed neighbor must be deleted");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetNiRChannel (5), 4, "The new neighbor must be added");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetTimeToSwitch (), MilliSeconds (400), "The switch timer must run without being sent");
+  // a change of the interference and of the channel decision
+  cur.SetExtBw (1024);
+  cur.SetRNewChannel (6);
+  cur.SetOriginTime (MilliSeconds (1200));
+  cur.SetTimeToSwitch (MilliSeconds (50));
+  delta = SicaHelloDeltaHeader::Diff (prev, cur);
+  NS_TEST_ASSERT_MSG_EQ (delta.GetFields (), SicaHelloDeltaHeader::CHANNEL_FIELD | SicaHelloDeltaHeader::BX_FIELD | SicaHelloDeltaHeader::SWITCH_FIELD, "Wrong changed fields");
+  NS_TEST_ASSERT_MSG_EQ (delta.GetChangeNo (), 0, "The neighbors did not change");
+  delta.Apply (prev);
+  NS_TEST_ASSERT_MSG_EQ (prev.GetExtBw (), 1024, "Wrong external bandwidth");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (prev.GetRNewChannel ()), 6, "Wrong new channel");
+  NS_TEST_ASSERT_MSG_EQ (prev.GetTimeToSwitch (), MilliSeconds (50), "Wrong switch timer");
+}
+
+// Check the hello interval advertised by the adaptive hello scheduler and the lifetime of the neighbors
+class SicaAdaptiveHelloTestCase : public TestCase
+{
+public:
+  SicaAdaptiveHelloTestCase ();
+  virtual ~SicaAdaptiveHelloTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaAdaptiveHelloTestCase::SicaAdaptiveHelloTestCase ()
+  : TestCase ("Sica adaptive hello")
+{
+}
+
+SicaAdaptiveHelloTestCase::~SicaAdaptiveHelloTestCase ()
+{
+}
+
+void
+SicaAdaptiveHelloTestCase::DoRun (void)
+{
+  SicaHelloHeader prev (1, 7, MilliSeconds (1000), 2, 3, 512, 3, Mac48Address ("00:00:00:00:00:07"), MilliSeconds (500), MilliSeconds (0));
+  prev.SetHelloInterval (Seconds (1));
+  SicaHelloHeader cur = prev;
+  cur.SetHelloInterval (Seconds (4));
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (cur);
+  SicaHelloHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetHelloInterval (), Seconds (4), "The hello interval must be carried by the hello");
+  SicaHelloDeltaHeader delta = SicaHelloDeltaHeader::Diff (prev, cur);
+  NS_TEST_ASSERT_MSG_EQ (delta.GetFields (), SicaHelloDeltaHeader::INTERVAL_FIELD, "Only the interval changed");
+  delta.Apply (prev);
+  NS_TEST_ASSERT_MSG_EQ (prev.GetHelloInterval (), Seconds (4), "The incremental hello must carry the interval");
+
+  // both neighbors were heard 5s ago, only the first one advertised a long interval
+  SicaNeighbors nb;
+  nb.Update (2, 1, 2, 1, Address (), Address (), Seconds (-5), Seconds (0), 1);
+  nb.Update (3, 1, 2, 1, Address (), Address (), Seconds (-5), Seconds (0), 1);
+  nb.Update (4, 2, 1, 1, Address (), Address (), Seconds (-5), Seconds (0), 1);
+  nb.SetNiLifetime (2, 2 * Seconds (4));
+  nb.RmvExpiredNi (Seconds (3));
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiNo (), 1, "Only the neighbor with a long interval must be kept");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiChannel (2), 1, "The neighbor must not expire between two of its hellos");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiChannel (3), -1, "The neighbor must expire");
+}
+
+// Check that the full and the compact hello formats carry the same information
+class SicaCompactHelloTestCase : public TestCase
+{
+public:
+  SicaCompactHelloTestCase ();
+  virtual ~SicaCompactHelloTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Serialize and deserialize a hello in the given format, return the size of the packet
+  uint32_t RoundTrip (SicaHelloHeader hello, uint8_t format, SicaHelloHeader &received);
+};
+
+SicaCompactHelloTestCase::SicaCompactHelloTestCase ()
+  : TestCase ("Sica compact hello")
+{
+}
+
+SicaCompactHelloTestCase::~SicaCompactHelloTestCase ()
+{
+}
+
+uint32_t
+SicaCompactHelloTestCase::RoundTrip (SicaHelloHeader hello, uint8_t format, SicaHelloHeader &received)
+{
+  hello.SetFormat (format);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (hello);
+  p->RemoveHeader (received);
+  return received.GetSerializedSize ();
+}
+
+void
+SicaCompactHelloTestCase::DoRun (void)
+{
+  SicaHelloHeader hello (300, 7, MilliSeconds (123456), 2, 3, 512, 6, Mac48Address ("00:00:00:00:00:07"), MilliSeconds (1500), MilliSeconds (250));
+  hello.SetExtBwConfidence (0.5);
+  hello.SetLoad (1000);
+  hello.SetVersion (9);
+  hello.SetHelloInterval (Seconds (2));
+  hello.SetCLCPF (2.375);
+  hello.SetTTL (3);
+  hello.AddNiRChannel (70000, 4);
+  hello.AddNiRChannel (2, 1);
+  hello.AddNiRChannel (130, 5);
+  uint8_t formats[2] = {SicaHelloHeader::FULL_FORMAT, SicaHelloHeader::COMPACT_FORMAT};
+  uint32_t sizes[2];
+  for (uint32_t f = 0; f < 2; ++f)
+    {
+      SicaHelloHeader received;
+      sizes[f] = RoundTrip (hello, formats[f], received);
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetFormat ()), static_cast<uint32_t> (formats[f]), "Wrong format");
+      NS_TEST_ASSERT_MSG_EQ (received.GetSeqNo (), 300, "Wrong sequence number");
+      NS_TEST_ASSERT_MSG_EQ (received.GetOrigin (), 7, "Wrong originator");
+      NS_TEST_ASSERT_MSG_EQ (received.GetOriginTime (), MilliSeconds (123456), "Wrong origin time");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRadios ()), 2, "Wrong number of radios");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRChannel ()), 3, "Wrong channel");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRNewChannel ()), 6, "Wrong new channel");
+      NS_TEST_ASSERT_MSG_EQ (received.GetExtBw (), 512, "Wrong external bandwidth");
+      NS_TEST_ASSERT_MSG_EQ_TOL (received.GetExtBwConfidence (), 0.5, 0.01, "Wrong confidence");
+      NS_TEST_ASSERT_MSG_EQ (received.GetLoad (), 1000, "Wrong load");
+      NS_TEST_ASSERT_MSG_EQ (received.GetVersion (), 9, "Wrong version");
+      NS_TEST_ASSERT_MSG_EQ (received.GetRAddress (), Address (Mac48Address ("00:00:00:00:00:07")), "Wrong address");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTimeToSwitch (), MilliSeconds (1500), "Wrong switch time");
+      NS_TEST_ASSERT_MSG_EQ (received.GetSenseTime (), MilliSeconds (250), "Wrong sense time");
+      NS_TEST_ASSERT_MSG_EQ (received.GetHelloInterval (), Seconds (2), "Wrong hello interval");
+      NS_TEST_ASSERT_MSG_EQ_TOL (received.GetCLCPF (), 2.375, 0.001, "Wrong CLCPF");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTTL (), 3, "Wrong TTL");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetNiNo ()), 3, "Wrong number of neighbors");
+      NS_TEST_ASSERT_MSG_EQ (received.GetNiRChannel (70000), 4, "Wrong neighbor channel");
+      NS_TEST_ASSERT_MSG_EQ (received.GetNiRChannel (130), 5, "Wrong neighbor channel");
+      std::pair<uint32_t, uint8_t> ni;
+      received.RemoveNiRChannel (ni);
+      NS_TEST_ASSERT_MSG_EQ (ni.first, 2, "The neighbors must be sorted by ID");
+    }
+  NS_TEST_ASSERT_MSG_EQ (sizes[0], 50 + 6 + 3 * 5, "Wrong size of the full hello");
+  NS_TEST_ASSERT_MSG_EQ (sizes[1], 45, "Wrong size of the compact hello");
+
+  // a hello without address, switch and optional fields
+  SicaHelloHeader bare (1, 7, MilliSeconds (10), 1, 3, 0, 3);
+  for (uint32_t f = 0; f < 2; ++f)
+    {
+      SicaHelloHeader received;
+      uint32_t size = RoundTrip (bare, formats[f], received);
+      NS_TEST_ASSERT_MSG_EQ (received.GetRAddress ().GetLength (), 0, "The empty address must be carried");
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRNewChannel ()), 3, "No switch is scheduled");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTTL (), 1, "Wrong default TTL");
+      if (formats[f] == SicaHelloHeader::COMPACT_FORMAT)
+        NS_TEST_ASSERT_MSG_EQ (size, 8, "Only the mandatory fields must be sent");
+    }
+}
+
+// Check the hellos which carry one part of the neighbors
+class SicaHelloPartsTestCase : public TestCase
+{
+public:
+  SicaHelloPartsTestCase ();
+  virtual ~SicaHelloPartsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaHelloPartsTestCase::SicaHelloPartsTestCase ()
+  : TestCase ("Sica hello parts")
+{
+}
+
+SicaHelloPartsTestCase::~SicaHelloPartsTestCase ()
+{
+}
+
+void
+SicaHelloPartsTestCase::DoRun (void)
+{
+  SicaHelloHeader hello (1, 7, MilliSeconds (10), 2, 3, 0, 3, Mac48Address ("00:00:00:00:00:07"));
+  for (uint32_t n = 0; n < 300; ++n)
+    hello.AddNiRChannel (1000 - 3 * n, 1 + n % 11);
+  NS_TEST_ASSERT_MSG_EQ (hello.GetNiNo (), 300, "More than 255 neighbors must be kept");
+  uint8_t formats[2] = {SicaHelloHeader::FULL_FORMAT, SicaHelloHeader::COMPACT_FORMAT};
+  for (uint32_t f = 0; f < 2; ++f)
+    {
+      uint32_t carried = 0;
+      for (uint32_t part = 0; part < 2; ++part)
+        {
+          SicaHelloHeader sent = hello;
+          sent.SetFormat (formats[f]);
+          sent.KeepNiRange (part * 150, 150);
+          sent.SetPart (part, 2);
+          Ptr<Packet> p = Create<Packet> ();
+          p->AddHeader (sent);
+          SicaHelloHeader received;
+          p->RemoveHeader (received);
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetPart ()), part, "Wrong part");
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetParts ()), 2, "Wrong number of parts");
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetFlags () & SicaHelloHeader::MULTI_PART), static_cast<uint32_t> (SicaHelloHeader::MULTI_PART), "The hello must be marked as a part");
+          NS_TEST_ASSERT_MSG_EQ (received.GetNiNo (), 150, "Wrong number of neighbors in the part");
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRChannel ()), 3, "Each part must carry the state of the originator");
+          std::pair<uint32_t, uint8_t> ni;
+          while (received.RemoveNiRChannel (ni))
+            {
+              NS_TEST_ASSERT_MSG_EQ (static_cast<int32_t> (ni.second), hello.GetNiRChannel (ni.first), "Wrong neighbor in the part");
+              carried++;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (carried, 300, "The parts must carry all the neighbors");
+    }
+  hello.SetPart (0, 1);
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (hello.GetFlags ()), 0, "A single part is a complete hello");
+}
+
+// Check the state trailer piggybacked on the data packets
+class SicaStateTrailerTestCase : public TestCase
+{
+public:
+  SicaStateTrailerTestCase ();
+  virtual ~SicaStateTrailerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaStateTrailerTestCase::SicaStateTrailerTestCase ()
+  : TestCase ("Sica state trailer on data packets")
+{
+}
+
+SicaStateTrailerTestCase::~SicaStateTrailerTestCase ()
+{
+}
+
+void
+SicaStateTrailerTestCase::DoRun (void)
+{
+  SicaHeader plain (5, 1, 9, 4, MilliSeconds (300));
+  NS_TEST_ASSERT_MSG_EQ (plain.HasStateTrailer (), false, "The trailer is optional");
+  NS_TEST_ASSERT_MSG_EQ (plain.GetSerializedSize (), 21, "Wrong size of the data header");
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (plain);
+  SicaHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.HasStateTrailer (), false, "No trailer was sent");
+  NS_TEST_ASSERT_MSG_EQ (received.GetNextHop (), 4, "Wrong next hop");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "The payload must not be consumed");
+
+  SicaHeader trailer = plain;
+  trailer.SetStateTrailer (3, 6, MilliSeconds (250), 512, 0.8);
+  NS_TEST_ASSERT_MSG_EQ (trailer.GetSerializedSize (), 30, "Wrong size of the data header with the trailer");
+  p->AddHeader (trailer);
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.HasStateTrailer (), true, "The trailer was sent");
+  NS_TEST_ASSERT_MSG_EQ (received.GetDest (), 9, "Wrong destination");
+  NS_TEST_ASSERT_MSG_EQ (received.GetOriginTime (), MilliSeconds (300), "Wrong origin time");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRChannel ()), 3, "Wrong channel");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetRNewChannel ()), 6, "Wrong new channel");
+  NS_TEST_ASSERT_MSG_EQ (received.GetTimeToSwitch (), MilliSeconds (250), "Wrong switch time");
+  NS_TEST_ASSERT_MSG_EQ (received.GetExtBw (), 512, "Wrong external bandwidth");
+  NS_TEST_ASSERT_MSG_EQ_TOL (received.GetExtBwConfidence (), 0.8, 0.005, "Wrong confidence");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "The payload must not be consumed");
+}
+
+// Check the link quality (ETX) of the neighbors and its use by the routing table
+class SicaLinkQualityTestCase : public TestCase
+{
+public:
+  SicaLinkQualityTestCase ();
+  virtual ~SicaLinkQualityTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Link cost of the routing test, node 3 is not a neighbor
+  static double LinkCost (uint32_t niId);
+};
+
+SicaLinkQualityTestCase::SicaLinkQualityTestCase ()
+  : TestCase ("Sica link quality")
+{
+}
+
+SicaLinkQualityTestCase::~SicaLinkQualityTestCase ()
+{
+}
+
+double
+SicaLinkQualityTestCase::LinkCost (uint32_t niId)
+{
+  if (niId == 3)
+    return -1;
+  return (niId == 1 ? 4 : 1.5);
+}
+
+void
+SicaLinkQualityTestCase::DoRun (void)
+{
+  SicaNeighbors nb;
+  nb.Update (5, 1, 2, 3, Mac48Address ("00:00:00:00:00:05"), Mac48Address ("00:00:00:00:00:06"), Seconds (0), Seconds (0), 3);
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiReverseRatio (5), -1, "No hello counted yet");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiEtx (5), 1, "A link without information costs one transmission");
+  uint32_t seqs[4] = {1, 2, 4, 5};
+  for (uint32_t k = 0; k < 4; ++k)
+    nb.RecordNiHello (5, seqs[k]);
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiReverseRatio (5), 0.8, 1e-9, "One hello of five is missing");
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiEtx (5), 1 / 0.64, 1e-9, "Without report the link is symmetric");
+  nb.RecordNiHello (5, 3);
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiReverseRatio (5), 1, 1e-9, "A late hello fills the gap");
+  nb.SetNiForwardRatio (5, 0.5);
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiEtx (5), 2, 1e-9, "Wrong ETX from the hello ratios");
+  nb.SetLinkWindow (4);
+  nb.RecordNiHello (5, 10);
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiReverseRatio (5), 0.25, 1e-9, "Only the window counts");
+  nb.RecordNiTx (5, true, 3);
+  nb.RecordNiTx (5, false, 1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiEtx (5), 4.0 / 3, 1e-9, "The data attempts give the ETX");
+  NS_TEST_ASSERT_MSG_EQ_TOL (nb.GetNiLinkLossOnChannel (3), 0.25, 1e-9, "Wrong link loss of the channel");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiLinkLossOnChannel (4), 0, "No link on the channel");
+  nb.RecordNiTx (5, false, 60);
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiEtx (5) > 10, true, "A lossy link must be expensive");
+  NS_TEST_ASSERT_MSG_EQ (nb.GetNiEtx (9) < 0, true, "Not a neighbor");
+
+  // the hello carries the delivery ratio of each neighbor
+  SicaHelloHeader hello (1, 7, MilliSeconds (10), 2, 3, 0, 3, Mac48Address ("00:00:00:00:00:07"));
+  hello.AddNiRChannel (5, 3);
+  hello.AddNiRChannel (9, 4);
+  NS_TEST_ASSERT_MSG_EQ (hello.GetNiQuality (5), -1, "The link quality is optional");
+  uint32_t plainSize = hello.GetSerializedSize ();
+  hello.SetNiQuality (5, 0.6);
+  uint8_t formats[2] = {SicaHelloHeader::FULL_FORMAT, SicaHelloHeader::COMPACT_FORMAT};
+  for (uint32_t f = 0; f < 2; ++f)
+    {
+      hello.SetFormat (formats[f]);
+      if (f == 0)
+        NS_TEST_ASSERT_MSG_EQ (hello.GetSerializedSize (), plainSize + 2, "One byte per neighbor");
+      Ptr<Packet> p = Create<Packet> ();
+      p->AddHeader (hello);
+      SicaHelloHeader received;
+      p->RemoveHeader (received);
+      NS_TEST_ASSERT_MSG_EQ_TOL (received.GetNiQuality (5), 0.6, 0.005, "Wrong link quality");
+      NS_TEST_ASSERT_MSG_EQ (received.GetNiQuality (9), -1, "The neighbor has no measure");
+      NS_TEST_ASSERT_MSG_EQ (received.GetNiRChannel (9), 4, "Wrong neighbor");
+    }
+
+  // the alternative routes are ordered by the metric plus the link cost
+  Ptr<RTable> rTable = CreateObject<RTable> ();
+  rTable->AddRoute (0, 8, 1, 2);
+  rTable->AddRoute (0, 8, 2, 3);
+  rTable->AddRoute (0, 8, 3, 1);
+  NS_TEST_ASSERT_MSG_EQ (rTable->FindNextHop (0, 8), 3, "Without link cost the last route wins");
+  NS_TEST_ASSERT_MSG_EQ (rTable->FindNextHop (0, 8, MakeCallback (&SicaLinkQualityTestCase::LinkCost)), 2, "The lossy link must be avoided");
+  rTable->AddRoute (0, 8, 1, 0);
+  NS_TEST_ASSERT_MSG_EQ (rTable->FindNextHop (0, 8, MakeCallback (&SicaLinkQualityTestCase::LinkCost)), 1, "The metric is updated");
+  NS_TEST_ASSERT_MSG_EQ (rTable->FindNextHop (0, 9, MakeCallback (&SicaLinkQualityTestCase::LinkCost)), -1, "No route");
+}
+
+// Check the traffic classes of the data queues and their scheduling
+class SicaTrafficClassTestCase : public TestCase
+{
+public:
+  SicaTrafficClassTestCase ();
+  virtual ~SicaTrafficClassTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Queue one data packet of the given class and sequence number on channel 1
+  void EnqueueData (SicaQueue &queue, uint32_t seqNo, uint8_t tc);
+  /// Send the next data packet of channel 1 and return its class
+  uint32_t SendNext (SicaQueue &queue);
+};
+
+SicaTrafficClassTestCase::SicaTrafficClassTestCase ()
+  : TestCase ("Sica traffic classes of the data queues")
+{
+}
+
+SicaTrafficClassTestCase::~SicaTrafficClassTestCase ()
+{
+}
+
+void
+SicaTrafficClassTestCase::EnqueueData (SicaQueue &queue, uint32_t seqNo, uint8_t tc)
+{
+  Ptr<Packet> p = Create<Packet> (10);
+  SicaHeader sHeader (seqNo, 1, 8, 5, Seconds (0));
+  sHeader.SetTrafficClass (tc);
+  p->AddHeader (sHeader);
+  SicaQueueEntry ent (p, SicaQueueEntry::Data_Type);
+  ent.SetExpireTime (Seconds (10));
+  queue.Enqueue (1, &ent);
+}
+
+uint32_t
+SicaTrafficClassTestCase::SendNext (SicaQueue &queue)
+{
+  SicaQueueEntry *ent = queue.Dequeue (1, SicaQueueEntry::Data_Type);
+  if (!ent)
+    return 255;
+  SicaHeader sHeader;
+  ent->GetPacket ()->PeekHeader (sHeader);
+  delete ent;
+  queue.EraseFront (1, SicaQueueEntry::Data_Type);
+  return sHeader.GetTrafficClass ();
+}
+
+void
+SicaTrafficClassTestCase::DoRun (void)
+{
+  SicaHeader sHeader (5, 1, 9, 4, MilliSeconds (300));
+  sHeader.SetTrafficClass (3);
+  sHeader.SetStateTrailer (3, 6, MilliSeconds (250), 512, 0.8);
+  NS_TEST_ASSERT_MSG_EQ (sHeader.GetSerializedSize (), 30, "The class does not change the size of the header");
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (sHeader);
+  SicaHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (received.GetTrafficClass ()), 3, "Wrong traffic class");
+  NS_TEST_ASSERT_MSG_EQ (received.HasStateTrailer (), true, "The class must not hide the trailer");
+
+  // strict priority serves the highest class first and keeps the order inside a class
+  SicaQueue strict;
+  strict.SetTrafficClasses (3, SicaQueue::STRICT_PRIORITY);
+  uint8_t classes[5] = {0, 2, 1, 0, 7};
+  for (uint32_t i = 0; i < 5; i++)
+    EnqueueData (strict, i + 1, classes[i]);
+  NS_TEST_ASSERT_MSG_EQ (strict.GetSize (1, SicaQueueEntry::Data_Type), 5, "Every class counts in the size of the queue");
+  NS_TEST_ASSERT_MSG_EQ (strict.GetClassSize (1, 2), 2, "The classes above the highest one are served as the highest one");
+  SicaQueueEntry *ent = strict.FindQueueEntryForNextHop (1, 5);
+  NS_TEST_ASSERT_MSG_NE (ent, 0, "The packets of the next hop must be found");
+  ent->GetPacket ()->PeekHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetSeqNo (), 2, "The highest class must be searched first");
+  uint32_t expected[5] = {2, 7, 1, 0, 0};
+  for (uint32_t i = 0; i < 5; i++)
+    NS_TEST_ASSERT_MSG_EQ (SendNext (strict), expected[i], "Wrong order of the strict priority");
+  NS_TEST_ASSERT_MSG_EQ (strict.GetSize (1, SicaQueueEntry::Data_Type), 0, "Every packet must be sent");
+
+  // class 1 sends two packets per round and class 0 one
+  SicaQueue weighted;
+  weighted.SetTrafficClasses (2, SicaQueue::WEIGHTED);
+  weighted.SetClassWeight (1, 2);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      EnqueueData (weighted, 2 * i + 1, 0);
+      EnqueueData (weighted, 2 * i + 2, 1);
+    }
+  uint32_t rounds[6] = {0, 1, 1, 0, 1, 0};
+  for (uint32_t i = 0; i < 6; i++)
+    NS_TEST_ASSERT_MSG_EQ (SendNext (weighted), rounds[i], "Wrong order of the weighted scheduling");
+  NS_TEST_ASSERT_MSG_EQ (SendNext (weighted), 255, "Nothing is left to send");
+
+  // the held next hops are skipped in the order of the scheduler
+  EnqueueData (strict, 10, 0);
+  EnqueueData (strict, 11, 2);
+  std::set<uint32_t> held;
+  ent = strict.DequeueSkipping (1, held);
+  NS_TEST_ASSERT_MSG_NE (ent, 0, "The packets must be sent");
+  ent->GetPacket ()->PeekHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetSeqNo (), 11, "The highest class must be sent first");
+  delete ent;
+
+  // the access categories go from best effort to voice
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (SicaQueue::GetClassUserPriority (0, 1)), 0, "A single class is best effort");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (SicaQueue::GetClassUserPriority (1, 2)), 6, "The highest class is voice");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (SicaQueue::GetClassUserPriority (1, 3)), 5, "The middle class is video");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (SicaQueue::GetClassUserPriority (0, 4)), 0, "The lowest class is best effort");
+}
+
+// Check the busy time accounting of the phy sensing backend
+class SicaPhySensorTestCase : public TestCase
+{
+public:
+  SicaPhySensorTestCase ();
+  virtual ~SicaPhySensorTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Check the busy time in the middle of the first busy period
+  void CheckFirstPeriod (void);
+  /// Start a reception and leave the channel before its end
+  void SwitchDuringRx (void);
+  /// Check the busy time of both channels
+  void CheckChannels (void);
+  Ptr<YansWifiPhy> m_phy;
+  SicaPhySensor m_sensor;
+};
+
+SicaPhySensorTestCase::SicaPhySensorTestCase ()
+  : TestCase ("Sica phy sensor busy time")
+{
+}
+
+SicaPhySensorTestCase::~SicaPhySensorTestCase ()
+{
+}
+
+void
+SicaPhySensorTestCase::CheckFirstPeriod (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_sensor.IsBusy (), true, "The overlapping periods must be merged");
+  NS_TEST_EXPECT_MSG_EQ (m_sensor.GetBusyTime (1), MilliSeconds (1), "The elapsed part of the period must count");
+}
+
+void
+SicaPhySensorTestCase::SwitchDuringRx (void)
+{
+  m_sensor.NotifyRxStart (MilliSeconds (1));
+  Simulator::Schedule (MicroSeconds (500), &SicaPhySensor::NotifySwitchingStart, &m_sensor, MicroSeconds (300));
+  Simulator::Schedule (MicroSeconds (500), &YansWifiPhy::SetChannelNumber, m_phy, 6);
+  Simulator::Schedule (MilliSeconds (1), &SicaPhySensor::NotifyRxStart, &m_sensor, MilliSeconds (1));
+}
+
+void
+SicaPhySensorTestCase::CheckChannels (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_sensor.IsBusy (), false, "The last period is over");
+  NS_TEST_EXPECT_MSG_EQ (m_sensor.GetBusyTime (1), MicroSeconds (2500), "The rest of the period after the switch must not count");
+  NS_TEST_EXPECT_MSG_EQ (m_sensor.GetBusyTime (6), MilliSeconds (1), "The period must count on the new channel");
+}
+
+void
+SicaPhySensorTestCase::DoRun (void)
+{
+  m_phy = CreateObject<YansWifiPhy> ();
+  m_phy->SetChannelNumber (1);
+  m_sensor.SetPhy (m_phy);
+  NS_TEST_ASSERT_MSG_EQ (m_sensor.IsAttached (), true, "The sensor must be attached");
+  m_sensor.NotifyRxStart (MilliSeconds (1));
+  m_sensor.NotifyMaybeCcaBusyStart (MilliSeconds (2));
+  // the own transmissions are not an occupancy of the channel
+  m_sensor.NotifyTxStart (MilliSeconds (5), 16);
+  Simulator::Schedule (MilliSeconds (1), &SicaPhySensorTestCase::CheckFirstPeriod, this);
+  Simulator::Schedule (MilliSeconds (5), &SicaPhySensorTestCase::SwitchDuringRx, this);
+  Simulator::Schedule (MilliSeconds (10), &SicaPhySensorTestCase::CheckChannels, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_sensor.Detach ();
+  NS_TEST_ASSERT_MSG_EQ (m_sensor.IsAttached (), false, "The sensor must be detached");
+  NS_TEST_ASSERT_MSG_EQ (m_sensor.GetBusyTime (6), MilliSeconds (1), "The busy time must be kept after the detach");
+  m_phy = 0;
+}
+
+// Check which node keeps its switch when two neighbors switch at the same time
+class SicaSwitchCoordinationTestCase : public TestCase
+{
+public:
+  SicaSwitchCoordinationTestCase ();
+  virtual ~SicaSwitchCoordinationTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SicaSwitchCoordinationTestCase::SicaSwitchCoordinationTestCase ()
+  : TestCase ("Sica switch coordination and hold-down")
+{
+}
+
+SicaSwitchCoordinationTestCase::~SicaSwitchCoordinationTestCase ()
+{
+}
+
+void
+SicaSwitchCoordinationTestCase::DoRun (void)
+{
+  Ptr<Sica> sica = CreateObject<Sica> ();
+  sica->SetAttribute ("SwitchBackoff", TimeValue (Seconds (0)));
+  sica->m_id = 5;
+  sica->m_rChannel = 1;
+  sica->m_rNewChannel = 3;
+  SicaNeighbors *nb = sica->GetSicaNeighbors ();
+  // the neighbor 7 joins our new channel but it has a bigger Id
+  nb->Update (7, 1, 2, 2, Mac48Address ("00:00:00:00:00:07"), Mac48Address ("00:00:00:00:00:08"), Seconds (0), Seconds (10), 3);
+  // the neighbor 3 moves between two channels we do not use
+  nb->Update (3, 1, 2, 4, Mac48Address ("00:00:00:00:00:03"), Mac48Address ("00:00:00:00:00:04"), Seconds (0), Seconds (10), 6);
+  // the neighbor 1 is two hops away
+  nb->Update (1, 2, 2, 2, Mac48Address ("00:00:00:00:00:01"), Mac48Address ("00:00:00:00:00:02"), Seconds (0), Seconds (10), 3);
+  NS_TEST_ASSERT_MSG_EQ (sica->CoordinateSwitch (), Seconds (0), "The coordination is disabled by default");
+  sica->SetAttribute ("SwitchCoordination", BooleanValue (true));
+  NS_TEST_ASSERT_MSG_EQ (sica->CoordinateSwitch (), Seconds (0), "No neighbor with a lower Id has a conflicting switch");
+  NS_TEST_ASSERT_MSG_EQ (sica->GetRNewChannel (), 3, "The switch must be kept");
+  // the neighbors 2 and 4 leave our new channel, the later switch sets the backoff
+  nb->Update (2, 1, 2, 3, Mac48Address ("00:00:00:00:00:09"), Mac48Address ("00:00:00:00:00:0a"), Seconds (0), Seconds (20), 2);
+  nb->Update (4, 1, 2, 3, Mac48Address ("00:00:00:00:00:0b"), Mac48Address ("00:00:00:00:00:0c"), Seconds (0), Seconds (30), 5);
+  NS_TEST_ASSERT_MSG_EQ (sica->CoordinateSwitch (), Seconds (30), "The assignment must run again after the last conflicting switch");
+  NS_TEST_ASSERT_MSG_EQ (sica->GetRNewChannel (), 1, "The switch must be withdrawn");
+  NS_TEST_ASSERT_MSG_EQ (sica->GetSwitchDeferrals (), 1, "The withdrawal must be counted");
+  NS_TEST_ASSERT_MSG_EQ (sica->CoordinateSwitch (), Seconds (0), "Nothing is left to withdraw");
+
+  NS_TEST_ASSERT_MSG_EQ (sica->InSwitchHoldDown (), false, "The hold-down is disabled by default");
+  sica->SetAttribute ("SwitchHoldDown", TimeValue (Seconds (10)));
+  NS_TEST_ASSERT_MSG_EQ (sica->InSwitchHoldDown (), false, "The first switch is never held down");
+  sica->m_switchCount = 1;
+  sica->m_lastSwitchTime = Seconds (0);
+  NS_TEST_ASSERT_MSG_EQ (sica->InSwitchHoldDown (), true, "The node has just switched");
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (sica->InSwitchHoldDown (), false, "The hold-down is over");
+  Simulator::Destroy ();
+  sica->Dispose ();
+}
+
+// Check the repetitions of a switch announcement until the neighbors acknowledge it
+class SicaSwitchRetryTestCase : public TestCase
+{
+public:
+  SicaSwitchRetryTestCase ();
+  virtual ~SicaSwitchRetryTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Switch the R interface of the node
+  void SwitchR (void);
+  /// Count the announcements sent by the node
+  void Announced (uint32_t id, uint32_t ch, uint32_t tries, uint32_t unacked);
+  /// Check the announcement state of the node
+  void Check (uint32_t announcements, uint32_t unacked, std::string msg);
+  Ptr<Sica> m_sica;
+  uint32_t m_announcements;
+  uint32_t m_tries;
+};
+
+SicaSwitchRetryTestCase::SicaSwitchRetryTestCase ()
+  : TestCase ("Sica switch announcement retries"),
+    m_announcements (0),
+    m_tries (0)
+{
+}
+
+SicaSwitchRetryTestCase::~SicaSwitchRetryTestCase ()
+{
+}
+
+void
+SicaSwitchRetryTestCase::SwitchR (void)
+{
+  m_sica->m_rChannel = m_sica->m_rNewChannel;
+}
+
+void
+SicaSwitchRetryTestCase::Announced (uint32_t id, uint32_t ch, uint32_t tries, uint32_t unacked)
+{
+  NS_TEST_EXPECT_MSG_EQ (ch, 3, "The new channel must be announced");
+  m_announcements++;
+  m_tries = tries;
+}
+
+void
+SicaSwitchRetryTestCase::Check (uint32_t announcements, uint32_t unacked, std::string msg)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_announcements, announcements, msg);
+  NS_TEST_EXPECT_MSG_EQ (m_sica->GetSwitchUnacked (), unacked, msg);
+}
+
+void
+SicaSwitchRetryTestCase::DoRun (void)
+{
+  m_sica = CreateObject<Sica> ();
+  m_sica->SetAttribute ("SwitchAnnouncement", BooleanValue (true));
+  m_sica->SetAttribute ("SwitchAnnounceRetries", UintegerValue (2));
+  m_sica->SetAttribute ("SwitchAnnounceInterval", TimeValue (MilliSeconds (20)));
+  m_sica->TraceConnectWithoutContext ("SwitchAnnounced", MakeCallback (&SicaSwitchRetryTestCase::Announced, this));
+  m_sica->m_id = 1;
+  m_sica->m_rChannel = 1;
+  m_sica->m_rNewChannel = 3;
+  SicaNeighbors *nb = m_sica->GetSicaNeighbors ();
+  nb->Update (2, 1, 2, 1, Mac48Address ("00:00:00:00:00:02"), Mac48Address ("00:00:00:00:00:03"), Seconds (0), Seconds (0), 1);
+  nb->Update (4, 1, 2, 2, Mac48Address ("00:00:00:00:00:04"), Mac48Address ("00:00:00:00:00:05"), Seconds (0), Seconds (0), 2);
+  m_sica->m_switchAnnounceTimer.SetFunction (&Sica::SendSwitchAnnouncement, PeekPointer (m_sica));
+  m_sica->m_switchTimer.SetFunction (&SicaSwitchRetryTestCase::SwitchR, this);
+  m_sica->m_switchTimer.Schedule (Seconds (10));
+  m_sica->AnnounceSwitch ();
+  NS_TEST_ASSERT_MSG_EQ (m_announcements, 1, "The switch must be announced when it is scheduled");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetSicaQueue ()->GetSize (2, SicaQueueEntry::Hello_Type), 1, "The announcement must be sent on the channel of each neighbor");
+  // before the switch the neighbor still reaches us on the old channel
+  Simulator::Schedule (Seconds (1), &Sica::AckSwitchAnnouncement, m_sica, 2);
+  Simulator::Schedule (Seconds (9), &SicaSwitchRetryTestCase::Check, this, 1, 2, "The retries must wait for the switch");
+  Simulator::Schedule (MilliSeconds (10021), &SicaSwitchRetryTestCase::Check, this, 2, 2, "The first retry must follow the switch");
+  Simulator::Schedule (MilliSeconds (10030), &Sica::AckSwitchAnnouncement, m_sica, 2);
+  Simulator::Schedule (MilliSeconds (10031), &SicaSwitchRetryTestCase::Check, this, 2, 1, "The neighbor reached us on the new channel");
+  Simulator::Schedule (MilliSeconds (10041), &SicaSwitchRetryTestCase::Check, this, 3, 1, "The retry must go on for the other neighbor");
+  Simulator::Schedule (Seconds (11), &SicaSwitchRetryTestCase::Check, this, 3, 0, "The announcement must be given up after the last retry");
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_tries, 3, "The announcement must be repeated twice");
+  Simulator::Destroy ();
+  m_sica->Dispose ();
+  m_sica = 0;
+}
+
+// Check the interval and the count of the hellos avoided by the adaptive hello scheduler
+class SicaHelloBackoffTestCase : public TestCase
+{
+public:
+  SicaHelloBackoffTestCase ();
+  virtual ~SicaHelloBackoffTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Give the hello to the scheduler and account it as sent, return the interval until the next hello
+  Time SendHello (SicaHelloHeader hello, Time since);
+  /// Stand for Sica::CreateHello when the hello timer expires
+  void HelloTimerExpired (void);
+  Ptr<Sica> m_sica;
+};
+
+SicaHelloBackoffTestCase::SicaHelloBackoffTestCase ()
+  : TestCase ("Sica adaptive hello backoff")
+{
+}
+
+SicaHelloBackoffTestCase::~SicaHelloBackoffTestCase ()
+{
+}
+
+Time
+SicaHelloBackoffTestCase::SendHello (SicaHelloHeader hello, Time since)
+{
+  // the previous hello was sent since ago
+  m_sica->m_lastHelloTime = Simulator::Now () - since;
+  m_sica->AdaptHelloInterval (hello);
+  m_sica->m_hellosSent++;
+  m_sica->m_lastHelloTime = Simulator::Now ();
+  m_sica->m_lastHello = hello;
+  NS_TEST_EXPECT_MSG_EQ (hello.GetHelloInterval (), m_sica->m_helloTimer.GetDelay (), "The hello must carry the interval of the timer");
+  return hello.GetHelloInterval ();
+}
+
+void
+SicaHelloBackoffTestCase::HelloTimerExpired (void)
+{
+}
+
+void
+SicaHelloBackoffTestCase::DoRun (void)
+{
+  m_sica = CreateObject<Sica> ();
+  m_sica->SetAttribute ("AdaptiveHello", BooleanValue (true));
+  m_sica->SetAttribute ("MaxHelloInterval", TimeValue (Seconds (350)));
+  m_sica->m_id = 5;
+  m_sica->m_helloTimer.SetFunction (&SicaHelloBackoffTestCase::HelloTimerExpired, this);
+  Time base = m_sica->HelloInterval;
+  SicaHelloHeader hello (1, 5, Seconds (0), 2, 1, 512, 1, Mac48Address ("00:00:00:00:00:05"), Seconds (0), Seconds (0));
+  NS_TEST_ASSERT_MSG_EQ (SendHello (hello, Seconds (0)), base, "The first hello uses the base interval");
+  NS_TEST_ASSERT_MSG_EQ (SendHello (hello, base), Seconds (2 * base.GetSeconds ()), "The interval must grow while the state does not change");
+  // the backlog is not a change of the state
+  hello.SetLoad (12);
+  NS_TEST_ASSERT_MSG_EQ (SendHello (hello, Seconds (2 * base.GetSeconds ())), Seconds (350), "The interval must be bounded");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetHellosSuppressed (), 1, "One periodic hello was avoided");
+  NS_TEST_ASSERT_MSG_EQ (SendHello (hello, Seconds (350)), Seconds (350), "The interval must stay at the bound");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetHellosSuppressed (), 3, "Two more periodic hellos were avoided");
+  SicaHelloHeader moved (2, 5, Seconds (0), 2, 2, 512, 2, Mac48Address ("00:00:00:00:00:05"), Seconds (0), Seconds (0));
+  NS_TEST_ASSERT_MSG_EQ (SendHello (moved, Seconds (10)), base, "A change of the state must reset the interval");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetHellosSuppressed (), 3, "The early hello avoided nothing");
+
+  // a change right after a hello is only delayed
+  m_sica->TriggerHello ();
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_helloTimer.IsRunning (), true, "The triggered hello must be delayed");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_helloTimer.GetDelayLeft (), m_sica->m_minHelloGap, "The triggered hello must wait for the minimum gap");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetHellosSuppressed (), 3, "A delayed hello is not avoided");
+  m_sica->m_helloTimer.Cancel ();
+  Simulator::Destroy ();
+  m_sica->Dispose ();
+  m_sica = 0;
+}
+
+// Check the retransmissions of the data packets lost by the device
+class SicaRetransmitTestCase : public TestCase
+{
+public:
+  SicaRetransmitTestCase ();
+  virtual ~SicaRetransmitTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Return a data packet to the node 9 through the neighbor 7
+  Ptr<Packet> MakeData (uint8_t retries);
+  /// Hand a data packet to the T interface as Sica::DeviceSend does
+  void HandToDevice (Ptr<Packet> p);
+  /// Check the packets without feedback while the timer runs
+  void CheckInFlight (uint32_t inFlight, uint32_t retries);
+  Ptr<Sica> m_sica;
+};
+
+SicaRetransmitTestCase::SicaRetransmitTestCase ()
+  : TestCase ("Sica data retransmissions")
+{
+}
+
+SicaRetransmitTestCase::~SicaRetransmitTestCase ()
+{
+}
+
+Ptr<Packet>
+SicaRetransmitTestCase::MakeData (uint8_t retries)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  if (retries > 0)
+    p->AddPacketTag (SicaRetryTag (retries));
+  p->AddHeader (SicaHeader (1, 5, 9, 7, Seconds (0)));
+  return p;
+}
+
+void
+SicaRetransmitTestCase::HandToDevice (Ptr<Packet> p)
+{
+  m_sica->m_inFlight[std::make_pair (1u, p->GetUid ())] = std::make_pair (Simulator::Now (), p);
+  if (!m_sica->m_inFlightTimer.IsRunning ())
+    m_sica->m_inFlightTimer.Schedule (m_sica->m_txFeedbackTimeout);
+}
+
+void
+SicaRetransmitTestCase::CheckInFlight (uint32_t inFlight, uint32_t retries)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_inFlight.size (), inFlight, "Wrong number of packets without feedback");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->GetTxRetries (7), retries, "Wrong number of retransmissions");
+}
+
+void
+SicaRetransmitTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<RTable> rTable = CreateObject<RTable> ();
+  m_sica = CreateObject<Sica> ();
+  node->AggregateObject (rTable);
+  node->AggregateObject (m_sica);
+  UintegerValue maxRetries;
+  m_sica->GetAttribute ("MaxRetries", maxRetries);
+  NS_TEST_ASSERT_MSG_EQ (maxRetries.Get (), 0, "The retransmissions are disabled by default");
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (SicaRetryTag ().GetRetries ()), 0, "A new packet has no retransmission");
+  m_sica->SetAttribute ("MaxRetries", UintegerValue (1));
+  m_sica->m_id = 5;
+  m_sica->m_inFlightTimer.SetFunction (&Sica::ExpireInFlight, PeekPointer (m_sica));
+  m_sica->GetSicaNeighbors ()->Update (7, 1, 2, 3, Mac48Address ("00:00:00:00:00:07"), Mac48Address ("00:00:00:00:00:08"), Seconds (0), Seconds (0), 3);
+  rTable->AddRoute (5, 9, 7, 1);
+
+  // the feedback of the MAC is matched by the UID of the packet, not by its position
+  Ptr<Packet> first = MakeData (0);
+  Ptr<Packet> second = MakeData (0);
+  HandToDevice (first);
+  HandToDevice (second);
+  m_sica->NotifyMacTxDrop ("1", second);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_inFlight.size (), 1, "Only the dropped packet leaves");
+  NS_TEST_ASSERT_MSG_EQ (!m_sica->TakeInFlight (1, second->GetUid ()), true, "The dropped packet was taken");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetTxRetries (7), 1, "The dropped packet must be retransmitted");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_queue.GetSize (3, SicaQueueEntry::Data_Type), 1, "The packet goes back to the queue of the channel of the next hop");
+  m_sica->NotifyMacTxDrop ("0", first);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_inFlight.size (), 1, "The packet was handed to the other device");
+  m_sica->NotifyMacTxDrop ("1", Create<Packet> (100));
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetTxRetries (7), 1, "The MAC dropped a packet we did not keep");
+
+  // the packet is dropped after the last retransmission
+  Ptr<Packet> retried = MakeData (1);
+  HandToDevice (retried);
+  m_sica->NotifyMacTxDrop ("1", retried);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetTxDrops (7), 1, "The packet must be dropped after the retransmissions");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetTxRetries (7), 1, "The dropped packet is not retransmitted");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_queue.GetSize (3, SicaQueueEntry::Data_Type), 1, "The dropped packet does not go back to the queue");
+
+  // the packets dropped silently by the MAC are retransmitted after the feedback timeout
+  Simulator::Schedule (MilliSeconds (500), &SicaRetransmitTestCase::HandToDevice, this, MakeData (0));
+  Simulator::Schedule (MilliSeconds (1200), &SicaRetransmitTestCase::CheckInFlight, this, 1, 2);
+  Simulator::Schedule (MilliSeconds (1600), &SicaRetransmitTestCase::CheckInFlight, this, 0, 3);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_inFlightTimer.IsRunning (), false, "No packet waits for feedback");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_queue.GetSize (3, SicaQueueEntry::Data_Type), 3, "Wrong number of retransmitted packets");
+  Simulator::Destroy ();
+  m_sica->Dispose ();
+  m_sica = 0;
+}
+
+// Check the backpressure of the devices on the sending of the interfaces
+class SicaBackpressureTestCase : public TestCase
+{
+public:
+  SicaBackpressureTestCase ();
+  virtual ~SicaBackpressureTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Return a WiFi device without MAC tuned to a channel
+  static Ptr<WifiNetDevice> MakeDevice (uint32_t ifIndex, uint32_t ch);
+  /// Stand for the end of the send period of the T interface and the switch of the R interface
+  void TimerExpired (void);
+  Ptr<Sica> m_sica;
+};
+
+SicaBackpressureTestCase::SicaBackpressureTestCase ()
+  : TestCase ("Sica device backpressure")
+{
+}
+
+SicaBackpressureTestCase::~SicaBackpressureTestCase ()
+{
+}
+
+Ptr<WifiNetDevice>
+SicaBackpressureTestCase::MakeDevice (uint32_t ifIndex, uint32_t ch)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetChannelNumber (ch);
+  Ptr<WifiNetDevice> device = CreateObject<WifiNetDevice> ();
+  device->SetIfIndex (ifIndex);
+  device->SetPhy (phy);
+  return device;
+}
+
+void
+SicaBackpressureTestCase::TimerExpired (void)
+{
+}
+
+void
+SicaBackpressureTestCase::DoRun (void)
+{
+  m_sica = CreateObject<Sica> ();
+  m_sica->SetAttribute ("MacBackpressure", BooleanValue (true));
+  m_sica->m_id = 5;
+  m_sica->m_rChannel = 1;
+  m_sica->m_rInterface = MakeDevice (0, 1);
+  m_sica->m_tInterface = MakeDevice (1, 3);
+  m_sica->m_rMacQueue = CreateObject<WifiMacQueue> ();
+  m_sica->m_tMacQueue = CreateObject<WifiMacQueue> ();
+  ChannelEmuContainer emus;
+  uint32_t channels[2] = {1, 3};
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      Ptr<ChannelEmu> emu = CreateObject<ChannelEmu> ();
+      emu->SetChannelNumber (channels[k]);
+      emus.Add (emu);
+    }
+  m_sica->SetChannelsEmulationObject (emus);
+  m_sica->m_TInterfaceSendTimer.SetFunction (&SicaBackpressureTestCase::TimerExpired, this);
+  m_sica->m_switchTimer.SetFunction (&SicaBackpressureTestCase::TimerExpired, this);
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  hdr.SetAddr1 (Mac48Address ("00:00:00:00:00:07"));
+  Ptr<Packet> frame = Create<Packet> (1000);
+  frame->AddHeader (hdr);
+  WifiMacHeader ack;
+  ack.SetType (WIFI_MAC_CTL_ACK);
+  ack.SetAddr1 (Mac48Address ("00:00:00:00:00:07"));
+  Ptr<Packet> ackFrame = Create<Packet> ();
+  ackFrame->AddHeader (ack);
+  Time tx = m_sica->EstimateTxDuration (1054, m_sica->m_tInterface->GetObject<WifiNetDevice> ()->GetPhy ());
+
+  // the T interface stays two frames and a half on the channel
+  m_sica->m_TInterfaceSendTimer.Schedule (NanoSeconds (tx.GetNanoSeconds () * 5 / 2));
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetDeviceBacklog (m_sica->m_tInterface), 0, "The device holds no frame");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->TInterfaceAcceptsFrame (3, tx), true, "The frame ends before the interface leaves the channel");
+  m_sica->m_tMacQueue->Enqueue (Create<Packet> (1000), hdr);
+  m_sica->NotifyPhyTxBegin ("1", ackFrame);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetDeviceBacklog (m_sica->m_tInterface), 1, "An acknowledgment is not a frame of the device");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->TInterfaceAcceptsFrame (3, tx), true, "The frame ends after the queued frame");
+  // the frame in transmission has left the queue of the MAC
+  m_sica->NotifyPhyTxBegin ("1", frame);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetDeviceBacklog (m_sica->m_tInterface), 2, "The frame in transmission must be counted");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->TInterfaceAcceptsFrame (3, tx), false, "The frame would end after the interface left the channel");
+  // a packet kept for retransmission is not a frame of the device
+  m_sica->m_inFlight[std::make_pair (1u, frame->GetUid ())] = std::make_pair (Simulator::Now (), frame);
+  m_sica->NotifyMacTxOk ("1", hdr);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_inFlight.empty (), true, "The acknowledged packet is released");
+  m_sica->m_inFlight[std::make_pair (1u, frame->GetUid () + 1)] = std::make_pair (Simulator::Now (), frame);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetDeviceBacklog (m_sica->m_tInterface), 1, "The acknowledged frame left the device");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->TInterfaceAcceptsFrame (3, tx), true, "The frame ends before the interface leaves the channel");
+  m_sica->m_inFlight.clear ();
+  // a QoS MAC queues the data frames by access category
+  Ptr<WifiMacQueue> voQueue = CreateObject<WifiMacQueue> ();
+  m_sica->m_tEdcaQueues.push_back (voQueue);
+  voQueue->Enqueue (Create<Packet> (1000), hdr);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetDeviceBacklog (m_sica->m_tInterface), 2, "The frames of the access categories must be counted");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->TInterfaceAcceptsFrame (3, tx), false, "The frame would end after the interface left the channel");
+  voQueue->Flush ();
+
+  // the R interface refuses the frames over the maximum backlog
+  for (uint32_t k = 0; k < 3; ++k)
+    m_sica->m_rMacQueue->Enqueue (Create<Packet> (1000), hdr);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->RInterfaceAcceptsFrame (tx), true, "Three frames wait in the device");
+  m_sica->NotifyPhyTxBegin ("0", frame);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->RInterfaceAcceptsFrame (tx), false, "The device holds the maximum backlog");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->GetDeviceBacklog (m_sica->m_tInterface), 1, "The frames of the R interface are not on the T interface");
+  m_sica->NotifyMacTxErr ("0", hdr);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->RInterfaceAcceptsFrame (tx), true, "The failed frame left the device");
+  m_sica->m_switchTimer.Schedule (NanoSeconds (tx.GetNanoSeconds () * 5 / 2));
+  NS_TEST_ASSERT_MSG_EQ (m_sica->RInterfaceAcceptsFrame (tx), false, "The frame would end after the switch of the R interface");
+  m_sica->m_switchTimer.Cancel ();
+
+  // the T interface waits for the device and resumes at the end of a frame
+  for (uint32_t k = 0; k < 3; ++k)
+    m_sica->m_tMacQueue->Enqueue (Create<Packet> (1000), hdr);
+  Ptr<Packet> data = Create<Packet> (100);
+  data->AddHeader (SicaHeader (1, 5, 9, 7, Seconds (0)));
+  SicaQueueEntry entry (data, SicaQueueEntry::Data_Type);
+  entry.SetExpireTime (Seconds (10));
+  m_sica->m_queue.Enqueue (3, &entry);
+  m_sica->TInterfaceSend (3);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_tBackpressureChannel, 3, "The T interface must wait for the device");
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_queue.GetSize (3, SicaQueueEntry::Data_Type), 1, "The packet must stay in the queue");
+  m_sica->NotifyDeviceTxEnd (1);
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_tBackpressureChannel, 0, "The end of a frame releases the wait");
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_tBackpressureChannel, 3, "The T interface must try again at the end of the frame");
+  // the T interface left the channel it waited on
+  m_sica->m_tBackpressureChannel = 4;
+  m_sica->NotifyDeviceTxEnd (1);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_sica->m_tBackpressureChannel, 0, "The T interface must not resume on another channel");
+  Simulator::Destroy ();
+  m_sica->Dispose ();
+  m_sica = 0;
+}
+
+// Check the rendezvous windows over the common control channel
+class SicaRendezvousTestCase : public TestCase
+{
+public:
+  SicaRendezvousTestCase ();
+  virtual ~SicaRendezvousTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Start the rendezvous out of the period and check the windows and the gating of the interfaces
+  void CheckRendezvous (void);
+  /// Stand for the end of the send period of the T interface
+  void TimerExpired (void);
+  Ptr<Sica> m_sica;
+};
+
+SicaRendezvousTestCase::SicaRendezvousTestCase ()
+  : TestCase ("Sica rendezvous over the control channel")
+{
+}
+
+SicaRendezvousTestCase::~SicaRendezvousTestCase ()
+{
+}
+
+void
+SicaRendezvousTestCase::TimerExpired (void)
+{
+}
+
+void
+SicaRendezvousTestCase::CheckRendezvous (void)
+{
+  // the first window is aligned on the simulation time and the window is at most half of the period
+  m_sica->InitializeRendezvous ();
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_rendezvousTimer.GetDelayLeft (), MilliSeconds (700), "The window must start on a multiple of the period");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_rendezvousWindow, MilliSeconds (500), "The window must be at most half of the period");
+  m_sica->m_rendezvousWindow = MilliSeconds (100);
+
+  // the earliest window wins
+  m_sica->AlignRendezvous (MilliSeconds (900));
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_rendezvousTimer.GetDelayLeft (), MilliSeconds (700), "A later window must not delay ours");
+  m_sica->AlignRendezvous (MilliSeconds (680));
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_rendezvousTimer.GetDelayLeft (), MilliSeconds (700), "A small offset is absorbed by the window");
+  m_sica->AlignRendezvous (MilliSeconds (-200));
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_rendezvousTimer.GetDelayLeft (), MilliSeconds (700), "A past window is ignored");
+  m_sica->AlignRendezvous (MilliSeconds (400));
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_rendezvousTimer.GetDelayLeft (), MilliSeconds (400), "An earlier window must advance ours");
+
+  // the data channels are refused during the window and for a frame which would end in it
+  Time tx = MilliSeconds (1);
+  NS_TEST_EXPECT_MSG_EQ (m_sica->TInterfaceReadyToSend (3, tx), true, "The frame ends before the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->TInterfaceReadyToSend (3, MilliSeconds (450)), false, "The frame would end in the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->TInterfaceReadyToSend (6, MilliSeconds (450)), true, "The control channel is not refused");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->RInterfaceReadyToSend (tx), true, "The frame ends before the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->RInterfaceReadyToSend (MilliSeconds (450)), false, "The R interface leaves for the window");
+
+  // outside the window the hellos, the switch announcements and the control queue wait
+  m_sica->CreateHello ();
+  NS_TEST_EXPECT_MSG_EQ (m_sica->GetHellosSent (), 0, "No hello outside the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_helloTimer.IsRunning (), false, "The hellos are sent by the windows");
+  m_sica->m_switchUnacked.insert (7);
+  m_sica->SendSwitchAnnouncement ();
+  NS_TEST_EXPECT_MSG_EQ (m_sica->m_switchAnnounceTries, 0, "No switch announcement outside the window");
+  SicaQueueEntry hello (Create<Packet> (10), SicaQueueEntry::Hello_Type);
+  hello.SetExpireTime (Seconds (1));
+  m_sica->m_queue.Enqueue (6, &hello);
+  NS_TEST_EXPECT_MSG_EQ (m_sica->GetControlQueueSize (6), 0, "The control packets wait for the window");
+
+  m_sica->m_inRendezvous = true;
+  NS_TEST_EXPECT_MSG_EQ (m_sica->GetControlQueueSize (6), 1, "The control packets are sent in the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->GetControlQueueSize (3), 0, "The control packets are sent only over the control channel");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->TInterfaceReadyToSend (3, tx), false, "The data channels are left during the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->TInterfaceReadyToSend (6, tx), true, "The control channel is used during the window");
+  NS_TEST_EXPECT_MSG_EQ (m_sica->RInterfaceReadyToSend (tx), false, "The R interface listens to the control channel");
+  m_sica->m_inRendezvous = false;
+  m_sica->m_switchUnacked.clear ();
+  m_sica->m_rendezvousTimer.Cancel ();
+  m_sica->m_TInterfaceSendTimer.Cancel ();
+}
+
+void
+SicaRendezvousTestCase::DoRun (void)
+{
+  m_sica = CreateObject<Sica> ();
+  m_sica->SetAttribute ("ControlChannel", UintegerValue (6));
+  m_sica->SetAttribute ("RendezvousPeriod", TimeValue (Seconds (1)));
+  m_sica->SetAttribute ("RendezvousWindow", TimeValue (MilliSeconds (800)));
+  m_sica->m_id = 5;
+  m_sica->m_rChannel = 1;
+  Ptr<YansWifiPhy> phys[2];
+  Ptr<WifiNetDevice> devices[2];
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      phys[k] = CreateObject<YansWifiPhy> ();
+      phys[k]->SetChannelNumber (k == 0 ? 1 : 3);
+      devices[k] = CreateObject<WifiNetDevice> ();
+      devices[k]->SetIfIndex (k);
+      devices[k]->SetPhy (phys[k]);
+    }
+  m_sica->m_rInterface = devices[0];
+  m_sica->m_tInterface = devices[1];
+  ChannelEmuContainer emus;
+  uint32_t channels[3] = {1, 3, 6};
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Ptr<ChannelEmu> emu = CreateObject<ChannelEmu> ();
+      emu->SetChannelNumber (channels[k]);
+      emus.Add (emu);
+    }
+  m_sica->SetChannelsEmulationObject (emus);
+  m_sica->m_TInterfaceSendTimer.SetFunction (&SicaRendezvousTestCase::TimerExpired, this);
+  m_sica->m_TInterfaceSendTimer.Schedule (Seconds (2));
+  Simulator::Schedule (MilliSeconds (300), &SicaRendezvousTestCase::CheckRendezvous, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_sica->Dispose ();
+  m_sica = 0;
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +1921,34 @@ SicaTestSuite::SicaTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new SicaTestCase1, TestCase::QUICK);
+  AddTestCase (new SicaAdjacentChannelTestCase, TestCase::QUICK);
+  AddTestCase (new SicaBxEstimatorTestCase, TestCase::QUICK);
+  AddTestCase (new SicaStaleChannelTestCase, TestCase::QUICK);
+  AddTestCase (new SicaSenseWindowTestCase, TestCase::QUICK);
+  AddTestCase (new SicaChannelWeightTestCase, TestCase::QUICK);
+  AddTestCase (new SicaChannelSamplerTestCase, TestCase::QUICK);
+  AddTestCase (new SicaChannelStrategyTestCase, TestCase::QUICK);
+  AddTestCase (new SicaConvergenceTestCase, TestCase::QUICK);
+  AddTestCase (new SicaLoadTermsTestCase, TestCase::QUICK);
+  AddTestCase (new SicaInterferenceGraphTestCase, TestCase::QUICK);
+  AddTestCase (new SicaChannelOracleTestCase, TestCase::QUICK);
+  AddTestCase (new SicaShuffleDataTestCase, TestCase::QUICK);
+  AddTestCase (new SicaTransmitHoldTestCase, TestCase::QUICK);
+  AddTestCase (new SicaSwitchAnnouncementTestCase, TestCase::QUICK);
+  AddTestCase (new SicaHelloDeltaTestCase, TestCase::QUICK);
+  AddTestCase (new SicaAdaptiveHelloTestCase, TestCase::QUICK);
+  AddTestCase (new SicaCompactHelloTestCase, TestCase::QUICK);
+  AddTestCase (new SicaHelloPartsTestCase, TestCase::QUICK);
+  AddTestCase (new SicaStateTrailerTestCase, TestCase::QUICK);
+  AddTestCase (new SicaLinkQualityTestCase, TestCase::QUICK);
+  AddTestCase (new SicaTrafficClassTestCase, TestCase::QUICK);
+  AddTestCase (new SicaPhySensorTestCase, TestCase::QUICK);
+  AddTestCase (new SicaSwitchCoordinationTestCase, TestCase::QUICK);
+  AddTestCase (new SicaSwitchRetryTestCase, TestCase::QUICK);
+  AddTestCase (new SicaHelloBackoffTestCase, TestCase::QUICK);
+  AddTestCase (new SicaRetransmitTestCase, TestCase::QUICK);
+  AddTestCase (new SicaBackpressureTestCase, TestCase::QUICK);
+  AddTestCase (new SicaRendezvousTestCase, TestCase::QUICK);
   // AddTestCase (new SicaTestCase1); // ns-3.14
 }
 